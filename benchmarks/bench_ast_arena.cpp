@@ -0,0 +1,80 @@
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <iostream>
+
+#include "benchmarks/bench_utils.h"
+#include "src/parser.hpp"
+#include "src/ast_visitor.h"
+
+/*
+ * Building and tearing down an AST with every node malloced on its own against the bump allocating arena.
+ * Each allocation strategy runs in its own process so peak RSS isn't shared between them.
+ * usage: bench_ast_arena [megabytes of synthetic source]
+ */
+
+std::string statement_source(size_t target_bytes) {
+    std::string source;
+    source.reserve(target_bytes + 128);
+    for (size_t line = 0; source.size() < target_bytes; ++line) {
+        std::string suffix = std::to_string(line % 1000);
+        source += "value_" + suffix + " = compute(a + b * " + suffix + ", c - d, nested(e / 2, 'x'), f % 3) + g;\n";
+    }
+    return source;
+}
+
+size_t count_nodes(const ASTNode *root) {
+    struct {
+        size_t m_count = 0;
+
+        void enter(const TreeNode &) { ++m_count; }
+    } counter;
+    walk(TreeNode(root), counter);
+    return counter.m_count;
+}
+
+void run(const char *name, const TokenStream &tokens, std::pmr::memory_resource *node_resource) {
+    size_t rss_before = peak_rss_kilobytes();
+    auto parser = node_resource ? std::make_unique<Parser>(node_resource) : std::make_unique<Parser>();
+
+    Stopwatch parse_time;
+    size_t nodes = 0;
+    auto end = tokens.end();
+    for (auto it = tokens.begin(); it < end;) {
+        nodes += count_nodes(*parser->parse_statement(it, end));
+    }
+    double parse_seconds = parse_time.seconds();
+    size_t rss_after = peak_rss_kilobytes();
+
+    Stopwatch teardown_time;
+    parser.reset();
+    double teardown_seconds = teardown_time.seconds();
+
+    std::cout << name << ": " << nodes << " nodes, " << nodes / parse_seconds / 1e6 << " M nodes/sec, teardown "
+              << teardown_seconds * 1e3 << " ms, peak RSS +" << (rss_after - rss_before) / 1024 << " MB"
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    warn_if_debug_build();
+    auto source = SourceBuffer::from_string(statement_source(megabytes_argument(argc, argv, 32)));
+    Lexer lexer;
+    auto tokens = lexer.lex_stream(source);
+    std::cout << "source: " << source->size() / (1024 * 1024) << " MB, " << tokens.size() << " tokens" << std::endl;
+
+    for (bool arena: {false, true}) {
+        std::cout.flush();
+        pid_t child = fork();
+        if (child == 0) {
+            if (arena) {
+                run("arena         ", tokens, nullptr);
+            } else {
+                run("node by node  ", tokens, std::pmr::new_delete_resource());
+            }
+            std::cout.flush();
+            _exit(0);
+        }
+        waitpid(child, nullptr, 0);
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include <unistd.h>
+
+#include <filesystem>
+#include <iostream>
+
+#include "benchmarks/bench_utils.h"
+#include "src/ast_cache.h"
+#include "src/constant_folder.h"
+#include "src/ir_builder.h"
+#include "src/parser.hpp"
+
+/*
+ * What the compiler does with a source on a cache miss, every pass and the store of the entry, against a hit,
+ * which maps the entry and is done. The source has to compile without errors, entries are only stored then.
+ * usage: bench_ast_cache [megabytes]
+ */
+
+// functions calling the one before them, every name declared and every type matching
+std::string clean_source(size_t target_bytes) {
+    std::string source = "int step_0(int a, char *b) { return a; }\n";
+    for (size_t index = 1; source.size() < target_bytes; ++index) {
+        std::string suffix = std::to_string(index);
+        std::string previous = std::to_string(index - 1);
+        source += "int step_" + suffix + "(int a, char *b) {\n"
+                  "    int count_" + suffix + " = a * 2 + 1;\n"
+                  "    while (count_" + suffix + " > 0) {\n"
+                  "        count_" + suffix + " = count_" + suffix + " - 1;\n"
+                  "        if (b[count_" + suffix + "] == 'x' && a != 3) {\n"
+                  "            return count_" + suffix + ";\n"
+                  "        }\n"
+                  "    }\n"
+                  "    return step_" + previous + "(a + 4 * 2, b) % 7;\n"
+                  "}\n";
+    }
+    return source;
+}
+
+// the passes main runs and the entry it stores, false when the source had errors
+bool compile_and_store(const std::shared_ptr<const SourceBuffer> &source, const AstCache &cache) {
+    Lexer lexer;
+    TokenStream tokens = lexer.lex_stream(source);
+    Parser parser;
+    auto it = tokens.begin();
+    NodeList declarations = parser.parse_translation_unit(it, tokens.end());
+    NameResolver resolver;
+    resolver.resolve(declarations, source.get());
+    TypeChecker checker(resolver);
+    checker.check(declarations);
+    ConstantFolder folder;
+    folder.fold(declarations, source.get());
+    if (!lexer.diagnostics().empty() || !parser.diagnostics().empty() || !resolver.diagnostics().empty() ||
+        !checker.diagnostics().empty() || !folder.diagnostics().empty()) {
+        return false;
+    }
+    IrBuilder builder(resolver, checker);
+    builder.lower(declarations);
+
+    FlatAst ast;
+    for (const ASTNode *declaration: declarations) {
+        ast.add_tree(declaration);
+    }
+    return cache.store(source->view(), tokens, ast);
+}
+
+int main(int argc, char **argv) {
+    warn_if_debug_build();
+    auto source = SourceBuffer::from_string(clean_source(megabytes_argument(argc, argv, 16)));
+    std::filesystem::path directory =
+            std::filesystem::temp_directory_path() / ("bench_ast_cache_" + std::to_string(::getpid()));
+    AstCache cache(directory);
+
+    Stopwatch miss_watch;
+    if (!cache.load(source->view()) && !compile_and_store(source, cache)) {
+        std::cerr << "benchmark source didn't compile cleanly" << std::endl;
+        return 1;
+    }
+    double miss_seconds = miss_watch.seconds();
+
+    Stopwatch hit_watch;
+    auto mapped = cache.load(source->view());
+    double hit_seconds = hit_watch.seconds();
+    std::filesystem::remove_all(directory);
+    if (!mapped) {
+        std::cerr << "entry wasn't stored" << std::endl;
+        return 1;
+    }
+
+    std::cout << source->size() / (1024 * 1024) << " MB, " << mapped->size() << " nodes\n"
+              << "  miss: " << miss_seconds << " s\n"
+              << "  hit:  " << hit_seconds << " s (" << miss_seconds / hit_seconds << "x faster)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+
+#include "benchmarks/bench_utils.h"
+#include "src/dataflow.h"
+#include "src/ir_builder.h"
+#include "src/parser.hpp"
+#include "src/type_checker.h"
+
+/*
+ * Liveness and reaching definitions time on large synthetic control flow graphs, lowered from generated
+ * functions: a loop around a long run of if/else diamonds over a handful of variables, and loops nested
+ * deeply enough that facts have to travel around many back edges.
+ * Visits per block count transfer functions applied, 1 would be a single pass.
+ * The scale runs double the diamonds in values twice: peak RSS should grow with blocks times values through
+ * the in and out sets only, the gen and kill lists staying in proportion to the instructions.
+ * usage: bench_dataflow [diamond count]
+ */
+
+constexpr size_t VARIABLE_COUNT = 16;
+
+// the variables live in memory when their address is taken, which gives reaching definitions stores to track
+std::string diamonds(size_t diamond_count, bool in_memory) {
+    std::string source = "int f(int a, int b) {\n";
+    for (size_t variable = 0; variable < VARIABLE_COUNT; ++variable) {
+        source += "  int v" + std::to_string(variable) + " = a + " + std::to_string(variable) + ";\n";
+        if (in_memory) {
+            source += "  int *p" + std::to_string(variable) + " = &v" + std::to_string(variable) + ";\n";
+        }
+    }
+    source += "  while (a < b) {\n";
+    for (size_t index = 0; index < diamond_count; ++index) {
+        std::string first = "v" + std::to_string(index % VARIABLE_COUNT);
+        std::string second = "v" + std::to_string(index * 7 % VARIABLE_COUNT);
+        source += "    if (" + first + " > " + std::to_string(index) + ") { " + first + " = " + second +
+                  " - b; } else { " + second + " = " + first + " + a; }\n";
+    }
+    source += "    a = a + 1;\n  }\n  return a";
+    for (size_t variable = 0; variable < VARIABLE_COUNT; ++variable) {
+        source += " + v" + std::to_string(variable);
+    }
+    return source + ";\n}\n";
+}
+
+std::string nested_loops(size_t depth) {
+    std::string source = "int f(int a, int b) {\n  int c = 0;\n";
+    for (size_t level = 0; level < depth; ++level) {
+        source += "while (a > " + std::to_string(level) + ") { c = c + b; ";
+    }
+    source += "a = a - c;";
+    for (size_t level = 0; level < depth; ++level) {
+        source += " b = b - 1; }";
+    }
+    return source + "\n  return a + b + c;\n}\n";
+}
+
+IrFunction lower(const std::string &source) {
+    Lexer lexer;
+    auto tokens = lexer.lex_stream(SourceBuffer::from_string(source));
+    Parser parser;
+    auto it = tokens.begin();
+    auto declarations = parser.parse_translation_unit(it, tokens.end());
+    NameResolver resolver;
+    resolver.resolve(declarations);
+    TypeChecker checker(resolver);
+    checker.check(declarations);
+    IrBuilder builder(resolver, checker);
+    return std::move(builder.lower(declarations).back());
+}
+
+void run(const char *name, const std::string &source) {
+    IrFunction function = lower(source);
+    double blocks = function.block_count();
+
+    Stopwatch liveness_watch;
+    Liveness liveness = live_values(function);
+    double liveness_seconds = liveness_watch.seconds();
+
+    Stopwatch reaching_watch;
+    ReachingDefinitions reaching = reaching_definitions(function);
+    double reaching_seconds = reaching_watch.seconds();
+
+    std::cout << name << ": " << function.block_count() << " blocks, " << function.size() << " instructions\n"
+              << "  liveness:             " << liveness.m_values.size() << " values, "
+              << liveness.m_visits / blocks << " visits/block, " << liveness_seconds * 1e9 / blocks
+              << " ns/block\n"
+              << "  reaching definitions: " << reaching.m_definitions.size() << " stores, "
+              << reaching.m_visits / blocks << " visits/block, " << reaching_seconds * 1e9 / blocks
+              << " ns/block\n"
+              << "  peak RSS so far:      " << peak_rss_kilobytes() / 1024 << " MB" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    warn_if_debug_build();
+    size_t diamond_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+    run("diamonds in values", diamonds(diamond_count, false));
+    run("diamonds in memory", diamonds(diamond_count, true));
+    run("nested loops", nested_loops(diamond_count / 10));
+    for (size_t scale = 2; scale <= 4; scale *= 2) {
+        run(("scale x" + std::to_string(scale)).c_str(), diamonds(diamond_count * scale, false));
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <iostream>
+
+#include "benchmarks/bench_utils.h"
+#include "src/lexer.h"
+
+/*
+ * Lexing throughput of the lexer cores and scan kernels on tests/hello_world.c style input,
+ * and on input dominated by long identifiers, comments and string literals.
+ * usage: bench_lexer [megabytes of synthetic source]
+ */
+
+double lex_seconds(LEXER_CORE core, const std::shared_ptr<const SourceBuffer> &source, size_t &token_count) {
+    Lexer lexer(core);
+    Stopwatch stopwatch;
+    auto stream = lexer.lex_stream(source);
+    double seconds = stopwatch.seconds();
+    token_count = stream.size();
+    return seconds;
+}
+
+std::string long_span_source(size_t target_bytes) {
+    std::string source;
+    for (size_t line = 0; source.size() < target_bytes; ++line) {
+        source += "    print(\"a fairly long string literal of the kind found in log and error messages\");\n"
+                  "    // a comment explaining the next statement in more words than strictly necessary\n"
+                  "    int an_unusually_descriptive_variable_name_" + std::to_string(line % 1000) +
+                  " = another_rather_long_identifier_for_a_value;\n";
+    }
+    return source;
+}
+
+void run(const char *name, const std::shared_ptr<const SourceBuffer> &source) {
+    std::cout << name << ": " << source->size() / (1024 * 1024) << " MB" << std::endl;
+    double cascade_seconds = 0;
+    for (auto level: {SIMD_LEVEL::SCALAR, SIMD_LEVEL::SSE42, SIMD_LEVEL::AVX2}) {
+        set_simd_level(level);
+        for (auto core: {LEXER_CORE::CASCADE, LEXER_CORE::DFA}) {
+            size_t token_count = 0;
+            double seconds = lex_seconds(core, source, token_count);
+            std::cout << "  " << (core == LEXER_CORE::DFA ? "dfa     " : "cascade ") << simd_level_name(simd_level())
+                      << ": " << token_count / seconds / 1e6 << " M tokens/sec, "
+                      << source->size() / seconds / (1024 * 1024) << " MB/sec";
+            if (level == SIMD_LEVEL::SCALAR && core == LEXER_CORE::CASCADE) {
+                cascade_seconds = seconds;
+            } else {
+                std::cout << " (" << cascade_seconds / seconds << "x scalar cascade)";
+            }
+            std::cout << std::endl;
+        }
+    }
+    set_simd_level(best_simd_level());
+
+    Lexer lexer;
+    Stopwatch stopwatch;
+    auto stream = lexer.lex_stream_parallel(source);
+    double seconds = stopwatch.seconds();
+    std::cout << "  dfa parallel (" << ThreadPool::shared().thread_count() << " threads): "
+              << stream.size() / seconds / 1e6 << " M tokens/sec, "
+              << source->size() / seconds / (1024 * 1024) << " MB/sec ("
+              << cascade_seconds / seconds << "x scalar cascade)" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    warn_if_debug_build();
+    size_t source_bytes = megabytes_argument(argc, argv, 100);
+    run("hello_world style", SourceBuffer::from_string(synthetic_source(source_bytes)));
+    run("long spans", SourceBuffer::from_string(long_span_source(source_bytes)));
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <iostream>
+
+#include "benchmarks/bench_utils.h"
+#include "src/parser.hpp"
+
+/*
+ * Translation unit parsing time: serial, signatures only with lazy bodies, and bodies parsed on pools
+ * of growing size.
+ * usage: bench_parallel_parse [megabytes of synthetic source]
+ */
+
+int main(int argc, char **argv) {
+    warn_if_debug_build();
+    Lexer lexer;
+    auto tokens = lexer.lex_stream(SourceBuffer::from_string(synthetic_source(megabytes_argument(argc, argv, 32))));
+
+    {
+        Parser parser;
+        Stopwatch stopwatch;
+        auto it = tokens.begin();
+        size_t function_count = parser.parse_translation_unit(it, tokens.end()).size();
+        std::cout << "serial: " << function_count << " functions, " << tokens.size() << " tokens, "
+                  << stopwatch.seconds() * 1e9 / tokens.size() << " ns/token" << std::endl;
+    }
+
+    {
+        Parser parser;
+        Stopwatch stopwatch;
+        size_t function_count = parser.parse_translation_unit_lazy(tokens).size();
+        std::cout << "lazy bodies: " << function_count << " functions, "
+                  << stopwatch.seconds() * 1e9 / tokens.size() << " ns/token" << std::endl;
+    }
+
+    for (size_t thread_count = 1; thread_count <= std::max(std::thread::hardware_concurrency(), 1u); thread_count *= 2) {
+        ThreadPool pool(thread_count);
+        Parser parser;
+        Stopwatch stopwatch;
+        size_t function_count = parser.parse_translation_unit_parallel(tokens, pool).size();
+        std::cout << "parallel (" << thread_count << " threads): " << function_count << " functions, "
+                  << stopwatch.seconds() * 1e9 / tokens.size() << " ns/token" << std::endl;
+    }
+    return 0;
+}
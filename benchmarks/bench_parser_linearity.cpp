@@ -0,0 +1,52 @@
+#include <iostream>
+
+#include "benchmarks/bench_utils.h"
+#include "src/parser.hpp"
+
+/*
+ * Statement parsing time per token as statements and argument lists grow.
+ * A linear parser keeps ns/token flat from the shortest to the longest statements.
+ * usage: bench_parser_linearity [megabytes of synthetic source per size]
+ */
+
+// one statement of each kind with `length` arguments / operands
+std::string long_statements(size_t length) {
+    std::string call = "f(";
+    std::string expression = "x = a0";
+    std::string declaration = "int g(";
+    for (size_t index = 0; index < length; ++index) {
+        std::string suffix = std::to_string(index);
+        call += (index ? ", a" : "a") + suffix + " * 2";
+        expression += (index % 2 ? " + a" : " * a") + suffix;
+        declaration += (index ? ", int p" : "int p") + suffix;
+    }
+    return call + ");\n" + expression + ";\n" + declaration + ");\nint y = " + expression.substr(4) + ";\n";
+}
+
+int main(int argc, char **argv) {
+    warn_if_debug_build();
+    size_t target_bytes = megabytes_argument(argc, argv, 8);
+    Lexer lexer;
+
+    for (size_t length = 4; length <= (1 << 16); length *= 4) {
+        std::string statements = long_statements(length);
+        std::string text;
+        text.reserve(target_bytes + statements.size());
+        while (text.size() < target_bytes) {
+            text += statements;
+        }
+        auto tokens = lexer.lex_stream(SourceBuffer::from_string(std::move(text)));
+
+        Parser parser;
+        Stopwatch stopwatch;
+        size_t statement_count = 0;
+        auto end = tokens.end();
+        for (auto it = tokens.begin(); it < end; ++statement_count) {
+            parser.parse_statement(it, end);
+        }
+        double seconds = stopwatch.seconds();
+        std::cout << "length " << length << ": " << statement_count << " statements, " << tokens.size() << " tokens, "
+                  << seconds * 1e9 / tokens.size() << " ns/token" << std::endl;
+    }
+    return 0;
+}
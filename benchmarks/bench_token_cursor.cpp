@@ -0,0 +1,47 @@
+#include <iostream>
+
+#include "benchmarks/bench_utils.h"
+#include "src/token_cursor.h"
+
+/*
+ * Token memory and throughput of walking a fully lexed TokenStream against the windowed TokenCursor.
+ * The cursor runs first so the peak RSS it reports isn't inflated by the stream.
+ * usage: bench_token_cursor [megabytes of synthetic source]
+ */
+
+int main(int argc, char **argv) {
+    warn_if_debug_build();
+    auto source = SourceBuffer::from_string(synthetic_source(megabytes_argument(argc, argv, 100)));
+    std::cout << "source: " << source->size() / (1024 * 1024) << " MB, peak RSS "
+              << peak_rss_kilobytes() / 1024 << " MB" << std::endl;
+
+    Stopwatch cursor_time;
+    TokenCursor cursor(source);
+    size_t cursor_identifiers = 0;
+    auto end = cursor.end();
+    for (auto it = cursor.begin(); it < end; ++it) {
+        cursor_identifiers += it->m_type == TOKEN_TYPE::IDENTIFIER;
+    }
+    double cursor_seconds = cursor_time.seconds();
+    std::cout << "TokenCursor: " << cursor.memory_usage() / 1024 << " KB of tokens, peak RSS "
+              << peak_rss_kilobytes() / 1024 << " MB, "
+              << cursor.lexed_count() / cursor_seconds / 1e6 << " M tokens/sec" << std::endl;
+
+    Stopwatch stream_time;
+    Lexer lexer;
+    auto stream = lexer.lex_stream(source);
+    size_t stream_identifiers = 0;
+    for (auto it = stream.begin(); it < stream.end(); ++it) {
+        stream_identifiers += it->m_type == TOKEN_TYPE::IDENTIFIER;
+    }
+    double stream_seconds = stream_time.seconds();
+    std::cout << "TokenStream: " << stream.memory_usage() / 1024 << " KB of tokens, peak RSS "
+              << peak_rss_kilobytes() / 1024 << " MB, "
+              << stream.size() / stream_seconds / 1e6 << " M tokens/sec" << std::endl;
+
+    if (cursor_identifiers != stream_identifiers || cursor.lexed_count() != stream.size()) {
+        std::cerr << "cursor and stream disagree" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <iostream>
+
+#include "benchmarks/bench_utils.h"
+#include "src/lexer.h"
+
+/*
+ * Compares std::vector<Token> against the packed TokenStream:
+ * bytes per token, lexing throughput and a parser-like walk over the tokens.
+ * usage: bench_token_layout [megabytes of synthetic source]
+ */
+
+template<typename Iterator>
+size_t walk(Iterator it, const Iterator &end) {
+    size_t identifiers = 0;
+    for (; it < end; ++it) {
+        if (it->m_type == TOKEN_TYPE::IDENTIFIER) {
+            ++identifiers;
+        }
+    }
+    return identifiers;
+}
+
+int main(int argc, char **argv) {
+    warn_if_debug_build();
+    auto source = SourceBuffer::from_string(synthetic_source(megabytes_argument(argc, argv, 64)));
+    std::cout << "source: " << source->size() / (1024 * 1024) << " MB" << std::endl;
+
+    Lexer lexer;
+
+    Stopwatch vector_lex_time;
+    auto tokens = lexer.lex(source);
+    double vector_lex_seconds = vector_lex_time.seconds();
+
+    size_t vector_bytes = tokens->capacity() * sizeof(Token); // spellings are interned, nothing on the side
+
+    Stopwatch vector_walk_time;
+    size_t vector_identifiers = walk(tokens->begin(), tokens->end());
+    double vector_walk_seconds = vector_walk_time.seconds();
+
+    Stopwatch stream_lex_time;
+    auto stream = lexer.lex_stream(source);
+    double stream_lex_seconds = stream_lex_time.seconds();
+
+    Stopwatch stream_walk_time;
+    size_t stream_identifiers = walk(stream.begin(), stream.end());
+    double stream_walk_seconds = stream_walk_time.seconds();
+
+    if (vector_identifiers != stream_identifiers || tokens->size() != stream.size()) {
+        std::cerr << "layouts disagree" << std::endl;
+        return 1;
+    }
+
+    double token_count = static_cast<double>(stream.size());
+    std::cout << "tokens: " << stream.size() << std::endl;
+    std::cout << "std::vector<Token>: " << vector_bytes / token_count << " bytes/token, "
+              << token_count / vector_lex_seconds / 1e6 << " M tokens/sec lexed, "
+              << token_count / vector_walk_seconds / 1e6 << " M tokens/sec walked" << std::endl;
+    std::cout << "TokenStream:        " << stream.memory_usage() / token_count << " bytes/token, "
+              << token_count / stream_lex_seconds / 1e6 << " M tokens/sec lexed, "
+              << token_count / stream_walk_seconds / 1e6 << " M tokens/sec walked" << std::endl;
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <iostream>
+
+#include "benchmarks/bench_utils.h"
+#include "src/parser.hpp"
+#include "src/type_checker.h"
+
+/*
+ * Name resolution and type checking time on two shapes of input:
+ * deep pointer types, declared and dereferenced level by level, and a large call graph of functions
+ * calling each other through prototypes.
+ * usage: bench_type_checker [function count]
+ */
+
+std::string deep_pointers(size_t function_count) {
+    std::string source;
+    for (size_t index = 0; index < function_count; ++index) {
+        std::string suffix = std::to_string(index);
+        std::string stars(64 + index % 64, '*');
+        source += "int deep_" + suffix + "(int " + stars + "p) { int " + stars.substr(1) + "q = *p; return " +
+                  std::string(stars.size() - 1, '*') + "q; }\n";
+    }
+    return source;
+}
+
+std::string call_graph(size_t function_count) {
+    std::string source;
+    for (size_t index = 0; index < function_count; ++index) {
+        source += "int call_" + std::to_string(index) + "(int a, char *b, int **c);\n";
+    }
+    for (size_t index = 0; index < function_count; ++index) {
+        std::string first = std::to_string(index * 7 % function_count);
+        std::string second = std::to_string(index * 13 % function_count);
+        source += "int call_" + std::to_string(index) + "(int a, char *b, int **c) {\n"
+                  "    if (a > 0 && b != 0) { return call_" + first + "(a - 1, b + 1, c) + call_" + second +
+                  "(*c[a], b, c); }\n"
+                  "    return **c + b[a];\n"
+                  "}\n";
+    }
+    return source;
+}
+
+void run(const char *name, const std::string &source) {
+    Lexer lexer;
+    auto tokens = lexer.lex_stream(SourceBuffer::from_string(source));
+    Parser parser;
+    auto it = tokens.begin();
+    auto declarations = parser.parse_translation_unit(it, tokens.end());
+
+    Stopwatch resolve_watch;
+    NameResolver resolver;
+    resolver.resolve(declarations);
+    double resolve_seconds = resolve_watch.seconds();
+
+    Stopwatch check_watch;
+    TypeChecker checker(resolver);
+    checker.check(declarations);
+    double check_seconds = check_watch.seconds();
+
+    std::cout << name << ": " << declarations.size() << " declarations, " << tokens.size() << " tokens, "
+              << checker.types().size() << " types, "
+              << resolver.diagnostics().size() + checker.diagnostics().size() << " errors\n"
+              << "  resolve: " << resolve_seconds * 1e9 / tokens.size() << " ns/token\n"
+              << "  check:   " << check_seconds * 1e9 / tokens.size() << " ns/token" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    warn_if_debug_build();
+    size_t function_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    run("deep pointers", deep_pointers(function_count));
+    run("call graph", call_graph(function_count));
+    return 0;
+}
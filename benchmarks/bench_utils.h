@@ -0,0 +1,68 @@
+#pragma once
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+/*
+ * Shared helpers for the benchmark executables.
+ * Build with -DCMAKE_BUILD_TYPE=Release, debug builds print every token.
+ */
+
+inline void warn_if_debug_build() {
+#ifndef NDEBUG
+    std::fprintf(stderr, "warning: benchmark built without NDEBUG, numbers are dominated by debug output\n");
+#endif
+}
+
+inline size_t megabytes_argument(int argc, char **argv, size_t default_megabytes) {
+    return (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : default_megabytes) * 1024 * 1024;
+}
+
+class Stopwatch {
+public:
+    Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+
+    double seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+inline size_t peak_rss_kilobytes() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// tests/hello_world.c style code, one function per repetition so identifiers stay varied
+inline std::string synthetic_source(size_t target_bytes) {
+    std::string source;
+    source.reserve(target_bytes + 1024);
+    for (size_t function_index = 0; source.size() < target_bytes; ++function_index) {
+        std::string suffix = std::to_string(function_index);
+        source += "int get_two_" + suffix + "(int a, int* b, int c)\n"
+                  "{\n"
+                  "    // SINGLE OPERATORS\n"
+                  "    a = 1+0-0*0%2;\n"
+                  "    a = !0 & 0 | b[0];\n"
+                  "    a = a < 0 + a > 0 / 2;\n"
+                  "    char* my_str_" + suffix + " = \"expected_string\";\n"
+                  "    char letter = 'f';\n"
+                  "    while(number_" + suffix + " >= 4 || number <= 1355)\n"
+                  "    {\n"
+                  "        print(my_str_" + suffix + ", letter);\n"
+                  "    }\n"
+                  "    if(a == 1 && c != 2) {\n"
+                  "        return a;\n"
+                  "    }\n"
+                  "    return c;\n"
+                  "}\n\n";
+    }
+    return source;
+}
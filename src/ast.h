@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "source_buffer.h"
+#include "token.h"
+
+/*
+ * Tree produced by the Parser. Nodes and their child lists are allocated from the AstArena of the
+ * translation unit and point at each other with plain pointers, the arena owns all of them.
+ */
+
+struct ASTNode;
+
+// names a type in the TypeTable, see types.h
+using TypeId = uint32_t;
+
+// child lists draw from the same arena as the nodes holding them
+using NodeList = std::pmr::vector<ASTNode *>;
+
+struct BinaryOperation {
+    BinaryOperation(ASTNode *lhs, ASTNode *rhs) : lhs(lhs), rhs(rhs) {}
+
+    ASTNode *lhs;
+    ASTNode *rhs;
+};
+
+// prefix -, !, * (DEREF) and & (ADDRESSOF)
+struct UnaryOperation {
+    ASTNode *operand;
+};
+
+struct FuncCall {
+    NodeList arg;
+};
+
+struct Block {
+    NodeList statements;
+};
+
+
+// type keyword and the number of '*' after it, char ** is {char, 2}
+struct TypeName {
+    Token base;
+    uint8_t pointer_depth = 0;
+
+    bool operator==(const TypeName &other) const = default;
+};
+
+struct VariableDeclaration {
+    TypeName type;
+};
+
+constexpr uint32_t NO_DEFERRED_BODY = UINT32_MAX;
+
+// offset of a node parsed from tokens which don't know where they are in the source
+constexpr uint32_t NO_SOURCE_OFFSET = UINT32_MAX;
+
+/*
+ * params are VARIABLE_DECLARATION nodes, unnamed ones hold an EMPTY token. Only definitions have a body block.
+ * A definition parsed by Parser::parse_translation_unit_lazy has no body yet, deferred_body is the token index
+ * of its '{' until Parser::function_body parses it.
+ */
+struct FuncDeclaration {
+    TypeName return_type;
+    NodeList params;
+    ASTNode *body = nullptr;
+    uint32_t deferred_body = NO_DEFERRED_BODY;
+};
+
+// else if chains nest: the else branch of the first if is the second if
+struct IfStatement {
+    ASTNode *condition;
+    ASTNode *then_branch;
+    ASTNode *else_branch = nullptr;
+};
+
+struct WhileLoop {
+    ASTNode *condition;
+    ASTNode *body = nullptr;
+};
+
+// value is null for a bare return, break and continue are plain leaves
+struct ReturnStatement {
+    ASTNode *value = nullptr;
+};
+
+struct ASTNode {
+    ASTNode(const Token &token) : m_token(token) {};
+
+    ASTNode(const Token &token, FuncCall &&func_members) : m_token(token), m_members(std::move(func_members)) {};
+
+    ASTNode(const Token &token, BinaryOperation &&operation_members) : m_token(token),
+                                                                       m_members(std::move(operation_members)) {};
+
+    ASTNode(const Token &token, VariableDeclaration &&variable_declaration) : m_token(token),
+                                                                              m_members(std::move(
+                                                                                      variable_declaration)) {};
+
+    ASTNode(const Token &token, FuncDeclaration &&function_declaration) : m_token(token),
+                                                                          m_members(std::move(function_declaration)) {};
+
+    ASTNode(const Token &token, Block &&block) : m_token(token),
+                                                 m_members(std::move(block)) {};
+
+    ASTNode(const Token &token, UnaryOperation &&operation_members) : m_token(token),
+                                                                      m_members(operation_members) {};
+
+    ASTNode(const Token &token, IfStatement &&if_statement) : m_token(token), m_members(if_statement) {};
+
+    ASTNode(const Token &token, WhileLoop &&while_loop) : m_token(token), m_members(while_loop) {};
+
+    ASTNode(const Token &token, ReturnStatement &&return_statement) : m_token(token), m_members(return_statement) {};
+
+    Token m_token;
+    uint32_t m_offset = NO_SOURCE_OFFSET; // byte offset of the token in the source
+    std::variant<std::monostate, FuncCall, BinaryOperation, VariableDeclaration, FuncDeclaration, Block,
+            UnaryOperation, IfStatement, WhileLoop, ReturnStatement> m_members;
+};
+
+// what a node is, in the order of ASTNode::m_members' alternatives
+enum class NODE_KIND : uint8_t {
+    LEAF,
+    FUNC_CALL,
+    BINARY_OPERATION,
+    VARIABLE_DECLARATION,
+    FUNC_DECLARATION,
+    BLOCK,
+    UNARY_OPERATION,
+    IF,
+    WHILE,
+    RETURN,
+};
+
+inline NODE_KIND node_kind(const ASTNode &node) {
+    return static_cast<NODE_KIND>(node.m_members.index());
+}
+
+// where node's token is in source, none when either doesn't know
+inline std::optional<SourceLocation> node_location(const ASTNode &node, const SourceBuffer *source) {
+    if (!source || node.m_offset == NO_SOURCE_OFFSET) {
+        return std::nullopt;
+    }
+    return source->location(node.m_offset);
+}
+
+/*
+ * Owns every node of a translation unit. By default nodes are bump allocated from a monotonic buffer,
+ * so making a node is a pointer bump and the whole tree goes away with a handful of frees and
+ * no destructor walk (everything a node holds lives in the arena as well).
+ * Given a memory resource instead, nodes are allocated from it one by one and destroyed one by one,
+ * which is how the tree used to be managed and is kept for comparing the two.
+ */
+class AstArena {
+public:
+    AstArena() : m_resource(&m_monotonic) {}
+
+    explicit AstArena(std::pmr::memory_resource *resource) : m_resource(resource), m_frees_nodes(true) {}
+
+    AstArena(const AstArena &) = delete;
+
+    AstArena &operator=(const AstArena &) = delete;
+
+    ~AstArena() {
+        for (ASTNode *node: m_nodes) {
+            node->~ASTNode();
+            m_resource->deallocate(node, sizeof(ASTNode), alignof(ASTNode));
+        }
+    }
+
+    template<typename... Args>
+    ASTNode *make(Args &&... args) {
+        void *memory = m_resource->allocate(sizeof(ASTNode), alignof(ASTNode));
+        auto node = new(memory) ASTNode(std::forward<Args>(args)...);
+        if (m_frees_nodes) {
+            m_nodes.push_back(node);
+        }
+        return node;
+    }
+
+    // empty list allocating from the arena
+    template<typename T = ASTNode *>
+    std::pmr::vector<T> list() const { return std::pmr::vector<T>(m_resource); }
+
+    std::pmr::memory_resource *resource() const { return m_resource; }
+
+private:
+    std::pmr::monotonic_buffer_resource m_monotonic;
+    std::pmr::memory_resource *m_resource;
+    bool m_frees_nodes = false;
+    std::vector<ASTNode *> m_nodes;
+};
@@ -0,0 +1,283 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+#include "ast_cache.h"
+#include "macros.h"
+#include "xxhash.h"
+
+namespace {
+
+    constexpr char ENTRY_MAGIC[8] = {'C', 'A', 'S', 'T', 'C', 'A', 'C', 'H'};
+    constexpr size_t SECTION_ALIGNMENT = 8;
+
+    // arrays of an entry, in file order
+    enum SECTION : uint32_t {
+        ROOTS,
+        KINDS,
+        TOKEN_TYPES,
+        TOKEN_PAYLOADS,
+        NODE_OFFSETS,
+        FIRST_CHILD,
+        CHILD_COUNTS,
+        FIRST_EXTRA,
+        EXTRA_COUNTS,
+        CHILDREN,
+        EXTRA_TYPES,
+        EXTRA_PAYLOADS,
+        EXTRA_POINTER_DEPTHS,
+        STREAM_KINDS,
+        STREAM_OFFSETS,
+        STREAM_LENGTHS,
+        STREAM_PAYLOADS,
+        STREAM_PARTNERS,
+        SYMBOL_OFFSETS, // symbol count + 1 offsets into SYMBOL_BYTES
+        SYMBOL_BYTES,
+        SECTION_COUNT,
+    };
+
+    struct Section {
+        uint64_t m_offset; // from the start of the entry
+        uint64_t m_count;  // elements, not bytes
+    };
+
+    struct EntryHeader {
+        char m_magic[8];
+        uint32_t m_format;
+        uint32_t m_section_count;
+        uint64_t m_key;
+        uint64_t m_source_size;
+        Section m_sections[SECTION_COUNT];
+    };
+
+    // integer and character literals carry their value, every other token a symbol id
+    bool has_symbol_payload(TOKEN_TYPE type) {
+        return type != TOKEN_TYPE::INTEGER && type != TOKEN_TYPE::CHARACTER;
+    }
+
+    // lays sections out one after the other behind the header
+    class EntryWriter {
+    public:
+        EntryWriter() : m_bytes(sizeof(EntryHeader), '\0') {}
+
+        EntryHeader &header() { return *reinterpret_cast<EntryHeader *>(m_bytes.data()); }
+
+        template<typename T>
+        void write(SECTION section, const T *data, size_t count) {
+            m_bytes.resize((m_bytes.size() + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT, '\0');
+            header().m_sections[section] = {m_bytes.size(), count};
+            m_bytes.append(reinterpret_cast<const char *>(data), count * sizeof(T));
+        }
+
+        template<typename T>
+        void write(SECTION section, const std::vector<T> &values) {
+            write(section, values.data(), values.size());
+        }
+
+        const std::string &bytes() const { return m_bytes; }
+
+    private:
+        std::string m_bytes;
+    };
+
+    // numbers the symbols an entry uses in first seen order and collects their spellings
+    class SymbolTable {
+    public:
+        std::vector<uint32_t> localize(const std::vector<TOKEN_TYPE> &types, const std::vector<uint32_t> &payloads) {
+            std::vector<uint32_t> localized(payloads);
+            for (size_t index = 0; index < types.size(); ++index) {
+                if (has_symbol_payload(types[index])) {
+                    auto [entry, inserted] = m_local_ids.try_emplace(payloads[index], m_offsets.size() - 1);
+                    if (inserted) {
+                        m_bytes += Symbol::from_id(payloads[index]).text();
+                        m_offsets.push_back(m_bytes.size());
+                    }
+                    localized[index] = entry->second;
+                }
+            }
+            return localized;
+        }
+
+        const std::vector<uint32_t> &offsets() const { return m_offsets; }
+
+        const std::string &bytes() const { return m_bytes; }
+
+    private:
+        std::unordered_map<uint32_t, uint32_t> m_local_ids;
+        std::vector<uint32_t> m_offsets = {0};
+        std::string m_bytes;
+    };
+
+    // the section as a span, false when it isn't aligned for T or reaches past the entry
+    template<typename T>
+    bool section_view(const char *entry, size_t entry_size, const Section &section, std::span<const T> &view) {
+        if (section.m_offset % alignof(T) != 0 || section.m_offset > entry_size ||
+            section.m_count > (entry_size - section.m_offset) / sizeof(T)) {
+            return false;
+        }
+        view = {reinterpret_cast<const T *>(entry + section.m_offset), section.m_count};
+        return true;
+    }
+}
+
+MappedAst::~MappedAst() {
+    if (m_mapping) {
+        ::munmap(m_mapping, m_mapped_size);
+    }
+}
+
+Token MappedAst::unpack(TOKEN_TYPE type, uint32_t payload) const {
+    return TokenView{type, {}, has_symbol_payload(type) ? m_symbols[payload] : payload};
+}
+
+uint64_t AstCache::key(std::string_view source) {
+    static const uint64_t seed = xxh64(std::string(COMPILER_VERSION) + " " + std::to_string(AST_CACHE_FORMAT) + " " +
+                                       std::to_string(PIPELINE_VERSION));
+    return xxh64(source, seed);
+}
+
+std::filesystem::path AstCache::entry_path(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ast", static_cast<unsigned long long>(key));
+    return m_directory / name;
+}
+
+std::unique_ptr<const MappedAst> AstCache::load(std::string_view source) const {
+    uint64_t source_key = key(source);
+    std::filesystem::path path = entry_path(source_key);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat file_stat{};
+    if (::fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(EntryHeader)) {
+        ::close(fd);
+        return nullptr;
+    }
+    void *mapping = ::mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedAst> ast(new MappedAst());
+    ast->m_mapping = mapping;
+    ast->m_mapped_size = file_stat.st_size;
+    const char *entry = static_cast<const char *>(mapping);
+    const auto &header = *static_cast<const EntryHeader *>(mapping);
+    if (std::memcmp(header.m_magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0 || header.m_format != AST_CACHE_FORMAT ||
+        header.m_section_count != SECTION_COUNT || header.m_key != source_key ||
+        header.m_source_size != source.size()) {
+        DEBUG_MSG("stale cache entry " << path);
+        return nullptr;
+    }
+
+    std::span<const uint32_t> symbol_offsets;
+    std::span<const char> symbol_bytes;
+    auto view = [&](SECTION section, auto &span) {
+        return section_view(entry, ast->m_mapped_size, header.m_sections[section], span);
+    };
+    bool in_bounds = view(ROOTS, ast->m_roots) && view(KINDS, ast->m_kinds) &&
+                     view(TOKEN_TYPES, ast->m_token_types) && view(TOKEN_PAYLOADS, ast->m_token_payloads) &&
+                     view(NODE_OFFSETS, ast->m_offsets) &&
+                     view(FIRST_CHILD, ast->m_first_child) && view(CHILD_COUNTS, ast->m_child_counts) &&
+                     view(FIRST_EXTRA, ast->m_first_extra) && view(EXTRA_COUNTS, ast->m_extra_counts) &&
+                     view(CHILDREN, ast->m_children) && view(EXTRA_TYPES, ast->m_extra_types) &&
+                     view(EXTRA_PAYLOADS, ast->m_extra_payloads) &&
+                     view(EXTRA_POINTER_DEPTHS, ast->m_extra_pointer_depths) &&
+                     view(STREAM_KINDS, ast->m_stream_kinds) && view(STREAM_OFFSETS, ast->m_stream_offsets) &&
+                     view(STREAM_LENGTHS, ast->m_stream_lengths) && view(STREAM_PAYLOADS, ast->m_stream_payloads) &&
+                     view(STREAM_PARTNERS, ast->m_stream_partners) && view(SYMBOL_OFFSETS, symbol_offsets) &&
+                     view(SYMBOL_BYTES, symbol_bytes) && !symbol_offsets.empty();
+    if (!in_bounds) {
+        DEBUG_MSG("corrupt cache entry " << path);
+        return nullptr;
+    }
+
+    // the only per entry work: one intern per distinct spelling
+    ast->m_symbols.reserve(symbol_offsets.size() - 1);
+    for (size_t index = 0; index + 1 < symbol_offsets.size(); ++index) {
+        if (symbol_offsets[index] > symbol_offsets[index + 1] || symbol_offsets[index + 1] > symbol_bytes.size()) {
+            DEBUG_MSG("corrupt cache entry " << path);
+            return nullptr;
+        }
+        ast->m_symbols.push_back(Interner::global().intern(
+                {symbol_bytes.data() + symbol_offsets[index], symbol_offsets[index + 1] - symbol_offsets[index]}));
+    }
+    DEBUG_MSG("mapped cache entry " << path << " (" << ast->size() << " nodes)");
+    return ast;
+}
+
+bool AstCache::store(std::string_view source, const TokenStream &tokens, const FlatAst &ast) const {
+    EntryWriter writer;
+    SymbolTable symbols;
+    std::vector<TOKEN_TYPE> stream_kinds(tokens.size());
+    std::vector<uint32_t> stream_offsets(tokens.size());
+    std::vector<uint32_t> stream_lengths(tokens.size());
+    std::vector<uint32_t> stream_payloads(tokens.size());
+    std::vector<uint32_t> stream_partners(tokens.size());
+    for (size_t index = 0; index < tokens.size(); ++index) {
+        stream_kinds[index] = tokens.kind(index);
+        stream_offsets[index] = tokens.offset(index);
+        stream_lengths[index] = tokens.length(index);
+        stream_payloads[index] = tokens.payload(index);
+        stream_partners[index] = tokens.partner(index);
+    }
+
+    writer.write(ROOTS, ast.m_roots);
+    writer.write(KINDS, ast.m_kinds);
+    writer.write(TOKEN_TYPES, ast.m_token_types);
+    writer.write(TOKEN_PAYLOADS, symbols.localize(ast.m_token_types, ast.m_token_payloads));
+    writer.write(NODE_OFFSETS, ast.m_offsets);
+    writer.write(FIRST_CHILD, ast.m_first_child);
+    writer.write(CHILD_COUNTS, ast.m_child_counts);
+    writer.write(FIRST_EXTRA, ast.m_first_extra);
+    writer.write(EXTRA_COUNTS, ast.m_extra_counts);
+    writer.write(CHILDREN, ast.m_children);
+    writer.write(EXTRA_TYPES, ast.m_extra_types);
+    writer.write(EXTRA_PAYLOADS, symbols.localize(ast.m_extra_types, ast.m_extra_payloads));
+    writer.write(EXTRA_POINTER_DEPTHS, ast.m_extra_pointer_depths);
+    writer.write(STREAM_KINDS, stream_kinds);
+    writer.write(STREAM_OFFSETS, stream_offsets);
+    writer.write(STREAM_LENGTHS, stream_lengths);
+    writer.write(STREAM_PAYLOADS, symbols.localize(stream_kinds, stream_payloads));
+    writer.write(STREAM_PARTNERS, stream_partners);
+    writer.write(SYMBOL_OFFSETS, symbols.offsets());
+    writer.write(SYMBOL_BYTES, symbols.bytes().data(), symbols.bytes().size());
+
+    EntryHeader &header = writer.header();
+    std::memcpy(header.m_magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+    header.m_format = AST_CACHE_FORMAT;
+    header.m_section_count = SECTION_COUNT;
+    header.m_key = key(source);
+    header.m_source_size = source.size();
+
+    // written aside and renamed over the entry, readers see the old entry or the whole new one
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    std::filesystem::path path = entry_path(header.m_key);
+    std::filesystem::path temporary = path;
+    temporary += ".tmp" + std::to_string(::getpid());
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(writer.bytes().data(), static_cast<std::streamsize>(writer.bytes().size()));
+        if (!file.good()) {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    DEBUG_MSG("stored cache entry " << path << " (" << writer.bytes().size() << " bytes)");
+    return true;
+}
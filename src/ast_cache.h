@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "flat_ast.h"
+#include "token_stream.h"
+
+constexpr const char *COMPILER_VERSION = "c_compiler 0.1";
+constexpr uint32_t AST_CACHE_FORMAT = 3; // bump whenever the entry layout or the trees stored in it change
+// bump whenever a pass reporting errors is added or reports more of them: entries are only stored for sources
+// which passed every pass, and that no longer holds for entries of an older pipeline
+constexpr uint32_t PIPELINE_VERSION = 4;
+
+/*
+ * Tokens and flat AST of a translation unit read straight out of a mapped cache entry.
+ * Every array sits in the entry at an aligned offset from its start and is read in place,
+ * so loading is an mmap and a few bounds checks: nothing is copied and there are no pointers to fix up.
+ * Symbols are stored as indices into the entry's own spelling table, which is interned once on load,
+ * and payloads are translated through it as they are read.
+ * Has FlatAst's read interface, so FlatNode and walk work on it as they are.
+ */
+class MappedAst {
+public:
+    MappedAst(const MappedAst &) = delete;
+
+    MappedAst &operator=(const MappedAst &) = delete;
+
+    ~MappedAst();
+
+    std::span<const NodeId> roots() const { return m_roots; }
+
+    size_t size() const { return m_kinds.size(); }
+
+    NODE_KIND kind(NodeId id) const { return m_kinds[id]; }
+
+    Token token(NodeId id) const { return unpack(m_token_types[id], m_token_payloads[id]); }
+
+    uint32_t offset(NodeId id) const { return m_offsets[id]; }
+
+    uint32_t child_count(NodeId id) const { return m_child_counts[id]; }
+
+    NodeId child(NodeId id, uint32_t index) const { return m_children[m_first_child[id] + index]; }
+
+    uint32_t extra_count(NodeId id) const { return m_extra_counts[id]; }
+
+    TypeName extra(NodeId id, uint32_t index) const {
+        uint32_t position = m_first_extra[id] + index;
+        return {unpack(m_extra_types[position], m_extra_payloads[position]), m_extra_pointer_depths[position]};
+    }
+
+    // the token stream the AST was parsed from, offsets and lengths are into the same source
+    size_t stream_size() const { return m_stream_kinds.size(); }
+
+    TOKEN_TYPE stream_kind(size_t index) const { return m_stream_kinds[index]; }
+
+    uint32_t stream_offset(size_t index) const { return m_stream_offsets[index]; }
+
+    uint32_t stream_length(size_t index) const { return m_stream_lengths[index]; }
+
+    uint32_t stream_partner(size_t index) const { return m_stream_partners[index]; }
+
+    Token stream_token(size_t index) const { return unpack(m_stream_kinds[index], m_stream_payloads[index]); }
+
+private:
+    friend class AstCache;
+
+    MappedAst() = default;
+
+    Token unpack(TOKEN_TYPE type, uint32_t payload) const;
+
+    void *m_mapping = nullptr;
+    size_t m_mapped_size = 0;
+    std::vector<uint32_t> m_symbols; // the entry's symbol index -> interned id
+
+    std::span<const NodeId> m_roots;
+    std::span<const NODE_KIND> m_kinds;
+    std::span<const TOKEN_TYPE> m_token_types;
+    std::span<const uint32_t> m_token_payloads;
+    std::span<const uint32_t> m_offsets;
+    std::span<const uint32_t> m_first_child;
+    std::span<const uint32_t> m_child_counts;
+    std::span<const uint32_t> m_first_extra;
+    std::span<const uint32_t> m_extra_counts;
+    std::span<const NodeId> m_children;
+    std::span<const TOKEN_TYPE> m_extra_types;
+    std::span<const uint32_t> m_extra_payloads;
+    std::span<const uint8_t> m_extra_pointer_depths;
+
+    std::span<const TOKEN_TYPE> m_stream_kinds;
+    std::span<const uint32_t> m_stream_offsets;
+    std::span<const uint32_t> m_stream_lengths;
+    std::span<const uint32_t> m_stream_payloads;
+    std::span<const uint32_t> m_stream_partners;
+};
+
+/*
+ * Directory of lexed and parsed translation units, one file per source named after its key.
+ * The key hashes the source bytes together with the compiler and pipeline versions, so an edited source or a
+ * new compiler simply misses. Entries are written in host byte order and trusted once their header checks out,
+ * the directory belongs to the compiler.
+ */
+class AstCache {
+public:
+    explicit AstCache(std::filesystem::path directory) : m_directory(std::move(directory)) {}
+
+    // XXH64 of the source bytes, seeded with the hash of COMPILER_VERSION, AST_CACHE_FORMAT and PIPELINE_VERSION
+    static uint64_t key(std::string_view source);
+
+    std::filesystem::path entry_path(uint64_t key) const;
+
+    // source's entry, null when there is none or it was written for another source or compiler
+    std::unique_ptr<const MappedAst> load(std::string_view source) const;
+
+    /*
+     * Writes tokens and ast, the trees parsed from them, as source's entry. The entry replaces an older one
+     * atomically so concurrent builds never map half a file. False when it couldn't be written,
+     * a cache is never worth failing a build over.
+     */
+    bool store(std::string_view source, const TokenStream &tokens, const FlatAst &ast) const;
+
+private:
+    std::filesystem::path m_directory;
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <vector>
+
+#include "ast.h"
+#include "flat_ast.h"
+
+/*
+ * One way of looking at a node whichever representation it lives in, so passes are written once
+ * as templates over the node handle:
+ *   kind(), token(), offset(), child_count(), child(i), extra_count(), extra(i)
+ * TreeNode wraps an ASTNode pointer, FlatNode a flat tree (a FlatAst or a MappedAst) and a node id.
+ * Declarations carry one extra, the declared type: a variable's type or a function's return type.
+ * A function's children are its parameter declarations followed by its body when it's a definition,
+ * an if's are the condition, the then branch and the else branch when there is one.
+ */
+
+class TreeNode {
+public:
+    explicit TreeNode(const ASTNode *node) : m_node(node) {}
+
+    NODE_KIND kind() const { return node_kind(*m_node); }
+
+    const Token &token() const { return m_node->m_token; }
+
+    uint32_t offset() const { return m_node->m_offset; }
+
+    uint32_t child_count() const {
+        switch (kind()) {
+            case NODE_KIND::BINARY_OPERATION:
+                return 2;
+            case NODE_KIND::UNARY_OPERATION:
+                return 1;
+            case NODE_KIND::FUNC_CALL:
+                return std::get<FuncCall>(m_node->m_members).arg.size();
+            case NODE_KIND::BLOCK:
+                return std::get<Block>(m_node->m_members).statements.size();
+            case NODE_KIND::FUNC_DECLARATION: {
+                const auto &declaration = std::get<FuncDeclaration>(m_node->m_members);
+                return declaration.params.size() + (declaration.body != nullptr);
+            }
+            case NODE_KIND::IF:
+                return 2 + (std::get<IfStatement>(m_node->m_members).else_branch != nullptr);
+            case NODE_KIND::WHILE:
+                return 2;
+            case NODE_KIND::RETURN:
+                return std::get<ReturnStatement>(m_node->m_members).value != nullptr;
+            default:
+                return 0;
+        }
+    }
+
+    TreeNode child(uint32_t index) const {
+        switch (kind()) {
+            case NODE_KIND::BINARY_OPERATION: {
+                const auto &operation = std::get<BinaryOperation>(m_node->m_members);
+                return TreeNode(index == 0 ? operation.lhs : operation.rhs);
+            }
+            case NODE_KIND::UNARY_OPERATION:
+                return TreeNode(std::get<UnaryOperation>(m_node->m_members).operand);
+            case NODE_KIND::FUNC_CALL:
+                return TreeNode(std::get<FuncCall>(m_node->m_members).arg[index]);
+            case NODE_KIND::FUNC_DECLARATION: {
+                const auto &declaration = std::get<FuncDeclaration>(m_node->m_members);
+                return TreeNode(index < declaration.params.size() ? declaration.params[index] : declaration.body);
+            }
+            case NODE_KIND::IF: {
+                const auto &statement = std::get<IfStatement>(m_node->m_members);
+                return TreeNode(index == 0 ? statement.condition : index == 1 ? statement.then_branch
+                                                                              : statement.else_branch);
+            }
+            case NODE_KIND::WHILE: {
+                const auto &loop = std::get<WhileLoop>(m_node->m_members);
+                return TreeNode(index == 0 ? loop.condition : loop.body);
+            }
+            case NODE_KIND::RETURN:
+                return TreeNode(std::get<ReturnStatement>(m_node->m_members).value);
+            default:
+                return TreeNode(std::get<Block>(m_node->m_members).statements[index]);
+        }
+    }
+
+    uint32_t extra_count() const {
+        switch (kind()) {
+            case NODE_KIND::VARIABLE_DECLARATION:
+            case NODE_KIND::FUNC_DECLARATION:
+                return 1;
+            default:
+                return 0;
+        }
+    }
+
+    // a declaration's only extra, so there's no index to look at
+    const TypeName &extra(uint32_t /* index */) const {
+        if (kind() == NODE_KIND::VARIABLE_DECLARATION) {
+            return std::get<VariableDeclaration>(m_node->m_members).type;
+        }
+        return std::get<FuncDeclaration>(m_node->m_members).return_type;
+    }
+
+    const ASTNode *node() const { return m_node; }
+
+private:
+    const ASTNode *m_node;
+};
+
+template<typename Ast = FlatAst>
+class FlatNode {
+public:
+    FlatNode(const Ast &ast, NodeId id) : m_ast(&ast), m_id(id) {}
+
+    NODE_KIND kind() const { return m_ast->kind(m_id); }
+
+    Token token() const { return m_ast->token(m_id); }
+
+    uint32_t offset() const { return m_ast->offset(m_id); }
+
+    uint32_t child_count() const { return m_ast->child_count(m_id); }
+
+    FlatNode child(uint32_t index) const { return {*m_ast, m_ast->child(m_id, index)}; }
+
+    uint32_t extra_count() const { return m_ast->extra_count(m_id); }
+
+    TypeName extra(uint32_t index) const { return m_ast->extra(m_id, index); }
+
+    NodeId id() const { return m_id; }
+
+private:
+    const Ast *m_ast;
+    NodeId m_id;
+};
+
+// a whole flat AST as opposed to a node handle
+template<typename Ast>
+concept FlatTree = requires(const Ast &ast) { ast.roots(); };
+
+/*
+ * Depth first walk calling visitor.enter(node) before a node's children, visitor.before_child(node, index)
+ * before each of them and visitor.leave(node) after them, any of the three may be left out. enter returning
+ * false skips the node's children (and its leave).
+ * Walks over an explicit stack rather than recursing, trees nest as deep as the parser allows. leave may
+ * rewrite the node it's given: its children are done with and the walk doesn't look at it again.
+ */
+template<typename Node, typename Visitor> requires (!FlatTree<Node>)
+void walk(const Node &root, Visitor &visitor) {
+    auto enter = [&visitor](const Node &node) {
+        if constexpr (requires { { visitor.enter(node) } -> std::same_as<bool>; }) {
+            return visitor.enter(node);
+        } else {
+            if constexpr (requires { visitor.enter(node); }) {
+                visitor.enter(node);
+            }
+            return true;
+        }
+    };
+    struct OpenNode {
+        Node m_node;
+        uint32_t m_next_child;
+    };
+    if (!enter(root)) {
+        return;
+    }
+    std::vector<OpenNode> open = {{root, 0}};
+    while (!open.empty()) {
+        OpenNode &top = open.back();
+        if (top.m_next_child < top.m_node.child_count()) {
+            uint32_t index = top.m_next_child++;
+            if constexpr (requires { visitor.before_child(top.m_node, index); }) {
+                visitor.before_child(top.m_node, index);
+            }
+            Node child = top.m_node.child(index);
+            if (enter(child)) {
+                open.push_back({child, 0});
+            }
+            continue;
+        }
+        Node node = top.m_node;
+        open.pop_back();
+        if constexpr (requires { visitor.leave(node); }) {
+            visitor.leave(node);
+        }
+    }
+}
+
+// every tree of a flat AST, in the order they were added
+template<FlatTree Ast, typename Visitor>
+void walk(const Ast &ast, Visitor &visitor) {
+    for (NodeId root: ast.roots()) {
+        walk(FlatNode(ast, root), visitor);
+    }
+}
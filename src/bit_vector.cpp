@@ -0,0 +1,117 @@
+#include "bit_vector.h"
+
+#include <algorithm>
+
+BitVector::BitVector(size_t size, bool full) : m_size(size), m_words((size + 63) / 64) {
+    if (full) {
+        fill();
+    }
+}
+
+void BitVector::set_range(size_t begin, size_t end) {
+    if (begin >= end) {
+        return;
+    }
+    size_t first = begin / 64;
+    size_t last = (end - 1) / 64;
+    uint64_t first_mask = ~uint64_t(0) << (begin % 64);
+    uint64_t last_mask = ~uint64_t(0) >> (63 - (end - 1) % 64);
+    if (first == last) {
+        m_words[first] |= first_mask & last_mask;
+        return;
+    }
+    m_words[first] |= first_mask;
+    std::fill(m_words.begin() + first + 1, m_words.begin() + last, ~uint64_t(0));
+    m_words[last] |= last_mask;
+}
+
+void BitVector::reset_range(size_t begin, size_t end) {
+    if (begin >= end) {
+        return;
+    }
+    size_t first = begin / 64;
+    size_t last = (end - 1) / 64;
+    uint64_t first_mask = ~uint64_t(0) << (begin % 64);
+    uint64_t last_mask = ~uint64_t(0) >> (63 - (end - 1) % 64);
+    if (first == last) {
+        m_words[first] &= ~(first_mask & last_mask);
+        return;
+    }
+    m_words[first] &= ~first_mask;
+    std::fill(m_words.begin() + first + 1, m_words.begin() + last, 0);
+    m_words[last] &= ~last_mask;
+}
+
+void BitVector::clear() {
+    std::fill(m_words.begin(), m_words.end(), 0);
+}
+
+void BitVector::fill() {
+    std::fill(m_words.begin(), m_words.end(), ~uint64_t(0));
+    if (m_size % 64 != 0) {
+        m_words.back() = (uint64_t(1) << (m_size % 64)) - 1;
+    }
+}
+
+size_t BitVector::count() const {
+    size_t members = 0;
+    for (uint64_t word: m_words) {
+        members += __builtin_popcountll(word);
+    }
+    return members;
+}
+
+bool BitVector::empty() const {
+    uint64_t any = 0;
+    for (uint64_t word: m_words) {
+        any |= word;
+    }
+    return any == 0;
+}
+
+size_t BitVector::find_next(size_t from) const {
+    if (from >= m_size) {
+        return m_size;
+    }
+    size_t word = from / 64;
+    uint64_t bits = m_words[word] & (~uint64_t(0) << (from % 64));
+    while (bits == 0) {
+        if (++word == m_words.size()) {
+            return m_size;
+        }
+        bits = m_words[word];
+    }
+    return word * 64 + __builtin_ctzll(bits);
+}
+
+// the loops below accumulate whether anything changed instead of branching on it so they vectorize
+
+bool BitVector::unite(const BitVector &other) {
+    uint64_t changed = 0;
+    for (size_t word = 0; word < m_words.size(); ++word) {
+        uint64_t updated = m_words[word] | other.m_words[word];
+        changed |= updated ^ m_words[word];
+        m_words[word] = updated;
+    }
+    return changed != 0;
+}
+
+bool BitVector::intersect(const BitVector &other) {
+    uint64_t changed = 0;
+    for (size_t word = 0; word < m_words.size(); ++word) {
+        uint64_t updated = m_words[word] & other.m_words[word];
+        changed |= updated ^ m_words[word];
+        m_words[word] = updated;
+    }
+    return changed != 0;
+}
+
+bool BitVector::subtract(const BitVector &other) {
+    uint64_t changed = 0;
+    for (size_t word = 0; word < m_words.size(); ++word) {
+        uint64_t updated = m_words[word] & ~other.m_words[word];
+        changed |= updated ^ m_words[word];
+        m_words[word] = updated;
+    }
+    return changed != 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/*
+ * Fixed size set of the integers [0, size()), one bit each packed into 64 bit words.
+ * Set operations run a word at a time over plain loops without branches, which the compiler turns into
+ * vector instructions. Bits past size() in the last word are always zero, so whole words can be compared
+ * and counted. Operands of the binary operations must have the same size.
+ */
+class BitVector {
+public:
+    BitVector() = default;
+
+    explicit BitVector(size_t size, bool full = false);
+
+    size_t size() const { return m_size; }
+
+    bool test(size_t index) const { return (m_words[index / 64] >> (index % 64)) & 1; }
+
+    void set(size_t index) { m_words[index / 64] |= uint64_t(1) << (index % 64); }
+
+    void reset(size_t index) { m_words[index / 64] &= ~(uint64_t(1) << (index % 64)); }
+
+    // every index in [begin, end)
+    void set_range(size_t begin, size_t end);
+
+    void reset_range(size_t begin, size_t end);
+
+    void clear();
+
+    // every index in [0, size())
+    void fill();
+
+    size_t count() const;
+
+    bool empty() const;
+
+    // first member at or after from, size() when there's none
+    size_t find_next(size_t from) const;
+
+    // the set operations, each true when this set changed
+    bool unite(const BitVector &other);
+
+    bool intersect(const BitVector &other);
+
+    bool subtract(const BitVector &other);
+
+    std::span<const uint64_t> words() const { return m_words; }
+
+    // calls function with each member in increasing order
+    template<typename Function>
+    void for_each(Function function) const {
+        for (size_t word = 0; word < m_words.size(); ++word) {
+            for (uint64_t bits = m_words[word]; bits != 0; bits &= bits - 1) {
+                function(word * 64 + __builtin_ctzll(bits));
+            }
+        }
+    }
+
+    bool operator==(const BitVector &other) const = default;
+
+private:
+    size_t m_size = 0;
+    std::vector<uint64_t> m_words;
+};
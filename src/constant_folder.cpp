@@ -0,0 +1,328 @@
+#include "constant_folder.h"
+
+#include <cstdint>
+#include <string>
+
+#include "ast_visitor.h"
+
+namespace {
+
+    // value of an integer or character literal, chars promoted to int
+    std::optional<int32_t> literal_value(const ASTNode *node) {
+        if (node_kind(*node) != NODE_KIND::LEAF) {
+            return std::nullopt;
+        }
+        if (node->m_token.m_type == TOKEN_TYPE::INTEGER) {
+            return std::get<int>(node->m_token.m_value);
+        }
+        if (node->m_token.m_type == TOKEN_TYPE::CHARACTER) {
+            return std::get<char>(node->m_token.m_value);
+        }
+        return std::nullopt;
+    }
+
+    bool is_commutative(TOKEN_TYPE type) {
+        switch (type) {
+            case TOKEN_TYPE::ADD:
+            case TOKEN_TYPE::STAR:
+            case TOKEN_TYPE::AMP:
+            case TOKEN_TYPE::PIPE:
+            case TOKEN_TYPE::EQ:
+            case TOKEN_TYPE::NEQ:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // (x op c1) op c2 is x op (c1 op c2)
+    bool is_associative(TOKEN_TYPE type) {
+        return type == TOKEN_TYPE::ADD || type == TOKEN_TYPE::STAR || type == TOKEN_TYPE::AMP ||
+               type == TOKEN_TYPE::PIPE;
+    }
+
+    // the right operand of node is never evaluated, its left one having folded to a literal deciding the result
+    bool skips_rhs(const ASTNode *node, const ASTNode *lhs) {
+        std::optional<int32_t> value = literal_value(lhs);
+        return value && ((node->m_token.m_type == TOKEN_TYPE::LAND && *value == 0) ||
+                         (node->m_token.m_type == TOKEN_TYPE::LOR && *value != 0));
+    }
+
+    bool is_arithmetic(TOKEN_TYPE type) {
+        for (TOKEN_TYPE arithmetic: ARITHMETIC_TOKENS) {
+            if (arithmetic == type) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // where node keeps its children, in TreeNode's order
+    void collect_child_slots(ASTNode *node, std::vector<ASTNode **> &slots) {
+        slots.clear();
+        switch (node_kind(*node)) {
+            case NODE_KIND::BINARY_OPERATION: {
+                auto &operation = std::get<BinaryOperation>(node->m_members);
+                slots.push_back(&operation.lhs);
+                slots.push_back(&operation.rhs);
+                break;
+            }
+            case NODE_KIND::UNARY_OPERATION:
+                slots.push_back(&std::get<UnaryOperation>(node->m_members).operand);
+                break;
+            case NODE_KIND::FUNC_CALL:
+                for (ASTNode *&argument: std::get<FuncCall>(node->m_members).arg) {
+                    slots.push_back(&argument);
+                }
+                break;
+            case NODE_KIND::BLOCK:
+                for (ASTNode *&statement: std::get<Block>(node->m_members).statements) {
+                    slots.push_back(&statement);
+                }
+                break;
+            case NODE_KIND::FUNC_DECLARATION: {
+                auto &declaration = std::get<FuncDeclaration>(node->m_members);
+                for (ASTNode *&param: declaration.params) {
+                    slots.push_back(&param);
+                }
+                if (declaration.body) {
+                    slots.push_back(&declaration.body);
+                }
+                break;
+            }
+            case NODE_KIND::IF: {
+                auto &statement = std::get<IfStatement>(node->m_members);
+                slots.push_back(&statement.condition);
+                slots.push_back(&statement.then_branch);
+                if (statement.else_branch) {
+                    slots.push_back(&statement.else_branch);
+                }
+                break;
+            }
+            case NODE_KIND::WHILE: {
+                auto &loop = std::get<WhileLoop>(node->m_members);
+                slots.push_back(&loop.condition);
+                slots.push_back(&loop.body);
+                break;
+            }
+            case NODE_KIND::RETURN: {
+                auto &statement = std::get<ReturnStatement>(node->m_members);
+                if (statement.value) {
+                    slots.push_back(&statement.value);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+void ConstantFolder::fold(NodeList &declarations, const SourceBuffer *source) {
+    m_source = source;
+    // post-order, so operands are folded before the operation holding them. Every finished node leaves
+    // whether it's free of side effects and what replaces it, the node itself when nothing does, on the
+    // finished stack, where its parent picks its children's up
+    struct Finished {
+        ASTNode *m_node;
+        bool m_pure;
+    };
+    struct Visitor {
+        ConstantFolder &m_folder;
+        std::vector<Finished> m_finished;
+
+        void before_child(TreeNode node, uint32_t index) {
+            if (index == 1 && node.kind() == NODE_KIND::BINARY_OPERATION &&
+                skips_rhs(node.node(), m_finished.back().m_node)) {
+                ++m_folder.m_unevaluated;
+            }
+        }
+
+        void leave(TreeNode tree_node) {
+            // the folder owns the trees it was handed, TreeNode only hands them out const
+            auto *node = const_cast<ASTNode *>(tree_node.node());
+            collect_child_slots(node, m_folder.m_child_slots);
+            size_t children_start = m_finished.size() - m_folder.m_child_slots.size();
+            bool node_pure = true;
+            for (size_t index = 0; index < m_folder.m_child_slots.size(); ++index) {
+                const Finished &child = m_finished[children_start + index];
+                *m_folder.m_child_slots[index] = child.m_node;
+                node_pure = node_pure && child.m_pure;
+            }
+
+            NODE_KIND kind = node_kind(*node);
+            ASTNode *folded = nullptr;
+            if (kind == NODE_KIND::FUNC_CALL) {
+                node_pure = false;
+            } else if (kind == NODE_KIND::BINARY_OPERATION) {
+                if (skips_rhs(node, m_finished[children_start].m_node)) {
+                    --m_folder.m_unevaluated;
+                }
+                if (node->m_token.m_type == TOKEN_TYPE::ASSIGN) {
+                    node_pure = false;
+                } else if (is_arithmetic(node->m_token.m_type)) {
+                    folded = m_folder.fold_binary(node, m_finished[children_start].m_pure,
+                                                  m_finished[children_start + 1].m_pure);
+                }
+            } else if (kind == NODE_KIND::UNARY_OPERATION) {
+                folded = m_folder.fold_unary(node);
+            }
+            if (folded) {
+                ++m_folder.m_folded_count;
+            }
+            m_finished.resize(children_start);
+            m_finished.push_back({folded ? folded : node, node_pure});
+        }
+    };
+    Visitor visitor{*this, {}};
+    for (ASTNode *&declaration: declarations) {
+        walk(TreeNode(declaration), visitor);
+        declaration = visitor.m_finished.back().m_node;
+        visitor.m_finished.clear();
+    }
+}
+
+ASTNode *ConstantFolder::fold_binary(ASTNode *node, bool lhs_pure, bool rhs_pure) {
+    auto &operation = std::get<BinaryOperation>(node->m_members);
+    TOKEN_TYPE type = node->m_token.m_type;
+    std::optional<int32_t> lhs = literal_value(operation.lhs);
+    std::optional<int32_t> rhs = literal_value(operation.rhs);
+    if (lhs && rhs) {
+        std::optional<int32_t> value = evaluate(node, *lhs, *rhs);
+        return value ? make_literal(node, *value) : nullptr;
+    }
+
+    // evaluation stops at the left operand
+    if (lhs && ((type == TOKEN_TYPE::LAND && *lhs == 0) || (type == TOKEN_TYPE::LOR && *lhs != 0))) {
+        return make_literal(node, type == TOKEN_TYPE::LOR);
+    }
+    if (lhs && is_commutative(type)) {
+        std::swap(operation.lhs, operation.rhs);
+        std::swap(lhs, rhs);
+        std::swap(lhs_pure, rhs_pure);
+    }
+    if (!rhs) {
+        return nullptr;
+    }
+
+    ASTNode *operand = operation.lhs;
+    switch (type) {
+        case TOKEN_TYPE::ADD:
+        case TOKEN_TYPE::SUB:
+        case TOKEN_TYPE::PIPE:
+            if (*rhs == 0) {
+                return operand;
+            }
+            break;
+        case TOKEN_TYPE::STAR:
+        case TOKEN_TYPE::DIV:
+            if (*rhs == 1) {
+                return operand;
+            }
+            break;
+        case TOKEN_TYPE::AMP:
+            if (*rhs == -1) {
+                return operand;
+            }
+            break;
+        default:
+            break;
+    }
+    if (lhs_pure) {
+        bool annihilates = (type == TOKEN_TYPE::STAR && *rhs == 0) || (type == TOKEN_TYPE::AMP && *rhs == 0) ||
+                           (type == TOKEN_TYPE::MOD && (*rhs == 1 || *rhs == -1)) ||
+                           (type == TOKEN_TYPE::LAND && *rhs == 0);
+        if (annihilates) {
+            return make_literal(node, 0);
+        }
+        if ((type == TOKEN_TYPE::PIPE && *rhs == -1) || (type == TOKEN_TYPE::LOR && *rhs != 0)) {
+            return make_literal(node, type == TOKEN_TYPE::PIPE ? -1 : 1);
+        }
+    }
+
+    // the operand is itself the same operation with a literal on the right, the two literals combine
+    if (is_associative(type) && node_kind(*operand) == NODE_KIND::BINARY_OPERATION &&
+        operand->m_token.m_type == type) {
+        ASTNode *inner_literal = std::get<BinaryOperation>(operand->m_members).rhs;
+        if (std::optional<int32_t> inner = literal_value(inner_literal)) {
+            std::optional<int32_t> combined = evaluate(node, *inner, *rhs);
+            inner_literal->m_token = Token(TOKEN_TYPE::INTEGER, static_cast<int>(*combined));
+            return operand;
+        }
+    }
+    return nullptr;
+}
+
+ASTNode *ConstantFolder::fold_unary(ASTNode *node) {
+    std::optional<int32_t> operand = literal_value(std::get<UnaryOperation>(node->m_members).operand);
+    if (!operand) {
+        return nullptr;
+    }
+    switch (node->m_token.m_type) {
+        case TOKEN_TYPE::SUB:
+            return make_literal(node, static_cast<int32_t>(0u - static_cast<uint32_t>(*operand)));
+        case TOKEN_TYPE::BANG:
+            return make_literal(node, *operand == 0);
+        default:
+            return nullptr;
+    }
+}
+
+ASTNode *ConstantFolder::make_literal(ASTNode *node, int32_t value) {
+    node->m_token = Token(TOKEN_TYPE::INTEGER, static_cast<int>(value));
+    node->m_members = std::monostate{};
+    return node;
+}
+
+std::optional<int32_t> ConstantFolder::evaluate(const ASTNode *node, int32_t lhs, int32_t rhs) {
+    TOKEN_TYPE type = node->m_token.m_type;
+    // + - * on the unsigned representation, which is the wrapped signed result
+    auto wrap = [](uint32_t value) { return static_cast<int32_t>(value); };
+    auto left = static_cast<uint32_t>(lhs);
+    auto right = static_cast<uint32_t>(rhs);
+    switch (type) {
+        case TOKEN_TYPE::LOR:
+            return lhs != 0 || rhs != 0;
+        case TOKEN_TYPE::LAND:
+            return lhs != 0 && rhs != 0;
+        case TOKEN_TYPE::LESS:
+            return lhs < rhs;
+        case TOKEN_TYPE::GREAT:
+            return lhs > rhs;
+        case TOKEN_TYPE::LEQ:
+            return lhs <= rhs;
+        case TOKEN_TYPE::GEQ:
+            return lhs >= rhs;
+        case TOKEN_TYPE::EQ:
+            return lhs == rhs;
+        case TOKEN_TYPE::NEQ:
+            return lhs != rhs;
+        case TOKEN_TYPE::ADD:
+            return wrap(left + right);
+        case TOKEN_TYPE::SUB:
+            return wrap(left - right);
+        case TOKEN_TYPE::STAR:
+            return wrap(left * right);
+        case TOKEN_TYPE::DIV:
+        case TOKEN_TYPE::MOD:
+            if (rhs == 0) {
+                if (m_unevaluated != 0) {
+                    return std::nullopt; // never executed, so not an error
+                }
+                m_diagnostics.report(DIVISION_BY_ZERO + std::to_string(lhs) + (type == TOKEN_TYPE::DIV ? " / 0" : " % 0"),
+                                     node_location(*node, m_source));
+                return std::nullopt;
+            }
+            // INT_MIN / -1 overflows like the other operators, the remainder is 0
+            if (lhs == INT32_MIN && rhs == -1) {
+                return type == TOKEN_TYPE::DIV ? INT32_MIN : 0;
+            }
+            return type == TOKEN_TYPE::DIV ? lhs / rhs : lhs % rhs;
+        case TOKEN_TYPE::PIPE:
+            return lhs | rhs;
+        case TOKEN_TYPE::AMP:
+            return lhs & rhs;
+        default:
+            return std::nullopt;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "ast.h"
+#include "diagnostics.h"
+
+constexpr const char *DIVISION_BY_ZERO = "division by zero in constant expression: ";
+
+/*
+ * Rewrites the trees of a translation unit, run after TypeChecker:
+ *  - operators whose operands are all integer or character literals become an INTEGER literal,
+ *    evaluated with C's int semantics: chars promote to int, / and % truncate toward zero, comparisons and
+ *    && || ! give 0 or 1. Signed overflow, which C leaves undefined, wraps like the two's complement target.
+ *    A constant division or remainder by zero is reported and left in the tree, unless it's in an operand
+ *    that && or || skip because their left operand is a constant deciding the result.
+ *  - identities drop the operation: x + 0, x - 0, x * 1, x / 1, x | 0, x & -1 become x,
+ *    while x * 0, x & 0, x % 1, x | -1, x && 0 and x || 1 become a literal once x has no side effects
+ *    (no call and no assignment in it). 0 && x and 1 || x never evaluate x and fold regardless.
+ *  - a literal operand of a commutative operator moves to the right, so the constant of x * 8 sits where
+ *    a code generator turns it into a shift, and chains such as (x + 1) + 2 combine into x + 3.
+ * A folded operation is rewritten in place and keeps the type the checker gave it, an identity replaces it with
+ * its operand in the parent, so resolved references keep their nodes.
+ */
+class ConstantFolder {
+public:
+    // source is what the trees were parsed from, to locate the diagnostics
+    void fold(NodeList &declarations, const SourceBuffer *source = nullptr);
+
+    // operations rewritten into a literal or replaced by an operand
+    size_t folded_count() const { return m_folded_count; }
+
+    const Diagnostics &diagnostics() const { return m_diagnostics; }
+
+private:
+    // node's new value when the operation folded, otherwise null. pure tells which operands are free of side effects
+    ASTNode *fold_binary(ASTNode *node, bool lhs_pure, bool rhs_pure);
+
+    ASTNode *fold_unary(ASTNode *node);
+
+    // rewrites node into an INTEGER literal holding value
+    ASTNode *make_literal(ASTNode *node, int32_t value);
+
+    // node's operator applied to lhs and rhs, none for a division by zero, which is reported at node
+    std::optional<int32_t> evaluate(const ASTNode *node, int32_t lhs, int32_t rhs);
+
+    size_t m_folded_count = 0;
+    std::vector<ASTNode **> m_child_slots; // scratch for the walk
+    size_t m_unevaluated = 0; // how many skipped && || operands the walk is in
+    Diagnostics m_diagnostics;
+    const SourceBuffer *m_source = nullptr;
+};
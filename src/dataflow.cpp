@@ -0,0 +1,245 @@
+#include "dataflow.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+DataflowSolution solve(const IrFunction &function, const DataflowProblem &problem) {
+    bool forward = problem.m_direction == DIRECTION::FORWARD;
+    BitVector initial(problem.m_universe, problem.m_meet == MEET::INTERSECTION);
+    DataflowSolution solution;
+    solution.m_in.assign(function.block_count(), initial);
+    solution.m_out.assign(function.block_count(), initial);
+    // the meet writes the sets on the side facts flow in from, the transfer function the other side
+    std::vector<BitVector> &inputs = forward ? solution.m_in : solution.m_out;
+    std::vector<BitVector> &outputs = forward ? solution.m_out : solution.m_in;
+
+    std::vector<BlockId> order = reverse_postorder(function);
+    if (!forward) {
+        std::reverse(order.begin(), order.end());
+    }
+    std::vector<uint32_t> position(function.block_count(), NO_BLOCK);
+    for (uint32_t index = 0; index < order.size(); ++index) {
+        position[order[index]] = index;
+    }
+
+    BitVector pending(order.size(), true);
+    BitVector transferred(problem.m_universe);
+    size_t cursor = 0;
+    while (true) {
+        size_t next = pending.find_next(cursor);
+        if (next == order.size()) {
+            next = pending.find_next(0);
+            if (next == order.size()) {
+                break;
+            }
+        }
+        pending.reset(next);
+        cursor = next + 1;
+
+        BlockId block = order[next];
+        const BasicBlock &basic_block = function.block(block);
+        const auto &sources = forward ? basic_block.m_predecessors : basic_block.m_successors;
+        BitVector &input = inputs[block];
+        if (forward ? block == 0 : sources.empty()) {
+            input = problem.m_boundary;
+        } else {
+            bool first = true;
+            for (BlockId source: sources) {
+                if (position[source] == NO_BLOCK) {
+                    continue;
+                }
+                if (first) {
+                    input = outputs[source];
+                    first = false;
+                } else if (problem.m_meet == MEET::UNION) {
+                    input.unite(outputs[source]);
+                } else {
+                    input.intersect(outputs[source]);
+                }
+            }
+        }
+
+        ++solution.m_visits;
+        transferred = input;
+        for (BitRange killed: problem.m_kill[block]) {
+            transferred.reset_range(killed.m_begin, killed.m_end);
+        }
+        for (BitRange generated: problem.m_gen[block]) {
+            transferred.set_range(generated.m_begin, generated.m_end);
+        }
+        if (transferred != outputs[block]) {
+            std::swap(transferred, outputs[block]);
+            for (BlockId target: forward ? basic_block.m_successors : basic_block.m_predecessors) {
+                if (position[target] != NO_BLOCK) {
+                    pending.set(position[target]);
+                }
+            }
+        }
+    }
+    return solution;
+}
+
+Liveness live_values(const IrFunction &function) {
+    Liveness liveness;
+    liveness.m_bits.assign(function.size(), NO_VALUE);
+    auto track = [&liveness](ValueId value) {
+        if (liveness.m_bits[value] == NO_VALUE) {
+            liveness.m_bits[value] = liveness.m_values.size();
+            liveness.m_values.push_back(value);
+        }
+    };
+    for (ValueId value = 0; value < function.size(); ++value) {
+        const Instruction &instruction = function.instruction(value);
+        for (ValueId operand: function.operands(value)) {
+            // a phi reads its operand at the end of a predecessor, even one which is its own block
+            if (instruction.m_opcode == OPCODE::PHI ||
+                function.instruction(operand).m_block != instruction.m_block) {
+                track(operand);
+            }
+        }
+    }
+
+    size_t universe = liveness.m_values.size();
+    DataflowProblem problem{DIRECTION::BACKWARD, MEET::UNION, universe,
+                            std::vector<std::vector<BitRange>>(function.block_count()),
+                            std::vector<std::vector<BitRange>>(function.block_count()),
+                            BitVector(universe)};
+    auto add = [](std::vector<BitRange> &set, uint32_t bit) {
+        set.push_back({bit, bit + 1});
+    };
+    for (BlockId id = 0; id < function.block_count(); ++id) {
+        const BasicBlock &block = function.block(id);
+        for (ValueId value = block.m_first_instruction;
+             value < block.m_first_instruction + block.m_instruction_count; ++value) {
+            if (liveness.m_bits[value] != NO_VALUE) {
+                add(problem.m_kill[id], liveness.m_bits[value]);
+            }
+            auto operands = function.operands(value);
+            if (function.instruction(value).m_opcode == OPCODE::PHI) {
+                // used at the end of the predecessor, upwards exposed there unless defined there
+                for (size_t index = 0; index < operands.size(); ++index) {
+                    BlockId predecessor = block.m_predecessors[index];
+                    if (function.instruction(operands[index]).m_block != predecessor) {
+                        add(problem.m_gen[predecessor], liveness.m_bits[operands[index]]);
+                    }
+                }
+                continue;
+            }
+            for (ValueId operand: operands) {
+                if (function.instruction(operand).m_block != id) {
+                    add(problem.m_gen[id], liveness.m_bits[operand]);
+                }
+            }
+        }
+    }
+
+    DataflowSolution solution = solve(function, problem);
+    liveness.m_live_in = std::move(solution.m_in);
+    liveness.m_live_out = std::move(solution.m_out);
+    liveness.m_visits = solution.m_visits;
+    // phi operands are live on their edge only, which the successor's live in doesn't carry
+    for (BlockId id = 0; id < function.block_count(); ++id) {
+        const BasicBlock &block = function.block(id);
+        for (ValueId phi = block.m_first_instruction; phi < block.m_first_instruction + block.m_phi_count; ++phi) {
+            auto operands = function.operands(phi);
+            for (size_t index = 0; index < operands.size(); ++index) {
+                liveness.m_live_out[block.m_predecessors[index]].set(liveness.m_bits[operands[index]]);
+            }
+        }
+    }
+    return liveness;
+}
+
+namespace {
+
+    constexpr uint32_t NO_LOCATION = UINT32_MAX;
+
+    // LOCAL slots by their value, globals by their symbol: a GLOBAL instruction is emitted per access
+    uint64_t location_key(const IrFunction &function, ValueId address) {
+        const Instruction &instruction = function.instruction(address);
+        if (instruction.m_opcode == OPCODE::LOCAL) {
+            return address;
+        }
+        return (uint64_t(1) << 32) | static_cast<uint32_t>(instruction.m_immediate);
+    }
+}
+
+ReachingDefinitions reaching_definitions(const IrFunction &function) {
+    // numbers the stores grouped by location so that killing a location's stores sets one range of bits
+    std::unordered_map<uint64_t, uint32_t> locations;
+    std::vector<uint32_t> store_locations(function.size(), NO_LOCATION);
+    std::vector<ValueId> stores;
+    for (ValueId value = 0; value < function.size(); ++value) {
+        if (function.instruction(value).m_opcode != OPCODE::STORE) {
+            continue;
+        }
+        stores.push_back(value);
+        ValueId address = function.operands(value)[0];
+        OPCODE opcode = function.instruction(address).m_opcode;
+        if (opcode == OPCODE::LOCAL || opcode == OPCODE::GLOBAL) {
+            store_locations[value] = locations.try_emplace(location_key(function, address), locations.size())
+                    .first->second;
+        }
+    }
+    // stores through other pointers form the last group
+    size_t group_count = locations.size() + 1;
+    std::vector<uint32_t> group_begin(group_count + 1);
+    auto group = [&](ValueId store) {
+        return store_locations[store] == NO_LOCATION ? locations.size() : store_locations[store];
+    };
+    for (ValueId store: stores) {
+        ++group_begin[group(store) + 1];
+    }
+    for (size_t index = 1; index <= group_count; ++index) {
+        group_begin[index] += group_begin[index - 1];
+    }
+    ReachingDefinitions reaching;
+    reaching.m_definitions.resize(stores.size());
+    std::vector<uint32_t> bits(function.size(), NO_VALUE);
+    {
+        std::vector<uint32_t> next_bit(group_begin.begin(), group_begin.end() - 1);
+        for (ValueId store: stores) {
+            bits[store] = next_bit[group(store)]++;
+            reaching.m_definitions[bits[store]] = store;
+        }
+    }
+
+    size_t universe = stores.size();
+    DataflowProblem problem{DIRECTION::FORWARD, MEET::UNION, universe,
+                            std::vector<std::vector<BitRange>>(function.block_count()),
+                            std::vector<std::vector<BitRange>>(function.block_count()),
+                            BitVector(universe)};
+    // the last store to each location in a block reaches its end and kills every other store to it
+    std::vector<ValueId> last_store(locations.size(), NO_VALUE);
+    std::vector<uint32_t> stored;
+    for (BlockId id = 0; id < function.block_count(); ++id) {
+        const BasicBlock &block = function.block(id);
+        for (ValueId value = block.m_first_instruction;
+             value < block.m_first_instruction + block.m_instruction_count; ++value) {
+            if (function.instruction(value).m_opcode != OPCODE::STORE) {
+                continue;
+            }
+            uint32_t location = store_locations[value];
+            if (location == NO_LOCATION) {
+                problem.m_gen[id].push_back({bits[value], bits[value] + 1});
+                continue;
+            }
+            if (last_store[location] == NO_VALUE) {
+                stored.push_back(location);
+            }
+            last_store[location] = value;
+        }
+        for (uint32_t location: stored) {
+            problem.m_kill[id].push_back({group_begin[location], group_begin[location + 1]});
+            problem.m_gen[id].push_back({bits[last_store[location]], bits[last_store[location]] + 1});
+            last_store[location] = NO_VALUE;
+        }
+        stored.clear();
+    }
+
+    DataflowSolution solution = solve(function, problem);
+    reaching.m_in = std::move(solution.m_in);
+    reaching.m_out = std::move(solution.m_out);
+    reaching.m_visits = solution.m_visits;
+    return reaching;
+}
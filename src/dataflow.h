@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "bit_vector.h"
+#include "ir.h"
+
+/*
+ * Iterative solver for gen/kill dataflow problems over an IrFunction's blocks. In and out sets are BitVectors
+ * over the problem's universe, gen and kill sets a handful of ranges each, so that the problem itself takes
+ * memory in proportion to the function rather than to blocks times universe. A forward problem flows from
+ * the entry along edges, a backward one from the blocks ending in a return against them:
+ *   forward:  in(b) = meet of out(p) over predecessors p, out(b) = gen(b) | (in(b) & ~kill(b))
+ *   backward: out(b) = meet of in(s) over successors s,  in(b) = gen(b) | (out(b) & ~kill(b))
+ * The worklist is a bit per block indexed by reverse postorder position (postorder for backward problems)
+ * and is drained from a cursor sweeping that order, so each pass sees a block after the blocks flowing into
+ * it and an acyclic region settles in one pass. Blocks unreachable from the entry keep their initial sets.
+ */
+
+enum class DIRECTION {
+    FORWARD,
+    BACKWARD,
+};
+
+enum class MEET {
+    UNION,        // a fact holding along some path, sets start empty
+    INTERSECTION, // a fact holding along every path, sets start full
+};
+
+// the members [begin, end) of a universe
+struct BitRange {
+    uint32_t m_begin;
+    uint32_t m_end;
+
+    bool operator==(const BitRange &other) const = default;
+};
+
+struct DataflowProblem {
+    DIRECTION m_direction;
+    MEET m_meet;
+    size_t m_universe;
+    std::vector<std::vector<BitRange>> m_gen; // per block
+    std::vector<std::vector<BitRange>> m_kill;
+    BitVector m_boundary; // in of the entry going forward, out of the exiting blocks going backward
+};
+
+struct DataflowSolution {
+    std::vector<BitVector> m_in; // per block
+    std::vector<BitVector> m_out;
+    size_t m_visits = 0; // transfer functions applied
+};
+
+DataflowSolution solve(const IrFunction &function, const DataflowProblem &problem);
+
+/*
+ * Values live into and out of each block. Only values used outside the block defining them can be live
+ * there, so the sets are over those alone: bit i stands for m_values[i].
+ * A phi operand is live out of the predecessor it flows in from, not into the phi's block.
+ */
+struct Liveness {
+    std::vector<ValueId> m_values;
+    std::vector<uint32_t> m_bits; // per value, NO_VALUE for the ones never live across a block boundary
+    std::vector<BitVector> m_live_in;
+    std::vector<BitVector> m_live_out;
+    size_t m_visits = 0;
+
+    bool live_in(BlockId block, ValueId value) const {
+        return m_bits[value] != NO_VALUE && m_live_in[block].test(m_bits[value]);
+    }
+
+    bool live_out(BlockId block, ValueId value) const {
+        return m_bits[value] != NO_VALUE && m_live_out[block].test(m_bits[value]);
+    }
+};
+
+Liveness live_values(const IrFunction &function);
+
+/*
+ * Stores reaching the start and end of each block: bit i stands for the store m_definitions[i].
+ * A store to a LOCAL slot or to a global kills the other stores to it, one through any other pointer may
+ * write anywhere and kills nothing.
+ */
+struct ReachingDefinitions {
+    std::vector<ValueId> m_definitions;
+    std::vector<BitVector> m_in;
+    std::vector<BitVector> m_out;
+    size_t m_visits = 0;
+};
+
+ReachingDefinitions reaching_definitions(const IrFunction &function);
@@ -0,0 +1,11 @@
+#include "diagnostics.h"
+
+void Diagnostics::print(std::ostream &out, std::string_view path) const {
+    for (const auto &diagnostic: m_diagnostics) {
+        out << path << ":";
+        if (diagnostic.m_location) {
+            out << diagnostic.m_location->m_line << ":" << diagnostic.m_location->m_column << ":";
+        }
+        out << " error: " << diagnostic.m_message << "\n";
+    }
+}
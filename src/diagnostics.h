@@ -0,0 +1,89 @@
+#pragma once
+
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "source_location.h"
+
+// an error in the program being compiled, located when the reporter knew where it was
+struct Diagnostic {
+    std::string m_message;
+    std::optional<SourceLocation> m_location;
+
+    bool operator==(const Diagnostic &other) const = default;
+};
+
+/*
+ * Errors collected over a whole run instead of thrown at the first one,
+ * kept in the order they were reported.
+ */
+class Diagnostics {
+public:
+    void report(Diagnostic diagnostic) { m_diagnostics.push_back(std::move(diagnostic)); }
+
+    void report(std::string message, std::optional<SourceLocation> location = std::nullopt) {
+        m_diagnostics.push_back({std::move(message), location});
+    }
+
+    void append(const Diagnostics &other) {
+        m_diagnostics.insert(m_diagnostics.end(), other.m_diagnostics.begin(), other.m_diagnostics.end());
+    }
+
+    void clear() { m_diagnostics.clear(); }
+
+    // drops everything reported after the first count diagnostics
+    void truncate(size_t count) { m_diagnostics.resize(count); }
+
+    bool empty() const { return m_diagnostics.empty(); }
+
+    size_t size() const { return m_diagnostics.size(); }
+
+    const Diagnostic &operator[](size_t index) const { return m_diagnostics[index]; }
+
+    auto begin() const { return m_diagnostics.begin(); }
+
+    auto end() const { return m_diagnostics.end(); }
+
+    // one "path:line:column: error: message" line per diagnostic
+    void print(std::ostream &out, std::string_view path) const;
+
+private:
+    std::vector<Diagnostic> m_diagnostics;
+};
+
+/*
+ * Either a value or the diagnostic explaining why there's none, returned instead of throwing.
+ * Callers check it with operator bool and pass the error on or report it.
+ */
+template<typename T>
+class Result {
+public:
+    Result(T value) : m_value(std::move(value)) {}
+
+    Result(Diagnostic error) : m_value(std::move(error)) {}
+
+    bool has_value() const { return m_value.index() == 0; }
+
+    explicit operator bool() const { return has_value(); }
+
+    T &value() { return std::get<0>(m_value); }
+
+    const T &value() const { return std::get<0>(m_value); }
+
+    T &operator*() { return value(); }
+
+    const T &operator*() const { return value(); }
+
+    // for results holding a pointer
+    T operator->() const { return value(); }
+
+    const Diagnostic &error() const { return std::get<1>(m_value); }
+
+private:
+    std::variant<T, Diagnostic> m_value;
+};
@@ -2,6 +2,9 @@
 
 CompilerException::CompilerException(const char* msg): m_message(msg) {}
 
-const char *CompilerException::what() {
+CompilerException::CompilerException(const char* msg, SourceLocation location): m_message(msg),
+                                                                              m_location(location) {}
+
+const char *CompilerException::what() const noexcept {
     return m_message.c_str();
 }
@@ -1,11 +1,24 @@
+#pragma once
+
 #include <exception>
+#include <optional>
 #include <string>
 
+#include "source_location.h"
+
 
-class CompilerException : std::exception {
+/*
+ * Fatal errors only: the source can't be read, an API is misused.
+ * Errors in the program being compiled are reported through Diagnostics instead.
+ */
+class CompilerException : public std::exception {
 public:
     explicit CompilerException(const char* msg);
-    const char* what();
+    CompilerException(const char* msg, SourceLocation location);
+    const char* what() const noexcept override;
+    // where in the source the error was found, when the thrower knew
+    const std::optional<SourceLocation> &location() const { return m_location; }
 private:
-    const std::string m_message;
-};
\ No newline at end of file
+    std::string m_message;
+    std::optional<SourceLocation> m_location;
+};
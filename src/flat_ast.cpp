@@ -0,0 +1,117 @@
+#include "flat_ast.h"
+#include "token_stream.h"
+
+NodeId FlatAst::add_tree(const ASTNode *root) {
+    // an explicit stack instead of recursion, trees nest as deep as the parser allows
+    struct OpenNode {
+        NodeId m_id;
+        std::vector<const ASTNode *> m_children;
+        std::vector<NodeId> m_child_ids;
+    };
+    std::vector<OpenNode> open;
+    auto begin_node = [&](const ASTNode &node) {
+        OpenNode opened{static_cast<NodeId>(m_kinds.size()), {}, {}};
+        add_node(node, opened.m_children);
+        opened.m_child_ids.reserve(opened.m_children.size());
+        open.push_back(std::move(opened));
+        return open.back().m_id;
+    };
+
+    NodeId root_id = begin_node(*root);
+    while (!open.empty()) {
+        OpenNode &top = open.back();
+        if (top.m_child_ids.size() < top.m_children.size()) {
+            const ASTNode *child = top.m_children[top.m_child_ids.size()];
+            NodeId child_id = static_cast<NodeId>(m_kinds.size());
+            top.m_child_ids.push_back(child_id);
+            begin_node(*child);
+            continue;
+        }
+        // children are numbered right after their parent, their ids are known once each subtree is in
+        m_first_child[top.m_id] = m_children.size();
+        m_children.insert(m_children.end(), top.m_child_ids.begin(), top.m_child_ids.end());
+        open.pop_back();
+    }
+    m_roots.push_back(root_id);
+    return root_id;
+}
+
+size_t FlatAst::memory_usage() const {
+    return m_roots.capacity() * sizeof(NodeId) +
+           m_kinds.capacity() * sizeof(NODE_KIND) +
+           m_token_types.capacity() * sizeof(TOKEN_TYPE) +
+           m_token_payloads.capacity() * sizeof(uint32_t) +
+           m_offsets.capacity() * sizeof(uint32_t) +
+           m_first_child.capacity() * sizeof(uint32_t) +
+           m_child_counts.capacity() * sizeof(uint32_t) +
+           m_first_extra.capacity() * sizeof(uint32_t) +
+           m_extra_counts.capacity() * sizeof(uint32_t) +
+           m_children.capacity() * sizeof(NodeId) +
+           m_extra_types.capacity() * sizeof(TOKEN_TYPE) +
+           m_extra_payloads.capacity() * sizeof(uint32_t) +
+           m_extra_pointer_depths.capacity() * sizeof(uint8_t);
+}
+
+uint32_t FlatAst::pack(const Token &token) {
+    switch (token.m_value.index()) {
+        case 0: // int
+            return static_cast<uint32_t>(std::get<int>(token.m_value));
+        case 1: // symbol
+            return std::get<Symbol>(token.m_value).m_id;
+        default: // char
+            return static_cast<unsigned char>(std::get<char>(token.m_value));
+    }
+}
+
+Token FlatAst::unpack(TOKEN_TYPE type, uint32_t payload) {
+    return TokenView{type, {}, payload};
+}
+
+void FlatAst::add_node(const ASTNode &node, std::vector<const ASTNode *> &children) {
+    m_kinds.push_back(node_kind(node));
+    m_token_types.push_back(node.m_token.m_type);
+    m_token_payloads.push_back(pack(node.m_token));
+    m_offsets.push_back(node.m_offset);
+
+    std::vector<const TypeName *> extras;
+    if (const auto *operation = std::get_if<BinaryOperation>(&node.m_members)) {
+        children = {operation->lhs, operation->rhs};
+    } else if (const auto *unary = std::get_if<UnaryOperation>(&node.m_members)) {
+        children = {unary->operand};
+    } else if (const auto *call = std::get_if<FuncCall>(&node.m_members)) {
+        children.assign(call->arg.begin(), call->arg.end());
+    } else if (const auto *block = std::get_if<Block>(&node.m_members)) {
+        children.assign(block->statements.begin(), block->statements.end());
+    } else if (const auto *variable = std::get_if<VariableDeclaration>(&node.m_members)) {
+        extras.push_back(&variable->type);
+    } else if (const auto *function = std::get_if<FuncDeclaration>(&node.m_members)) {
+        extras.push_back(&function->return_type);
+        children.assign(function->params.begin(), function->params.end());
+        if (function->body) {
+            children.push_back(function->body);
+        }
+    } else if (const auto *if_statement = std::get_if<IfStatement>(&node.m_members)) {
+        children = {if_statement->condition, if_statement->then_branch};
+        if (if_statement->else_branch) {
+            children.push_back(if_statement->else_branch);
+        }
+    } else if (const auto *loop = std::get_if<WhileLoop>(&node.m_members)) {
+        children = {loop->condition, loop->body};
+    } else if (const auto *return_statement = std::get_if<ReturnStatement>(&node.m_members)) {
+        if (return_statement->value) {
+            children = {return_statement->value};
+        }
+    }
+
+    m_first_extra.push_back(m_extra_types.size());
+    m_extra_counts.push_back(extras.size());
+    for (const TypeName *extra: extras) {
+        m_extra_types.push_back(extra->base.m_type);
+        m_extra_payloads.push_back(pack(extra->base));
+        m_extra_pointer_depths.push_back(extra->pointer_depth);
+    }
+
+    // filled in by add_tree once the children are in
+    m_first_child.push_back(0);
+    m_child_counts.push_back(children.size());
+}
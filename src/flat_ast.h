@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ast.h"
+
+using NodeId = uint32_t;
+
+/*
+ * The same tree as ASTNode, flattened into parallel arrays indexed by 32 bit node ids.
+ * Nodes are numbered in pre-order, so walking ids 0..size() visits parents before their children
+ * in memory order. A node's children are a contiguous range of ids in the child table, declared types
+ * a node carries besides its own token are a range in the extra table.
+ * Tokens are stored packed, kind plus the same 32 bit payload a TokenStream uses, next to the byte offset
+ * the node's token starts at, so the arrays don't point anywhere and can be written out as they are.
+ */
+class FlatAst {
+public:
+    // flattens the tree under root after the nodes already added, returns the id root got
+    NodeId add_tree(const ASTNode *root);
+
+    // ids of the trees added so far, in the order they were added
+    const std::vector<NodeId> &roots() const { return m_roots; }
+
+    size_t size() const { return m_kinds.size(); }
+
+    NODE_KIND kind(NodeId id) const { return m_kinds[id]; }
+
+    Token token(NodeId id) const { return unpack(m_token_types[id], m_token_payloads[id]); }
+
+    uint32_t offset(NodeId id) const { return m_offsets[id]; }
+
+    uint32_t child_count(NodeId id) const { return m_child_counts[id]; }
+
+    NodeId child(NodeId id, uint32_t index) const { return m_children[m_first_child[id] + index]; }
+
+    uint32_t extra_count(NodeId id) const { return m_extra_counts[id]; }
+
+    TypeName extra(NodeId id, uint32_t index) const {
+        uint32_t position = m_first_extra[id] + index;
+        return {unpack(m_extra_types[position], m_extra_payloads[position]), m_extra_pointer_depths[position]};
+    }
+
+    // heap bytes held by all the arrays
+    size_t memory_usage() const;
+
+private:
+    static uint32_t pack(const Token &token);
+
+    static Token unpack(TOKEN_TYPE type, uint32_t payload);
+
+    // appends node's own entries and hands back the children it still needs
+    void add_node(const ASTNode &node, std::vector<const ASTNode *> &children);
+
+    friend class AstCache; // writes the arrays out as they are
+
+    std::vector<NodeId> m_roots;
+
+    // per node
+    std::vector<NODE_KIND> m_kinds;
+    std::vector<TOKEN_TYPE> m_token_types;
+    std::vector<uint32_t> m_token_payloads;
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_first_child;
+    std::vector<uint32_t> m_child_counts;
+    std::vector<uint32_t> m_first_extra;
+    std::vector<uint32_t> m_extra_counts;
+
+    // side tables
+    std::vector<NodeId> m_children;
+    std::vector<TOKEN_TYPE> m_extra_types;
+    std::vector<uint32_t> m_extra_payloads;
+    std::vector<uint8_t> m_extra_pointer_depths;
+};
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstring>
+
+#include "interner.h"
+#include "exceptions.h"
+
+Interner &Interner::global() {
+    static Interner interner;
+    return interner;
+}
+
+Interner::Interner() : m_slots(1024, Slot{0, EMPTY_SLOT}),
+                       m_spellings(std::make_unique<std::unique_ptr<std::string_view[]>[]>(MAX_SPELLING_CHUNKS)) {
+    intern("");
+}
+
+uint32_t Interner::intern(std::string_view text, uint32_t text_hash) {
+    std::lock_guard lock(m_mutex);
+
+    size_t mask = m_slots.size() - 1;
+    for (size_t index = text_hash & mask;; index = (index + 1) & mask) {
+        Slot &slot = m_slots[index];
+        if (slot.m_id == EMPTY_SLOT) {
+            break;
+        }
+        if (slot.m_hash == text_hash && spelling(slot.m_id) == text) {
+            return slot.m_id;
+        }
+    }
+
+    auto id = static_cast<uint32_t>(m_size.load(std::memory_order_relaxed));
+    if ((id >> SPELLING_CHUNK_BITS) >= MAX_SPELLING_CHUNKS) {
+        throw CompilerException(TOO_MANY_SPELLINGS);
+    }
+    auto &chunk = m_spellings[id >> SPELLING_CHUNK_BITS];
+    if (!chunk) {
+        chunk = std::make_unique<std::string_view[]>(SPELLING_CHUNK_SIZE);
+    }
+    chunk[id & (SPELLING_CHUNK_SIZE - 1)] = store(text);
+    m_size.store(id + 1, std::memory_order_release);
+
+    // keep the load factor under one half
+    if ((id + 1) * 2 > m_slots.size()) {
+        grow_table();
+        mask = m_slots.size() - 1;
+    }
+    size_t index = text_hash & mask;
+    while (m_slots[index].m_id != EMPTY_SLOT) {
+        index = (index + 1) & mask;
+    }
+    m_slots[index] = {text_hash, id};
+
+    return id;
+}
+
+std::string_view Interner::store(std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+    if (text.size() > m_block_remaining) {
+        size_t block_size = std::max(ARENA_BLOCK_SIZE, text.size());
+        m_blocks.push_back(std::make_unique<char[]>(block_size));
+        m_block_cursor = m_blocks.back().get();
+        m_block_remaining = block_size;
+    }
+    std::memcpy(m_block_cursor, text.data(), text.size());
+    std::string_view stored(m_block_cursor, text.size());
+    m_block_cursor += text.size();
+    m_block_remaining -= text.size();
+    return stored;
+}
+
+void Interner::grow_table() {
+    std::vector<Slot> slots(m_slots.size() * 2, Slot{0, EMPTY_SLOT});
+    size_t mask = slots.size() - 1;
+    for (const auto &slot: m_slots) {
+        if (slot.m_id == EMPTY_SLOT) {
+            continue;
+        }
+        size_t index = slot.m_hash & mask;
+        while (slots[index].m_id != EMPTY_SLOT) {
+            index = (index + 1) & mask;
+        }
+        slots[index] = slot;
+    }
+    m_slots = std::move(slots);
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr const char *TOO_MANY_SPELLINGS = "interner is out of spelling ids";
+
+/*
+ * Maps every distinct spelling to a stable 32 bit id.
+ * Spellings are copied once into an arena and never move, the lookup table is open addressed with linear probing.
+ * Interning is serialized by a mutex, reading a spelling back is lock free.
+ */
+class Interner {
+public:
+    static Interner &global();
+
+    Interner();
+
+    Interner(const Interner &) = delete;
+
+    Interner &operator=(const Interner &) = delete;
+
+    uint32_t intern(std::string_view text) { return intern(text, hash(text)); }
+
+    uint32_t intern(std::string_view text, uint32_t text_hash);
+
+    static uint32_t hash(std::string_view text) {
+        // FNV-1a, identifiers are short enough that a byte loop wins over anything fancier
+        uint32_t value = 2166136261u;
+        for (unsigned char c: text) {
+            value = (value ^ c) * 16777619u;
+        }
+        return value;
+    }
+
+    std::string_view spelling(uint32_t id) const {
+        return m_spellings[id >> SPELLING_CHUNK_BITS][id & (SPELLING_CHUNK_SIZE - 1)];
+    }
+
+    size_t size() const { return m_size.load(std::memory_order_acquire); }
+
+private:
+    static constexpr uint32_t SPELLING_CHUNK_BITS = 16;
+    static constexpr uint32_t SPELLING_CHUNK_SIZE = 1 << SPELLING_CHUNK_BITS;
+    static constexpr uint32_t MAX_SPELLING_CHUNKS = 1 << 12;
+    static constexpr size_t ARENA_BLOCK_SIZE = 1 << 16;
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    struct Slot {
+        uint32_t m_hash;
+        uint32_t m_id;
+    };
+
+    std::string_view store(std::string_view text);
+
+    void grow_table();
+
+    std::mutex m_mutex;
+    std::vector<Slot> m_slots;
+    std::atomic<size_t> m_size = 0;
+
+    // arena holding the spellings
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    char *m_block_cursor = nullptr;
+    size_t m_block_remaining = 0;
+
+    // chunks are never reallocated so readers don't need the lock
+    std::unique_ptr<std::unique_ptr<std::string_view[]>[]> m_spellings;
+};
+
+/*
+ * Small direct mapped cache in front of an Interner, owned by a single thread.
+ * Source code repeats the same few identifiers over and over, most lookups never reach the shared table.
+ */
+class SymbolCache {
+public:
+    explicit SymbolCache(Interner &interner = Interner::global()) : m_interner(interner) {}
+
+    uint32_t intern(std::string_view text) {
+        uint32_t text_hash = Interner::hash(text);
+        Entry &entry = m_entries[text_hash & (CACHE_SIZE - 1)];
+        if (entry.m_hash != text_hash || entry.m_spelling != text) {
+            entry.m_id = m_interner.intern(text, text_hash);
+            entry.m_hash = text_hash;
+            entry.m_spelling = m_interner.spelling(entry.m_id);
+        }
+        return entry.m_id;
+    }
+
+private:
+    static constexpr size_t CACHE_SIZE = 1024;
+
+    struct Entry {
+        uint32_t m_hash = 0;
+        uint32_t m_id = 0;
+        std::string_view m_spelling;
+    };
+
+    Interner &m_interner;
+    std::array<Entry, CACHE_SIZE> m_entries{};
+};
+
+/*
+ * Interned identifier / string literal / operator spelling.
+ * Comparing two symbols is a single integer compare.
+ */
+struct Symbol {
+    Symbol() = default;
+
+    Symbol(const char *text) : m_id(Interner::global().intern(text)) {} // NOLINT(google-explicit-constructor)
+
+    Symbol(const std::string &text) : m_id(Interner::global().intern(text)) {} // NOLINT(google-explicit-constructor)
+
+    explicit Symbol(std::string_view text) : m_id(Interner::global().intern(text)) {}
+
+    static Symbol from_id(uint32_t id) {
+        Symbol symbol;
+        symbol.m_id = id;
+        return symbol;
+    }
+
+    std::string_view text() const { return Interner::global().spelling(m_id); }
+
+    bool operator==(const Symbol &other) const { return m_id == other.m_id; }
+
+    uint32_t m_id = 0; // id 0 is always the empty spelling
+};
@@ -0,0 +1,169 @@
+#include "ir.h"
+
+#include <array>
+
+namespace {
+
+    constexpr std::array OPCODE_NAMES = {
+            "const", "undef", "param", "phi", "add", "sub", "mul", "div", "mod", "and", "or", "eq", "neq", "less",
+            "great", "leq", "geq", "neg", "convert", "local", "global", "string", "element", "load", "store",
+            "call", "jump", "branch", "return",
+    };
+    static_assert(OPCODE_NAMES.size() == static_cast<size_t>(OPCODE::RETURN) + 1);
+
+    std::string value_name(ValueId value) {
+        return "%" + std::to_string(value);
+    }
+
+    std::string block_name(BlockId block) {
+        return "bb" + std::to_string(block);
+    }
+}
+
+const char *opcode_name(OPCODE opcode) {
+    return OPCODE_NAMES[static_cast<size_t>(opcode)];
+}
+
+std::vector<BlockId> reverse_postorder(const IrFunction &function) {
+    // depth first over an explicit stack of (block, next successor to visit)
+    std::vector<BlockId> postorder;
+    if (function.m_blocks.empty()) {
+        return postorder;
+    }
+    std::vector<bool> visited(function.block_count());
+    std::vector<std::pair<BlockId, uint32_t>> stack = {{0, 0}};
+    visited[0] = true;
+    while (!stack.empty()) {
+        auto &[block, next] = stack.back();
+        const auto &successors = function.block(block).m_successors;
+        if (next == successors.size()) {
+            postorder.push_back(block);
+            stack.pop_back();
+            continue;
+        }
+        BlockId successor = successors[next++];
+        if (!visited[successor]) {
+            visited[successor] = true;
+            stack.emplace_back(successor, 0);
+        }
+    }
+    return {postorder.rbegin(), postorder.rend()};
+}
+
+std::vector<BlockId> immediate_dominators(const IrFunction &function) {
+    std::vector<BlockId> order = reverse_postorder(function);
+    std::vector<uint32_t> position(function.block_count(), NO_BLOCK);
+    for (uint32_t index = 0; index < order.size(); ++index) {
+        position[order[index]] = index;
+    }
+    std::vector<BlockId> dominators(function.block_count(), NO_BLOCK);
+    if (order.empty()) {
+        return dominators;
+    }
+    dominators[0] = 0;
+    // walks both fingers up the tree built so far until they meet
+    auto intersect = [&](BlockId first, BlockId second) {
+        while (first != second) {
+            while (position[first] > position[second]) {
+                first = dominators[first];
+            }
+            while (position[second] > position[first]) {
+                second = dominators[second];
+            }
+        }
+        return first;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t index = 1; index < order.size(); ++index) {
+            BlockId block = order[index];
+            BlockId dominator = NO_BLOCK;
+            for (BlockId predecessor: function.block(block).m_predecessors) {
+                if (dominators[predecessor] == NO_BLOCK) {
+                    continue;
+                }
+                dominator = dominator == NO_BLOCK ? predecessor : intersect(predecessor, dominator);
+            }
+            if (dominators[block] != dominator) {
+                dominators[block] = dominator;
+                changed = true;
+            }
+        }
+    }
+    return dominators;
+}
+
+std::string dump(const IrFunction &function, const TypeTable &types) {
+    std::string text = "function " + std::string(function.m_name.text()) + ": " + types.to_string(function.m_type) +
+                       "\n";
+    for (BlockId id = 0; id < function.block_count(); ++id) {
+        const BasicBlock &block = function.block(id);
+        text += block_name(id) + ":";
+        for (size_t index = 0; index < block.m_predecessors.size(); ++index) {
+            text += (index == 0 ? " ; preds " : ", ") + block_name(block.m_predecessors[index]);
+        }
+        text += "\n";
+
+        for (ValueId value = block.m_first_instruction;
+             value < block.m_first_instruction + block.m_instruction_count; ++value) {
+            const Instruction &instruction = function.instruction(value);
+            auto operands = function.operands(value);
+            text += "    ";
+            if (instruction.m_type != TypeTable::VOID_TYPE) {
+                text += value_name(value) + " = ";
+            }
+            text += opcode_name(instruction.m_opcode);
+            if (instruction.m_type != TypeTable::VOID_TYPE) {
+                text += " " + types.to_string(instruction.m_type);
+            }
+
+            std::string arguments;
+            auto separate = [&arguments] {
+                arguments += arguments.empty() ? " " : ", ";
+            };
+            switch (instruction.m_opcode) {
+                case OPCODE::CONST:
+                case OPCODE::PARAM:
+                    separate();
+                    arguments += std::to_string(instruction.m_immediate);
+                    break;
+                case OPCODE::GLOBAL:
+                    separate();
+                    arguments += "@" + std::string(Symbol::from_id(instruction.m_immediate).text());
+                    break;
+                case OPCODE::STRING:
+                    separate();
+                    arguments += "\"" + std::string(Symbol::from_id(instruction.m_immediate).text()) + "\"";
+                    break;
+                case OPCODE::PHI:
+                    for (size_t index = 0; index < operands.size(); ++index) {
+                        separate();
+                        arguments += "[" + value_name(operands[index]) + ", " +
+                                     block_name(block.m_predecessors[index]) + "]";
+                    }
+                    break;
+                case OPCODE::CALL:
+                    arguments += " " + std::string(Symbol::from_id(instruction.m_immediate).text()) + "(";
+                    for (size_t index = 0; index < operands.size(); ++index) {
+                        arguments += (index == 0 ? "" : ", ") + value_name(operands[index]);
+                    }
+                    arguments += ")";
+                    break;
+                default:
+                    for (ValueId operand: operands) {
+                        separate();
+                        arguments += value_name(operand);
+                    }
+            }
+            if (instruction.m_opcode == OPCODE::JUMP || instruction.m_opcode == OPCODE::BRANCH) {
+                for (BlockId successor: block.m_successors) {
+                    separate();
+                    arguments += block_name(successor);
+                }
+            }
+            text += arguments + "\n";
+        }
+    }
+    return text;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "interner.h"
+#include "types.h"
+
+/*
+ * SSA intermediate representation, one IrFunction per function definition.
+ * A function keeps all of its instructions in one array and all of their operands in another, both
+ * allocated once for the whole function. Instructions are numbered densely from 0 in block order, a block
+ * being the range of instructions [first, first + count) with its phis at the front and its terminator last,
+ * so an instruction's id is also its position and the value it defines.
+ * Control flow lives in the blocks: a jump goes to the block's only successor, a branch to its first
+ * successor when its operand is non zero and to its second otherwise. A phi has one operand per predecessor,
+ * in the order of the block's predecessors.
+ */
+
+using ValueId = uint32_t;
+using BlockId = uint32_t;
+
+constexpr ValueId NO_VALUE = UINT32_MAX;
+constexpr BlockId NO_BLOCK = UINT32_MAX;
+
+enum class OPCODE : uint8_t {
+    CONST,   // immediate is the value
+    UNDEF,   // a variable read before it was written
+    PARAM,   // immediate is the parameter's index
+    PHI,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    MOD,
+    AND,
+    OR,
+    EQ,
+    NEQ,
+    LESS,
+    GREAT,
+    LEQ,
+    GEQ,
+    NEG,
+    CONVERT, // int <-> char, the operand in the instruction's type
+    LOCAL,   // stack slot of a variable whose address is taken, its address
+    GLOBAL,  // address of a file scope variable, immediate is its name's symbol id
+    STRING,  // address of a string literal, immediate is its symbol id
+    ELEMENT, // address of element operand 1 of the array at operand 0, immediate is the element size
+    LOAD,    // from the address operand
+    STORE,   // operand 1 to the address operand 0
+    CALL,    // immediate is the callee's symbol id, operands are the arguments
+    JUMP,
+    BRANCH,
+    RETURN,  // with the returned value as the operand, if any
+};
+
+const char *opcode_name(OPCODE opcode);
+
+// ends a block
+inline bool is_terminator(OPCODE opcode) {
+    return opcode == OPCODE::JUMP || opcode == OPCODE::BRANCH || opcode == OPCODE::RETURN;
+}
+
+// defines no value
+inline bool is_void(OPCODE opcode) {
+    return opcode == OPCODE::STORE || is_terminator(opcode);
+}
+
+struct Instruction {
+    OPCODE m_opcode;
+    TypeId m_type; // of the value defined, VOID_TYPE for instructions defining none
+    BlockId m_block;
+    uint32_t m_first_operand; // into IrFunction's operand array
+    uint32_t m_operand_count;
+    int32_t m_immediate;
+};
+
+struct BasicBlock {
+    ValueId m_first_instruction;
+    uint32_t m_phi_count;
+    uint32_t m_instruction_count; // phis included
+    std::vector<BlockId> m_predecessors;
+    std::vector<BlockId> m_successors;
+};
+
+class IrFunction {
+public:
+    Symbol m_name;
+    TypeId m_type; // the function's type, parameter types included
+    std::vector<Instruction> m_instructions;
+    std::vector<ValueId> m_operands;
+    std::vector<BasicBlock> m_blocks; // the entry block first
+
+    size_t size() const { return m_instructions.size(); }
+
+    const Instruction &instruction(ValueId value) const { return m_instructions[value]; }
+
+    std::span<const ValueId> operands(ValueId value) const {
+        const Instruction &defined = m_instructions[value];
+        return {m_operands.data() + defined.m_first_operand, defined.m_operand_count};
+    }
+
+    const BasicBlock &block(BlockId id) const { return m_blocks[id]; }
+
+    size_t block_count() const { return m_blocks.size(); }
+};
+
+// blocks reachable from the entry, each before its successors unless the edge is a back edge
+std::vector<BlockId> reverse_postorder(const IrFunction &function);
+
+/*
+ * Each block's immediate dominator, the entry's being itself and an unreachable block's NO_BLOCK.
+ * Cooper, Harvey and Kennedy's iteration over the reverse postorder ("A Simple, Fast Dominance Algorithm").
+ */
+std::vector<BlockId> immediate_dominators(const IrFunction &function);
+
+/*
+ * Textual form, one block per paragraph:
+ *   bb1: ; preds bb0, bb2
+ *       %4 = phi int [%1, bb0], [%9, bb2]
+ *       branch %5, bb2, bb3
+ * types spelled as in C.
+ */
+std::string dump(const IrFunction &function, const TypeTable &types);
@@ -0,0 +1,788 @@
+#include "ir_builder.h"
+
+#include <algorithm>
+
+#include "ast_visitor.h"
+
+namespace {
+
+    // how the value of a node is wanted
+    enum class CONTEXT : uint8_t {
+        STATEMENT, // not at all: an expression statement's value is dropped
+        VALUE,
+        ADDRESS,   // the address of an lvalue, other expressions give their value instead
+        TARGET,    // a variable kept as SSA values being assigned, nothing to compute
+    };
+
+    OPCODE arithmetic_opcode(TOKEN_TYPE type) {
+        switch (type) {
+            case TOKEN_TYPE::ADD:
+                return OPCODE::ADD;
+            case TOKEN_TYPE::SUB:
+                return OPCODE::SUB;
+            case TOKEN_TYPE::STAR:
+                return OPCODE::MUL;
+            case TOKEN_TYPE::DIV:
+                return OPCODE::DIV;
+            case TOKEN_TYPE::MOD:
+                return OPCODE::MOD;
+            case TOKEN_TYPE::AMP:
+                return OPCODE::AND;
+            case TOKEN_TYPE::PIPE:
+                return OPCODE::OR;
+            case TOKEN_TYPE::EQ:
+                return OPCODE::EQ;
+            case TOKEN_TYPE::NEQ:
+                return OPCODE::NEQ;
+            case TOKEN_TYPE::LESS:
+                return OPCODE::LESS;
+            case TOKEN_TYPE::GREAT:
+                return OPCODE::GREAT;
+            case TOKEN_TYPE::LEQ:
+                return OPCODE::LEQ;
+            default:
+                return OPCODE::GEQ;
+        }
+    }
+
+    bool is_expression(NODE_KIND kind) {
+        return kind == NODE_KIND::LEAF || kind == NODE_KIND::BINARY_OPERATION || kind == NODE_KIND::UNARY_OPERATION ||
+               kind == NODE_KIND::FUNC_CALL;
+    }
+
+    bool is_lvalue(const ASTNode *node) {
+        switch (node_kind(*node)) {
+            case NODE_KIND::VARIABLE_DECLARATION:
+                return true;
+            case NODE_KIND::LEAF:
+                return node->m_token.m_type == TOKEN_TYPE::IDENTIFIER;
+            case NODE_KIND::UNARY_OPERATION:
+                return node->m_token.m_type == TOKEN_TYPE::DEREF;
+            case NODE_KIND::BINARY_OPERATION:
+                return node->m_token.m_type == TOKEN_TYPE::LBRACKET;
+            default:
+                return false;
+        }
+    }
+}
+
+std::vector<IrFunction> IrBuilder::lower(const NodeList &declarations) {
+    m_globals.clear();
+    for (const ASTNode *declaration: declarations) {
+        if (node_kind(*declaration) == NODE_KIND::BINARY_OPERATION) {
+            declaration = std::get<BinaryOperation>(declaration->m_members).lhs;
+        }
+        if (node_kind(*declaration) == NODE_KIND::VARIABLE_DECLARATION) {
+            m_globals.insert(declaration);
+        }
+    }
+
+    std::vector<IrFunction> functions;
+    for (const ASTNode *declaration: declarations) {
+        if (node_kind(*declaration) == NODE_KIND::FUNC_DECLARATION &&
+            std::get<FuncDeclaration>(declaration->m_members).body) {
+            functions.push_back(lower_function(declaration));
+        }
+    }
+    return functions;
+}
+
+IrFunction IrBuilder::lower_function(const ASTNode *definition) {
+    m_instructions.clear();
+    m_operands.clear();
+    m_phi_operands.clear();
+    m_blocks.clear();
+    m_variables.clear();
+    m_variable_types.clear();
+    m_slots.clear();
+    m_definitions.clear();
+    m_pending_phis.clear();
+    m_loops.clear();
+    m_undefs.clear();
+    m_current = new_block(true);
+
+    const auto &function = std::get<FuncDeclaration>(definition->m_members);
+    auto param_types = m_types.params(type_of(definition));
+    for (uint32_t index = 0; index < param_types.size(); ++index) {
+        const ASTNode *param = function.params[index];
+        ValueId value = emit(OPCODE::PARAM, param_types[index], {}, static_cast<int32_t>(index));
+        write_variable(variable(param), m_current, value);
+    }
+
+    // locals whose address is taken can't be SSA values, they get a slot for the whole function
+    struct AddressTaken {
+        IrBuilder &m_builder;
+        std::vector<const ASTNode *> m_declarations;
+
+        void enter(TreeNode node) {
+            if (node.kind() != NODE_KIND::UNARY_OPERATION || node.token().m_type != TOKEN_TYPE::ADDRESSOF ||
+                node.child(0).kind() != NODE_KIND::LEAF) {
+                return;
+            }
+            const ASTNode *declaration = m_builder.m_resolver.declaration_of(node.child(0).node());
+            if (declaration && !m_builder.m_globals.contains(declaration) && !m_builder.m_slots.contains(declaration)) {
+                m_builder.m_slots.emplace(declaration, NO_VALUE);
+                m_declarations.push_back(declaration);
+            }
+        }
+    };
+    AddressTaken address_taken{*this, {}};
+    walk(TreeNode(function.body), address_taken);
+    for (const ASTNode *declaration: address_taken.m_declarations) {
+        ValueId slot = emit(OPCODE::LOCAL, m_types.pointer_to(type_of(declaration)), {},
+                            byte_size(type_of(declaration)));
+        m_slots[declaration] = slot;
+        auto param = m_variables.find(declaration);
+        if (param != m_variables.end()) {
+            emit(OPCODE::STORE, TypeTable::VOID_TYPE, {slot, read_variable(param->second, m_current)});
+        }
+    }
+
+    lower_body(definition);
+    emit(OPCODE::RETURN, TypeTable::VOID_TYPE, {});
+    IrFunction lowered = finish();
+    lowered.m_name = std::get<Symbol>(definition->m_token.m_value);
+    lowered.m_type = type_of(definition);
+    return lowered;
+}
+
+void IrBuilder::lower_body(const ASTNode *definition) {
+    // operands leave their values on m_values for the operation holding them. Each node being walked has a
+    // frame holding the context it's lowered in and the blocks its statement is still to branch to
+    struct Frame {
+        CONTEXT m_context;
+        BlockId m_first = NO_BLOCK;
+        BlockId m_second = NO_BLOCK;
+        ValueId m_value = NO_VALUE;
+    };
+    struct Visitor {
+        IrBuilder &m_builder;
+        TypeId m_return_type;
+        std::vector<ValueId> m_values;
+        std::vector<Frame> m_frames;
+        CONTEXT m_next = CONTEXT::STATEMENT; // of the node about to be entered
+
+        ValueId pop() {
+            ValueId value = m_values.back();
+            m_values.pop_back();
+            return value;
+        }
+
+        // the declaration an assignment writes when it's a variable kept as SSA values, otherwise null
+        const ASTNode *assigned_variable(const ASTNode *assignment) const {
+            const ASTNode *target = std::get<BinaryOperation>(assignment->m_members).lhs;
+            if (node_kind(*target) == NODE_KIND::LEAF) {
+                target = m_builder.m_resolver.declaration_of(target);
+            }
+            bool variable = node_kind(*target) == NODE_KIND::VARIABLE_DECLARATION && !m_builder.in_memory(target);
+            return variable ? target : nullptr;
+        }
+
+        bool enter(TreeNode tree_node) {
+            IrBuilder &builder = m_builder;
+            const ASTNode *node = tree_node.node();
+            CONTEXT context = m_next;
+            if (context == CONTEXT::ADDRESS && !is_lvalue(node)) {
+                context = CONTEXT::VALUE; // not an lvalue, its value stands in
+            }
+            switch (tree_node.kind()) {
+                case NODE_KIND::FUNC_DECLARATION: // a prototype among the statements
+                    return false;
+                case NODE_KIND::VARIABLE_DECLARATION:
+                    if (context == CONTEXT::ADDRESS) {
+                        m_values.push_back(builder.address_of_variable(node));
+                    }
+                    return false;
+                case NODE_KIND::LEAF:
+                    lower_leaf(node, context);
+                    return false;
+                case NODE_KIND::WHILE: {
+                    BlockId header = builder.new_block(false);
+                    builder.jump(header);
+                    builder.m_current = header;
+                    m_frames.push_back({context, header});
+                    return true;
+                }
+                default:
+                    m_frames.push_back({context});
+                    return true;
+            }
+        }
+
+        void lower_leaf(const ASTNode *node, CONTEXT context) {
+            IrBuilder &builder = m_builder;
+            const Token &token = node->m_token;
+            if (token.m_type == TOKEN_TYPE::BREAK || token.m_type == TOKEN_TYPE::CONTINUE) {
+                if (!builder.m_loops.empty()) {
+                    builder.jump(token.m_type == TOKEN_TYPE::BREAK ? builder.m_loops.back().m_break
+                                                                   : builder.m_loops.back().m_continue);
+                    builder.m_current = builder.new_block(true);
+                }
+                return;
+            }
+            if (context == CONTEXT::TARGET) {
+                return;
+            }
+            if (token.m_type == TOKEN_TYPE::INTEGER) {
+                m_values.push_back(builder.constant(std::get<int>(token.m_value)));
+            } else if (token.m_type == TOKEN_TYPE::CHARACTER) {
+                m_values.push_back(builder.emit(OPCODE::CONST, TypeTable::CHAR_TYPE, {}, std::get<char>(token.m_value)));
+            } else if (token.m_type == TOKEN_TYPE::STRING) {
+                m_values.push_back(builder.emit(OPCODE::STRING, builder.type_of(node), {},
+                                                static_cast<int32_t>(std::get<Symbol>(token.m_value).m_id)));
+            } else {
+                const ASTNode *declaration = builder.m_resolver.declaration_of(node);
+                if (context == CONTEXT::ADDRESS) {
+                    m_values.push_back(builder.address_of_variable(declaration));
+                } else if (builder.in_memory(declaration)) {
+                    m_values.push_back(builder.emit(OPCODE::LOAD, builder.type_of(node),
+                                                    {builder.address_of_variable(declaration)}));
+                } else {
+                    m_values.push_back(builder.read_variable(builder.variable(declaration), builder.m_current));
+                    builder.complete_phis();
+                }
+            }
+            if (context == CONTEXT::STATEMENT) {
+                pop();
+            }
+        }
+
+        void before_child(TreeNode tree_node, uint32_t index) {
+            IrBuilder &builder = m_builder;
+            const ASTNode *node = tree_node.node();
+            Frame &frame = m_frames.back();
+            TOKEN_TYPE type = node->m_token.m_type;
+            m_next = CONTEXT::VALUE;
+            switch (tree_node.kind()) {
+                case NODE_KIND::BLOCK:
+                    m_next = CONTEXT::STATEMENT;
+                    break;
+                case NODE_KIND::IF: {
+                    if (index == 0) {
+                        break;
+                    }
+                    m_next = CONTEXT::STATEMENT;
+                    if (index == 2) {
+                        builder.jump(frame.m_first);
+                        builder.m_current = frame.m_second;
+                        break;
+                    }
+                    bool has_else = tree_node.child_count() == 3;
+                    ValueId condition = pop();
+                    BlockId then_block = builder.new_block(false);
+                    BlockId else_block = has_else ? builder.new_block(false) : NO_BLOCK;
+                    BlockId join = builder.new_block(false);
+                    builder.branch(condition, then_block, has_else ? else_block : join);
+                    builder.seal(then_block);
+                    if (has_else) {
+                        builder.seal(else_block);
+                    }
+                    builder.m_current = then_block;
+                    frame.m_first = join;
+                    frame.m_second = else_block;
+                    break;
+                }
+                case NODE_KIND::WHILE: {
+                    if (index == 0) {
+                        break;
+                    }
+                    m_next = CONTEXT::STATEMENT;
+                    ValueId condition = pop();
+                    BlockId body = builder.new_block(false);
+                    BlockId exit = builder.new_block(false);
+                    builder.branch(condition, body, exit);
+                    builder.seal(body);
+                    builder.m_loops.push_back({frame.m_first, exit});
+                    builder.m_current = body;
+                    frame.m_second = exit;
+                    break;
+                }
+                case NODE_KIND::UNARY_OPERATION:
+                    if (type == TOKEN_TYPE::ADDRESSOF) {
+                        m_next = CONTEXT::ADDRESS;
+                    }
+                    break;
+                case NODE_KIND::BINARY_OPERATION:
+                    if (type == TOKEN_TYPE::ASSIGN && index == 0) {
+                        m_next = assigned_variable(node) ? CONTEXT::TARGET : CONTEXT::ADDRESS;
+                    } else if ((type == TOKEN_TYPE::LAND || type == TOKEN_TYPE::LOR) && index == 1) {
+                        // a && b is 0 without evaluating b when a is 0, a || b is 1 when a isn't
+                        bool is_and = type == TOKEN_TYPE::LAND;
+                        ValueId lhs = pop();
+                        ValueId short_circuit = builder.constant(is_and ? 0 : 1);
+                        BlockId rhs_block = builder.new_block(false);
+                        BlockId join = builder.new_block(false);
+                        if (is_and) {
+                            builder.branch(lhs, rhs_block, join);
+                        } else {
+                            builder.branch(lhs, join, rhs_block);
+                        }
+                        builder.seal(rhs_block);
+                        builder.m_current = rhs_block;
+                        frame.m_first = join;
+                        frame.m_value = short_circuit;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void leave(TreeNode tree_node) {
+            IrBuilder &builder = m_builder;
+            const ASTNode *node = tree_node.node();
+            Frame frame = m_frames.back();
+            m_frames.pop_back();
+            TOKEN_TYPE type = node->m_token.m_type;
+            switch (tree_node.kind()) {
+                case NODE_KIND::IF:
+                    builder.jump(frame.m_first);
+                    builder.seal(frame.m_first);
+                    builder.m_current = frame.m_first;
+                    break;
+                case NODE_KIND::WHILE:
+                    builder.jump(frame.m_first);
+                    builder.seal(frame.m_first);
+                    builder.seal(frame.m_second);
+                    builder.m_loops.pop_back();
+                    builder.m_current = frame.m_second;
+                    break;
+                case NODE_KIND::RETURN:
+                    if (tree_node.child_count() != 0) {
+                        builder.emit(OPCODE::RETURN, TypeTable::VOID_TYPE, {builder.convert(pop(), m_return_type)});
+                    } else {
+                        builder.emit(OPCODE::RETURN, TypeTable::VOID_TYPE, {});
+                    }
+                    builder.m_current = builder.new_block(true);
+                    break;
+                case NODE_KIND::BINARY_OPERATION:
+                    if (type == TOKEN_TYPE::ASSIGN) {
+                        if (const ASTNode *target = assigned_variable(node)) {
+                            ValueId value = builder.convert(pop(), builder.type_of(target));
+                            builder.write_variable(builder.variable(target), builder.m_current, value);
+                            m_values.push_back(value);
+                        } else {
+                            ValueId value = builder.convert(pop(), builder.type_of(node));
+                            ValueId address = pop();
+                            builder.emit(OPCODE::STORE, TypeTable::VOID_TYPE, {address, value});
+                            m_values.push_back(value);
+                        }
+                    } else if (type == TOKEN_TYPE::LAND || type == TOKEN_TYPE::LOR) {
+                        ValueId rhs = builder.emit(OPCODE::NEQ, TypeTable::INT_TYPE, {pop(), builder.constant(0)});
+                        builder.jump(frame.m_first);
+                        builder.seal(frame.m_first);
+                        builder.m_current = frame.m_first;
+                        ValueId phi = builder.new_phi(builder.m_current, TypeTable::INT_TYPE);
+                        builder.m_phi_operands[builder.m_instructions[phi].m_first_operand] = {frame.m_value, rhs};
+                        m_values.push_back(phi);
+                    } else {
+                        ValueId rhs = pop();
+                        ValueId lhs = pop();
+                        if (type == TOKEN_TYPE::LBRACKET) {
+                            ValueId address = builder.pointer_offset(lhs, rhs, builder.m_instructions[lhs].m_type,
+                                                                     false);
+                            m_values.push_back(frame.m_context == CONTEXT::ADDRESS
+                                               ? address
+                                               : builder.emit(OPCODE::LOAD, builder.type_of(node), {address}));
+                        } else {
+                            m_values.push_back(builder.arithmetic(node, lhs, rhs));
+                        }
+                    }
+                    break;
+                case NODE_KIND::UNARY_OPERATION:
+                    if (type == TOKEN_TYPE::DEREF) {
+                        // the operand's value is the address
+                        if (frame.m_context != CONTEXT::ADDRESS) {
+                            m_values.push_back(builder.emit(OPCODE::LOAD, builder.type_of(node), {pop()}));
+                        }
+                    } else if (type == TOKEN_TYPE::BANG) {
+                        m_values.push_back(builder.emit(OPCODE::EQ, TypeTable::INT_TYPE, {pop(), builder.constant(0)}));
+                    } else if (type != TOKEN_TYPE::ADDRESSOF) {
+                        m_values.push_back(builder.emit(OPCODE::NEG, TypeTable::INT_TYPE,
+                                                        {builder.convert(pop(), TypeTable::INT_TYPE)}));
+                    }
+                    break;
+                case NODE_KIND::FUNC_CALL: {
+                    const ASTNode *callee = builder.m_resolver.declaration_of(node);
+                    auto params = builder.m_types.params(builder.type_of(callee));
+                    std::vector<ValueId> args(m_values.end() - tree_node.child_count(), m_values.end());
+                    m_values.resize(m_values.size() - args.size());
+                    for (size_t index = 0; index < args.size() && index < params.size(); ++index) {
+                        args[index] = builder.convert(args[index], params[index]);
+                    }
+                    m_values.push_back(builder.emit(OPCODE::CALL, builder.type_of(node), args,
+                                                    static_cast<int32_t>(std::get<Symbol>(node->m_token.m_value).m_id)));
+                    break;
+                }
+                default:
+                    break;
+            }
+            if (frame.m_context == CONTEXT::STATEMENT && is_expression(tree_node.kind())) {
+                pop();
+            }
+        }
+    };
+    Visitor visitor{*this, m_types.return_type(type_of(definition)), {}, {}};
+    walk(TreeNode(std::get<FuncDeclaration>(definition->m_members).body), visitor);
+}
+
+BlockId IrBuilder::new_block(bool sealed) {
+    m_blocks.emplace_back();
+    m_blocks.back().m_sealed = sealed;
+    return m_blocks.size() - 1;
+}
+
+void IrBuilder::seal(BlockId block) {
+    for (auto [variable, phi]: m_blocks[block].m_incomplete_phis) {
+        m_pending_phis.push_back({variable, phi});
+    }
+    m_blocks[block].m_incomplete_phis.clear();
+    m_blocks[block].m_sealed = true;
+    complete_phis();
+}
+
+ValueId IrBuilder::emit(OPCODE opcode, TypeId type, std::initializer_list<ValueId> operands, int32_t immediate) {
+    return emit(opcode, type, std::span<const ValueId>(operands.begin(), operands.size()), immediate);
+}
+
+ValueId IrBuilder::emit(OPCODE opcode, TypeId type, std::span<const ValueId> operands, int32_t immediate) {
+    ValueId value = m_instructions.size();
+    m_instructions.push_back({opcode, type, m_current, static_cast<uint32_t>(m_operands.size()),
+                              static_cast<uint32_t>(operands.size()), immediate});
+    m_operands.insert(m_operands.end(), operands.begin(), operands.end());
+    m_blocks[m_current].m_instructions.push_back(value);
+    return value;
+}
+
+ValueId IrBuilder::new_phi(BlockId block, TypeId type) {
+    ValueId value = m_instructions.size();
+    m_instructions.push_back({OPCODE::PHI, type, block, static_cast<uint32_t>(m_phi_operands.size()), 0, 0});
+    m_phi_operands.emplace_back();
+    m_blocks[block].m_phis.push_back(value);
+    return value;
+}
+
+void IrBuilder::jump(BlockId target) {
+    emit(OPCODE::JUMP, TypeTable::VOID_TYPE, {});
+    m_blocks[m_current].m_successors.push_back(target);
+    m_blocks[target].m_predecessors.push_back(m_current);
+}
+
+void IrBuilder::branch(ValueId condition, BlockId if_true, BlockId if_false) {
+    emit(OPCODE::BRANCH, TypeTable::VOID_TYPE, {condition});
+    for (BlockId target: {if_true, if_false}) {
+        m_blocks[m_current].m_successors.push_back(target);
+        m_blocks[target].m_predecessors.push_back(m_current);
+    }
+}
+
+ValueId IrBuilder::undef(TypeId type) {
+    auto [found, inserted] = m_undefs.try_emplace(type, m_instructions.size());
+    if (inserted) {
+        // the entry block dominates every use
+        m_instructions.push_back({OPCODE::UNDEF, type, 0, static_cast<uint32_t>(m_operands.size()), 0, 0});
+        auto &entry = m_blocks[0].m_instructions;
+        entry.insert(entry.begin(), found->second);
+    }
+    return found->second;
+}
+
+ValueId IrBuilder::convert(ValueId value, TypeId type) {
+    TypeId from = m_instructions[value].m_type;
+    if (from == type || !m_types.is_integer(from) || !m_types.is_integer(type)) {
+        return value;
+    }
+    return emit(OPCODE::CONVERT, type, {value});
+}
+
+ValueId IrBuilder::pointer_offset(ValueId pointer, ValueId index, TypeId pointer_type, bool negate) {
+    index = convert(index, TypeTable::INT_TYPE);
+    if (negate) {
+        index = emit(OPCODE::NEG, TypeTable::INT_TYPE, {index});
+    }
+    return emit(OPCODE::ELEMENT, pointer_type, {pointer, index}, byte_size(m_types.pointee(pointer_type)));
+}
+
+ValueId IrBuilder::arithmetic(const ASTNode *node, ValueId lhs, ValueId rhs) {
+    TOKEN_TYPE type = node->m_token.m_type;
+    TypeId lhs_type = m_instructions[lhs].m_type;
+    TypeId rhs_type = m_instructions[rhs].m_type;
+    bool lhs_pointer = m_types.kind(lhs_type) == TYPE_KIND::POINTER;
+    bool rhs_pointer = m_types.kind(rhs_type) == TYPE_KIND::POINTER;
+    if (type == TOKEN_TYPE::ADD && (lhs_pointer || rhs_pointer)) {
+        return lhs_pointer ? pointer_offset(lhs, rhs, lhs_type, false) : pointer_offset(rhs, lhs, rhs_type, false);
+    }
+    if (type == TOKEN_TYPE::SUB && lhs_pointer && rhs_pointer) {
+        // the distance in elements
+        ValueId bytes = emit(OPCODE::SUB, TypeTable::INT_TYPE, {lhs, rhs});
+        int32_t size = byte_size(m_types.pointee(lhs_type));
+        return size == 1 ? bytes : emit(OPCODE::DIV, TypeTable::INT_TYPE, {bytes, constant(size)});
+    }
+    if (type == TOKEN_TYPE::SUB && lhs_pointer) {
+        return pointer_offset(lhs, rhs, lhs_type, true);
+    }
+    if (!lhs_pointer && !rhs_pointer) {
+        lhs = convert(lhs, TypeTable::INT_TYPE);
+        rhs = convert(rhs, TypeTable::INT_TYPE);
+    }
+    return emit(arithmetic_opcode(type), TypeTable::INT_TYPE, {lhs, rhs});
+}
+
+uint32_t IrBuilder::variable(const ASTNode *declaration) {
+    auto [found, inserted] = m_variables.try_emplace(declaration, m_variable_types.size());
+    if (inserted) {
+        m_variable_types.push_back(type_of(declaration));
+    }
+    return found->second;
+}
+
+ValueId IrBuilder::address_of_variable(const ASTNode *declaration) {
+    if (m_globals.contains(declaration)) {
+        return emit(OPCODE::GLOBAL, m_types.pointer_to(type_of(declaration)), {},
+                    static_cast<int32_t>(std::get<Symbol>(declaration->m_token.m_value).m_id));
+    }
+    return m_slots.at(declaration);
+}
+
+void IrBuilder::write_variable(uint32_t variable, BlockId block, ValueId value) {
+    m_definitions[definition_key(variable, block)] = value;
+}
+
+ValueId IrBuilder::read_variable(uint32_t variable, BlockId block) {
+    // single predecessor chains are followed in a loop, phis get their operands later in complete_phis,
+    // so reading never recurses however long the chain of blocks is
+    std::vector<BlockId> chain;
+    ValueId value;
+    while (true) {
+        auto found = m_definitions.find(definition_key(variable, block));
+        if (found != m_definitions.end()) {
+            value = found->second;
+            break;
+        }
+        BlockState &current = m_blocks[block];
+        if (!current.m_sealed) {
+            value = new_phi(block, m_variable_types[variable]);
+            current.m_incomplete_phis.emplace_back(variable, value);
+            break;
+        }
+        if (current.m_predecessors.size() == 1) {
+            chain.push_back(block);
+            block = current.m_predecessors[0];
+            continue;
+        }
+        if (current.m_predecessors.empty()) {
+            value = undef(m_variable_types[variable]);
+            break;
+        }
+        value = new_phi(block, m_variable_types[variable]);
+        m_pending_phis.push_back({variable, value});
+        break;
+    }
+    write_variable(variable, block, value);
+    for (BlockId passed: chain) {
+        write_variable(variable, passed, value);
+    }
+    return value;
+}
+
+void IrBuilder::complete_phis() {
+    while (!m_pending_phis.empty()) {
+        PendingPhi pending = m_pending_phis.back();
+        m_pending_phis.pop_back();
+        BlockId block = m_instructions[pending.m_phi].m_block;
+        for (size_t index = 0; index < m_blocks[block].m_predecessors.size(); ++index) {
+            ValueId operand = read_variable(pending.m_variable, m_blocks[block].m_predecessors[index]);
+            m_phi_operands[m_instructions[pending.m_phi].m_first_operand].push_back(operand);
+        }
+    }
+}
+
+IrFunction IrBuilder::finish() {
+    // blocks the entry can't reach are dropped together with the phi operands flowing in from them
+    std::vector<bool> reachable(m_blocks.size());
+    std::vector<BlockId> blocks = {0};
+    reachable[0] = true;
+    while (!blocks.empty()) {
+        BlockId block = blocks.back();
+        blocks.pop_back();
+        for (BlockId successor: m_blocks[block].m_successors) {
+            if (!reachable[successor]) {
+                reachable[successor] = true;
+                blocks.push_back(successor);
+            }
+        }
+    }
+    for (BlockId block = 0; block < m_blocks.size(); ++block) {
+        auto &predecessors = m_blocks[block].m_predecessors;
+        if (!reachable[block] || std::all_of(predecessors.begin(), predecessors.end(),
+                                             [&reachable](BlockId predecessor) { return reachable[predecessor]; })) {
+            continue;
+        }
+        for (ValueId phi: m_blocks[block].m_phis) {
+            auto &operands = m_phi_operands[m_instructions[phi].m_first_operand];
+            size_t kept = 0;
+            for (size_t index = 0; index < predecessors.size(); ++index) {
+                if (reachable[predecessors[index]]) {
+                    operands[kept++] = operands[index];
+                }
+            }
+            operands.resize(kept);
+        }
+        std::erase_if(predecessors, [&reachable](BlockId predecessor) { return !reachable[predecessor]; });
+    }
+
+    // a phi merging one value (besides itself) is that value, replacing it may make the phis using it trivial
+    std::vector<ValueId> replaced(m_instructions.size(), NO_VALUE);
+    auto find = [&replaced](ValueId value) {
+        ValueId root = value;
+        while (root < replaced.size() && replaced[root] != NO_VALUE) {
+            root = replaced[root];
+        }
+        while (value < replaced.size() && replaced[value] != NO_VALUE) {
+            ValueId next = replaced[value];
+            replaced[value] = root;
+            value = next;
+        }
+        return root;
+    };
+    std::unordered_map<ValueId, std::vector<ValueId>> phi_users;
+    std::vector<ValueId> worklist;
+    for (BlockId block = 0; block < m_blocks.size(); ++block) {
+        if (!reachable[block]) {
+            continue;
+        }
+        for (ValueId phi: m_blocks[block].m_phis) {
+            worklist.push_back(phi);
+            for (ValueId operand: m_phi_operands[m_instructions[phi].m_first_operand]) {
+                if (m_instructions[operand].m_opcode == OPCODE::PHI && operand != phi) {
+                    phi_users[operand].push_back(phi);
+                }
+            }
+        }
+    }
+    while (!worklist.empty()) {
+        ValueId phi = worklist.back();
+        worklist.pop_back();
+        if (replaced[phi] != NO_VALUE) {
+            continue;
+        }
+        ValueId same = NO_VALUE;
+        bool trivial = true;
+        for (ValueId operand: m_phi_operands[m_instructions[phi].m_first_operand]) {
+            operand = find(operand);
+            if (operand == same || operand == phi) {
+                continue;
+            }
+            if (same != NO_VALUE) {
+                trivial = false;
+                break;
+            }
+            same = operand;
+        }
+        if (!trivial) {
+            continue;
+        }
+        replaced[phi] = same != NO_VALUE ? same : undef(m_instructions[phi].m_type);
+        auto users = phi_users.find(phi);
+        if (users != phi_users.end()) {
+            worklist.insert(worklist.end(), users->second.begin(), users->second.end());
+        }
+    }
+
+    auto operands_of = [this](ValueId value) {
+        const Instruction &instruction = m_instructions[value];
+        if (instruction.m_opcode == OPCODE::PHI) {
+            return std::span<const ValueId>(m_phi_operands[instruction.m_first_operand]);
+        }
+        return std::span<const ValueId>(m_operands.data() + instruction.m_first_operand, instruction.m_operand_count);
+    };
+
+    // undefs read only in dropped blocks or by replaced phis go as well
+    std::unordered_set<ValueId> used_undefs;
+    for (BlockId block = 0; block < m_blocks.size(); ++block) {
+        if (!reachable[block]) {
+            continue;
+        }
+        for (const auto *values: {&m_blocks[block].m_phis, &m_blocks[block].m_instructions}) {
+            for (ValueId value: *values) {
+                if (value < replaced.size() && replaced[value] != NO_VALUE) {
+                    continue;
+                }
+                for (ValueId operand: operands_of(value)) {
+                    operand = find(operand);
+                    if (m_instructions[operand].m_opcode == OPCODE::UNDEF) {
+                        used_undefs.insert(operand);
+                    }
+                }
+            }
+        }
+    }
+
+    // number what's left in block order
+    IrFunction function;
+    std::vector<ValueId> numbers(m_instructions.size(), NO_VALUE);
+    std::vector<BlockId> block_numbers(m_blocks.size(), NO_BLOCK);
+    std::vector<ValueId> order;
+    order.reserve(m_instructions.size());
+    for (BlockId block = 0; block < m_blocks.size(); ++block) {
+        if (!reachable[block]) {
+            continue;
+        }
+        block_numbers[block] = function.m_blocks.size();
+        BasicBlock &numbered = function.m_blocks.emplace_back();
+        numbered.m_first_instruction = order.size();
+        for (ValueId phi: m_blocks[block].m_phis) {
+            if (replaced[phi] == NO_VALUE) {
+                numbers[phi] = order.size();
+                order.push_back(phi);
+                ++numbered.m_phi_count;
+            }
+        }
+        for (ValueId value: m_blocks[block].m_instructions) {
+            if (m_instructions[value].m_opcode == OPCODE::UNDEF && !used_undefs.contains(value)) {
+                continue;
+            }
+            numbers[value] = order.size();
+            order.push_back(value);
+        }
+        numbered.m_instruction_count = order.size() - numbered.m_first_instruction;
+    }
+    for (BlockId block = 0; block < m_blocks.size(); ++block) {
+        if (!reachable[block]) {
+            continue;
+        }
+        BasicBlock &numbered = function.m_blocks[block_numbers[block]];
+        for (BlockId predecessor: m_blocks[block].m_predecessors) {
+            numbered.m_predecessors.push_back(block_numbers[predecessor]);
+        }
+        for (BlockId successor: m_blocks[block].m_successors) {
+            numbered.m_successors.push_back(block_numbers[successor]);
+        }
+    }
+
+    function.m_instructions.reserve(order.size());
+    function.m_operands.reserve(m_operands.size());
+    for (ValueId value: order) {
+        Instruction instruction = m_instructions[value];
+        std::span<const ValueId> operands = operands_of(value);
+        instruction.m_block = block_numbers[instruction.m_block];
+        instruction.m_first_operand = function.m_operands.size();
+        instruction.m_operand_count = operands.size();
+        for (ValueId operand: operands) {
+            function.m_operands.push_back(numbers[find(operand)]);
+        }
+        function.m_instructions.push_back(instruction);
+    }
+    return function;
+}
+
+int32_t IrBuilder::byte_size(TypeId type) const {
+    switch (m_types.kind(type)) {
+        case TYPE_KIND::INT:
+            return 4;
+        case TYPE_KIND::POINTER:
+            return 8;
+        default: // char, and void for void * arithmetic
+            return 1;
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ast.h"
+#include "ir.h"
+#include "name_resolver.h"
+#include "type_checker.h"
+#include "types.h"
+
+/*
+ * Lowers the function definitions of a resolved and type checked translation unit into SSA form, building
+ * SSA directly while walking the AST (Braun et al., "Simple and Efficient Construction of Static Single
+ * Assignment Form"): a local variable is a value per block, reading one in a block which doesn't define it
+ * looks through the block's predecessors and places a phi where they join. A block whose predecessors aren't
+ * all known yet (a loop header) gets operandless phis which are completed when it's sealed.
+ * Variables whose address is taken live in a LOCAL slot and file scope variables in memory, both are
+ * loaded and stored. && and || branch, pointer arithmetic is scaled by the pointee's size and integers
+ * convert where a value of one type is assigned, passed or returned as the other.
+ * Once a function is done, phis which turned out to merge a single value are replaced by it, blocks which
+ * can't be reached are dropped and what remains is numbered in block order.
+ * Bodies are lowered in a single walk() over the tree, so nesting depth is bounded by memory only.
+ */
+class IrBuilder {
+public:
+    // lowers trees checker checked, with the types it gave them
+    IrBuilder(const NameResolver &resolver, TypeChecker &checker)
+            : m_resolver(resolver), m_checker(checker), m_types(checker.types()) {}
+
+    // one function per definition, declarations without a body (and unparsed lazy bodies) have none
+    std::vector<IrFunction> lower(const NodeList &declarations);
+
+    IrFunction lower_function(const ASTNode *definition);
+
+private:
+    struct BlockState {
+        std::vector<ValueId> m_phis;
+        std::vector<ValueId> m_instructions;
+        std::vector<BlockId> m_predecessors;
+        std::vector<BlockId> m_successors;
+        std::vector<std::pair<uint32_t, ValueId>> m_incomplete_phis; // variable, phi
+        bool m_sealed = false;
+    };
+
+    // a phi waiting for its operands, the value of variable at the end of each predecessor
+    struct PendingPhi {
+        uint32_t m_variable;
+        ValueId m_phi;
+    };
+
+    struct Loop {
+        BlockId m_continue;
+        BlockId m_break;
+    };
+
+    void lower_body(const ASTNode *definition);
+
+    TypeId type_of(const ASTNode *node) const { return m_checker.type_of(node); }
+
+    // makes a block with no predecessors yet, sealed blocks never get more
+    BlockId new_block(bool sealed);
+
+    void seal(BlockId block);
+
+    ValueId emit(OPCODE opcode, TypeId type, std::initializer_list<ValueId> operands, int32_t immediate = 0);
+
+    ValueId emit(OPCODE opcode, TypeId type, std::span<const ValueId> operands, int32_t immediate = 0);
+
+    ValueId new_phi(BlockId block, TypeId type);
+
+    void jump(BlockId target);
+
+    void branch(ValueId condition, BlockId if_true, BlockId if_false);
+
+    ValueId constant(int32_t value) { return emit(OPCODE::CONST, TypeTable::INT_TYPE, {}, value); }
+
+    ValueId undef(TypeId type);
+
+    // value converted to type when one is char and the other int
+    ValueId convert(ValueId value, TypeId type);
+
+    ValueId pointer_offset(ValueId pointer, ValueId index, TypeId pointer_type, bool negate);
+
+    ValueId arithmetic(const ASTNode *node, ValueId lhs, ValueId rhs);
+
+    // dense index of the local variable declared by declaration
+    uint32_t variable(const ASTNode *declaration);
+
+    bool in_memory(const ASTNode *declaration) const {
+        return m_globals.contains(declaration) || m_slots.contains(declaration);
+    }
+
+    ValueId address_of_variable(const ASTNode *declaration);
+
+    void write_variable(uint32_t variable, BlockId block, ValueId value);
+
+    ValueId read_variable(uint32_t variable, BlockId block);
+
+    void complete_phis();
+
+    IrFunction finish();
+
+    static uint64_t definition_key(uint32_t variable, BlockId block) {
+        return static_cast<uint64_t>(variable) << 32 | block;
+    }
+
+    int32_t byte_size(TypeId type) const;
+
+    const NameResolver &m_resolver;
+    const TypeChecker &m_checker;
+    TypeTable &m_types; // the checker's
+    std::unordered_set<const ASTNode *> m_globals;
+
+    // state of the function being lowered
+    std::vector<Instruction> m_instructions;
+    std::vector<ValueId> m_operands;
+    std::vector<std::vector<ValueId>> m_phi_operands; // a phi's m_first_operand indexes this instead
+    std::vector<BlockState> m_blocks;
+    BlockId m_current = 0;
+    std::unordered_map<const ASTNode *, uint32_t> m_variables;
+    std::vector<TypeId> m_variable_types;
+    std::unordered_map<const ASTNode *, ValueId> m_slots; // address taken locals
+    std::unordered_map<uint64_t, ValueId> m_definitions; // (variable, block) -> value at the block's end
+    std::vector<PendingPhi> m_pending_phis;
+    std::vector<Loop> m_loops;
+    std::unordered_map<TypeId, ValueId> m_undefs;
+};
@@ -0,0 +1,192 @@
+#include "ir_verifier.h"
+
+#include <algorithm>
+
+namespace {
+
+    // operands an opcode takes, -1 when any number does
+    int expected_operands(OPCODE opcode) {
+        switch (opcode) {
+            case OPCODE::CONST:
+            case OPCODE::UNDEF:
+            case OPCODE::PARAM:
+            case OPCODE::LOCAL:
+            case OPCODE::GLOBAL:
+            case OPCODE::STRING:
+            case OPCODE::JUMP:
+                return 0;
+            case OPCODE::NEG:
+            case OPCODE::CONVERT:
+            case OPCODE::LOAD:
+            case OPCODE::BRANCH:
+                return 1;
+            case OPCODE::PHI:
+            case OPCODE::CALL:
+            case OPCODE::RETURN:
+                return -1;
+            default:
+                return 2;
+        }
+    }
+
+    size_t expected_successors(OPCODE terminator) {
+        return terminator == OPCODE::BRANCH ? 2 : terminator == OPCODE::JUMP ? 1 : 0;
+    }
+
+    std::string value_name(ValueId value) {
+        return "%" + std::to_string(value);
+    }
+
+    std::string block_name(BlockId block) {
+        return "bb" + std::to_string(block);
+    }
+}
+
+void IrVerifier::report(const IrFunction &function, std::string message) {
+    m_diagnostics.report("in " + std::string(function.m_name.text()) + ": " + message);
+}
+
+bool IrVerifier::verify(const IrFunction &function) {
+    size_t reported = m_diagnostics.size();
+    if (function.m_blocks.empty()) {
+        report(function, NO_BLOCKS);
+        return false;
+    }
+    if (!function.block(0).m_predecessors.empty()) {
+        report(function, ENTRY_PREDECESSORS);
+    }
+
+    // the shape of every block, dominance is only asked about once it holds
+    ValueId next = 0;
+    for (BlockId id = 0; id < function.block_count(); ++id) {
+        const BasicBlock &block = function.block(id);
+        if (block.m_first_instruction != next || block.m_phi_count > block.m_instruction_count ||
+            block.m_first_instruction + block.m_instruction_count > function.size()) {
+            report(function, BLOCK_LAYOUT + block_name(id));
+            return false;
+        }
+        next += block.m_instruction_count;
+        if (block.m_instruction_count == 0) {
+            report(function, EMPTY_BLOCK + block_name(id));
+            continue;
+        }
+        for (uint32_t index = 0; index < block.m_instruction_count; ++index) {
+            ValueId value = block.m_first_instruction + index;
+            const Instruction &instruction = function.instruction(value);
+            if (instruction.m_block != id) {
+                report(function, WRONG_BLOCK + value_name(value));
+            }
+            if ((instruction.m_opcode == OPCODE::PHI) != (index < block.m_phi_count)) {
+                report(function, MISPLACED_PHI + value_name(value));
+            }
+            if (is_terminator(instruction.m_opcode) && index + 1 != block.m_instruction_count) {
+                report(function, MISPLACED_TERMINATOR + value_name(value));
+            }
+            if (instruction.m_first_operand + instruction.m_operand_count > function.m_operands.size()) {
+                report(function, OPERAND_COUNT + value_name(value));
+                return false;
+            }
+            int expected = expected_operands(instruction.m_opcode);
+            size_t count = instruction.m_operand_count;
+            if ((expected >= 0 && count != static_cast<size_t>(expected)) ||
+                (instruction.m_opcode == OPCODE::PHI && count != block.m_predecessors.size()) ||
+                (instruction.m_opcode == OPCODE::RETURN && count > 1)) {
+                report(function, OPERAND_COUNT + value_name(value));
+            }
+            for (ValueId operand: function.operands(value)) {
+                if (operand >= function.size() || is_void(function.instruction(operand).m_opcode)) {
+                    report(function, INVALID_OPERAND_VALUE + value_name(value));
+                }
+            }
+        }
+        ValueId last = block.m_first_instruction + block.m_instruction_count - 1;
+        OPCODE terminator = function.instruction(last).m_opcode;
+        if (!is_terminator(terminator)) {
+            report(function, MISSING_TERMINATOR + block_name(id));
+        } else if (block.m_successors.size() != expected_successors(terminator)) {
+            report(function, SUCCESSOR_COUNT + block_name(id));
+        }
+
+        // every edge is listed once from each end
+        for (BlockId successor: block.m_successors) {
+            if (successor >= function.block_count() ||
+                std::count(block.m_successors.begin(), block.m_successors.end(), successor) !=
+                std::count(function.block(successor).m_predecessors.begin(),
+                           function.block(successor).m_predecessors.end(), id)) {
+                report(function, EDGE_MISMATCH + block_name(id) + " -> " +
+                                 (successor < function.block_count() ? block_name(successor) : "?"));
+                return false;
+            }
+        }
+        for (BlockId predecessor: block.m_predecessors) {
+            if (predecessor >= function.block_count() ||
+                std::find(function.block(predecessor).m_successors.begin(),
+                          function.block(predecessor).m_successors.end(), id) ==
+                function.block(predecessor).m_successors.end()) {
+                report(function, EDGE_MISMATCH + (predecessor < function.block_count() ? block_name(predecessor) : "?") +
+                                 " -> " + block_name(id));
+                return false;
+            }
+        }
+    }
+    if (next != function.size()) {
+        report(function, BLOCK_LAYOUT + block_name(function.block_count()));
+    }
+    if (m_diagnostics.size() != reported) {
+        return false;
+    }
+
+    // number the dominator tree depth first: a dominates b when b's interval nests in a's
+    std::vector<BlockId> dominators = immediate_dominators(function);
+    std::vector<std::vector<BlockId>> children(function.block_count());
+    for (BlockId id = 1; id < function.block_count(); ++id) {
+        if (dominators[id] == NO_BLOCK) {
+            report(function, UNREACHABLE_BLOCK + block_name(id));
+        } else {
+            children[dominators[id]].push_back(id);
+        }
+    }
+    if (m_diagnostics.size() != reported) {
+        return false;
+    }
+    std::vector<uint32_t> entered(function.block_count());
+    std::vector<uint32_t> left(function.block_count());
+    uint32_t clock = 0;
+    std::vector<std::pair<BlockId, size_t>> stack = {{0, 0}};
+    entered[0] = clock++;
+    while (!stack.empty()) {
+        auto &[block, child] = stack.back();
+        if (child == children[block].size()) {
+            left[block] = clock++;
+            stack.pop_back();
+            continue;
+        }
+        BlockId next_block = children[block][child++];
+        entered[next_block] = clock++;
+        stack.emplace_back(next_block, 0);
+    }
+    auto dominates = [&](BlockId dominator, BlockId block) {
+        return entered[dominator] <= entered[block] && left[block] <= left[dominator];
+    };
+
+    for (ValueId value = 0; value < function.size(); ++value) {
+        const Instruction &instruction = function.instruction(value);
+        auto operands = function.operands(value);
+        for (size_t index = 0; index < operands.size(); ++index) {
+            const Instruction &definition = function.instruction(operands[index]);
+            bool available;
+            if (instruction.m_opcode == OPCODE::PHI) {
+                // live out of the predecessor the operand flows in from
+                available = dominates(definition.m_block, function.block(instruction.m_block).m_predecessors[index]);
+            } else if (definition.m_block == instruction.m_block) {
+                available = operands[index] < value;
+            } else {
+                available = dominates(definition.m_block, instruction.m_block);
+            }
+            if (!available) {
+                report(function, NOT_DOMINATED + value_name(operands[index]) + " used by " + value_name(value));
+            }
+        }
+    }
+    return m_diagnostics.size() == reported;
+}
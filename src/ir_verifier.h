@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+
+#include "diagnostics.h"
+#include "ir.h"
+
+constexpr const char *NO_BLOCKS = "function has no blocks";
+constexpr const char *ENTRY_PREDECESSORS = "entry block has predecessors";
+constexpr const char *BLOCK_LAYOUT = "block doesn't start where the previous one ended: ";
+constexpr const char *EMPTY_BLOCK = "block has no instructions: ";
+constexpr const char *WRONG_BLOCK = "instruction names another block than the one holding it: ";
+constexpr const char *MISPLACED_PHI = "phi after the start of its block: ";
+constexpr const char *MISSING_TERMINATOR = "block doesn't end with a terminator: ";
+constexpr const char *MISPLACED_TERMINATOR = "terminator before the end of its block: ";
+constexpr const char *SUCCESSOR_COUNT = "successors don't match the terminator of: ";
+constexpr const char *EDGE_MISMATCH = "successor and predecessor lists disagree on the edge: ";
+constexpr const char *OPERAND_COUNT = "wrong number of operands: ";
+constexpr const char *INVALID_OPERAND_VALUE = "operand isn't a value: ";
+constexpr const char *UNREACHABLE_BLOCK = "block isn't reachable from the entry: ";
+constexpr const char *NOT_DOMINATED = "definition doesn't dominate its use: ";
+
+/*
+ * Checks the invariants IrFunction documents, so a pass which breaks one fails where it ran rather than
+ * somewhere downstream: blocks tile the instruction array, phis lead and a terminator ends every block,
+ * successor and predecessor lists mirror each other, operand counts fit their opcodes and every operand is
+ * a value whose definition dominates the use (for a phi operand, the end of the matching predecessor).
+ * Dominance is answered in constant time from the dominator tree's depth first numbering.
+ */
+class IrVerifier {
+public:
+    // false when function breaks an invariant, each broken one is reported into diagnostics()
+    bool verify(const IrFunction &function);
+
+    const Diagnostics &diagnostics() const { return m_diagnostics; }
+
+private:
+    void report(const IrFunction &function, std::string message);
+
+    Diagnostics m_diagnostics;
+};
@@ -4,12 +4,17 @@
 #include <memory>
 #include <iostream>
 #include <span>
+#include <cstring>
 #include "lexer.h"
 #include "token.h"
 
 
 std::unique_ptr<std::vector<Token>> Lexer::lex(std::istream &file_to_lex) {
+    if (m_core == LEXER_CORE::DFA) {
+        return lex(SourceBuffer::from_stream(file_to_lex));
+    }
     m_tokens = std::make_unique<std::vector<Token>>();
+    m_diagnostics.clear();
 
     std::string line;
     while (std::getline(file_to_lex, line)) {
@@ -19,6 +24,51 @@ std::unique_ptr<std::vector<Token>> Lexer::lex(std::istream &file_to_lex) {
     return std::move(m_tokens);
 }
 
+std::unique_ptr<std::vector<Token>> Lexer::lex(std::shared_ptr<const SourceBuffer> source) {
+    m_tokens = std::make_unique<std::vector<Token>>();
+    m_source = std::move(source);
+    m_diagnostics.clear();
+    lex_buffer();
+    return std::move(m_tokens);
+}
+
+std::unique_ptr<std::vector<Token>> Lexer::lex_file(const std::string &path) {
+    return lex(SourceBuffer::from_file(path));
+}
+
+TokenStream Lexer::lex_stream(std::shared_ptr<const SourceBuffer> source) {
+    m_source = std::move(source);
+    TokenStream stream(m_source);
+    stream.reserve(m_source->size() / 3); // rough tokens per byte of C source
+
+    m_stream = &stream;
+    m_diagnostics.clear();
+    lex_buffer();
+    m_stream = nullptr;
+    stream.match_brackets();
+
+    return stream;
+}
+
+void Lexer::lex_buffer() {
+    if (m_core == LEXER_CORE::DFA) {
+        lex_dfa();
+        return;
+    }
+
+    // lines are views into the buffer, nothing is copied before scanning
+    const char *line_begin = m_source->data();
+    const char *buffer_end = line_begin + m_source->size();
+    while (line_begin < buffer_end) {
+        auto line_end = static_cast<const char *>(std::memchr(line_begin, '\n', buffer_end - line_begin));
+        if (line_end == nullptr) {
+            line_end = buffer_end;
+        }
+        lex_line(std::string_view(line_begin, line_end - line_begin));
+        line_begin = line_end + 1;
+    }
+}
+
 void Lexer::lex_line(std::string_view statement) {
 
     auto it = statement.begin();
@@ -29,7 +79,6 @@ void Lexer::lex_line(std::string_view statement) {
         size_t stride;
         stride = scan_compound_operator(statement, it);
         stride = stride == 0 ? scan_single_operator(it): stride;
-        stride = stride == 0 ? scan_whitespace(it): stride;
         stride = stride == 0 ? scan_literal_string(statement, it): stride;
         stride = stride == 0 ? scan_literal_char(statement, it): stride;
         stride = stride == 0 ? scan_literal_int(statement, it): stride;
@@ -40,15 +89,248 @@ void Lexer::lex_line(std::string_view statement) {
     }
 }
 
-bool Lexer::scan_token(std::string_view possible_token, const std::map<std::string, TOKEN_TYPE> &search_tokens) {
-    for (const auto &searched_token: search_tokens) {
-        if (!possible_token.compare(searched_token.first)) {
-            DEBUG_MSG("token: " << possible_token);
-            m_tokens->push_back({searched_token.second, std::string(possible_token)});
-            return true;
+TokenStream Lexer::lex_stream_parallel(std::shared_ptr<const SourceBuffer> source, size_t chunk_count) {
+    m_source = std::move(source);
+    m_diagnostics.clear();
+    ThreadPool &pool = ThreadPool::shared();
+    if (chunk_count == 0) {
+        chunk_count = std::clamp<size_t>(m_source->size() / MIN_PARALLEL_CHUNK_BYTES, 1, pool.thread_count());
+    }
+
+    auto boundaries = chunk_boundaries(chunk_count);
+    std::vector<LexedChunk> chunks(boundaries.size() - 1);
+    pool.parallel_for(chunks.size(), [&](size_t index) {
+        chunks[index] = lex_chunk(boundaries[index], boundaries[index + 1], DFA_STATE_START);
+    });
+
+    // the first chunk really starts in DFA_STATE_START, every later one is checked against its predecessor
+    std::vector<LexedChunk> lexed;
+    lexed.reserve(chunks.size());
+    for (auto &chunk: chunks) {
+        if (lexed.empty() || lexed.back().m_exit_state == chunk.m_entry_state) {
+            lexed.push_back(std::move(chunk));
+            continue;
+        }
+        DEBUG_MSG("chunk at byte " << chunk.m_begin << " starts inside a token, relexing it with the one before");
+        LexedChunk &previous = lexed.back();
+        previous = lex_chunk(previous.m_begin, chunk.m_end, previous.m_entry_state);
+    }
+    for (const auto &chunk: lexed) {
+        m_diagnostics.append(chunk.m_diagnostics);
+    }
+    if (lexed.size() == 1) {
+        lexed.front().m_tokens.match_brackets();
+        return std::move(lexed.front().m_tokens);
+    }
+
+    std::vector<size_t> first_token(lexed.size() + 1, 0);
+    for (size_t index = 0; index < lexed.size(); ++index) {
+        first_token[index + 1] = first_token[index] + lexed[index].m_tokens.size();
+    }
+    TokenStream stream(m_source);
+    stream.resize(first_token.back());
+    pool.parallel_for(lexed.size(), [&](size_t index) {
+        stream.copy_from(lexed[index].m_tokens, first_token[index]);
+    });
+    stream.match_brackets();
+    return stream;
+}
+
+std::vector<size_t> Lexer::chunk_boundaries(size_t chunk_count) const {
+    const char *data = m_source->data();
+    const size_t size = m_source->size();
+    std::vector<size_t> boundaries{0};
+    for (size_t chunk = 1; chunk < chunk_count; ++chunk) {
+        size_t target = std::max(size / chunk_count * chunk, boundaries.back());
+        auto newline = static_cast<const char *>(std::memchr(data + target, '\n', size - target));
+        if (newline == nullptr) {
+            break;
+        }
+        if (static_cast<size_t>(newline - data) + 1 > boundaries.back()) {
+            boundaries.push_back(newline - data + 1); // chunks start right after a newline
+        }
+    }
+    boundaries.push_back(size);
+    return boundaries;
+}
+
+Lexer::LexedChunk Lexer::lex_chunk(size_t begin, size_t end, uint8_t entry_state) const {
+    LexedChunk chunk{begin, end, entry_state, DFA_STATE_START, TokenStream(m_source), {}};
+    chunk.m_tokens.reserve((end - begin) / 3);
+
+    Lexer lexer;
+    chunk.m_exit_state = lexer.lex_range(m_source, chunk.m_tokens, begin, end, entry_state);
+    chunk.m_diagnostics = lexer.diagnostics();
+    return chunk;
+}
+
+uint8_t Lexer::lex_range(std::shared_ptr<const SourceBuffer> source, TokenStream &tokens, size_t begin, size_t end,
+                         uint8_t entry_state) {
+    m_source = std::move(source);
+    m_stream = &tokens;
+    uint8_t exit_state = lex_dfa(begin, end, entry_state);
+    m_stream = nullptr;
+    return exit_state;
+}
+
+TokenStream Lexer::relex(const TokenStream &previous, const TextEdit &edit) {
+    const SourceBuffer &old_source = *previous.source();
+    auto source = old_source.edited(edit);
+    const char *data = source->data();
+    const size_t size = source->size();
+    const int64_t shift = static_cast<int64_t>(edit.m_inserted.size()) - static_cast<int64_t>(edit.m_removed_length);
+
+    // tokens never span lines, so every line before the edited one is untouched. The bytes before the edit
+    // are the same in both buffers, the edited line starts after the last newline among them
+    auto line_end = static_cast<const char *>(memrchr(data, '\n', edit.m_offset));
+    size_t restart = line_end == nullptr ? 0 : line_end - data + 1;
+    size_t kept_tokens = previous.first_token_at(restart);
+
+    TokenStream stream(source);
+    stream.reserve(previous.size() + edit.m_inserted.size() / 3);
+    stream.append(previous, 0, kept_tokens);
+    m_diagnostics.clear();
+
+    // relex up to a line end past the edit where the old stream can be picked up again
+    size_t damage_end = edit.m_offset + edit.m_inserted.size();
+    while (true) {
+        auto newline = static_cast<const char *>(std::memchr(data + damage_end, '\n', size - damage_end));
+        size_t sync = newline == nullptr ? size : newline - data + 1;
+        size_t lexed_tokens = stream.size();
+        size_t lexed_diagnostics = m_diagnostics.size();
+        if (lex_range(source, stream, restart, sync) == DFA_STATE_START || sync == size) {
+            DEBUG_MSG("relexed bytes " << restart << " to " << sync << " of " << size);
+            stream.append(previous, previous.first_token_at(static_cast<int64_t>(sync) - shift), previous.size(), shift);
+            stream.match_brackets();
+            return stream;
+        }
+        stream.resize(lexed_tokens);
+        m_diagnostics.truncate(lexed_diagnostics);
+        damage_end = sync;
+    }
+}
+
+void Lexer::lex_dfa() {
+    DEBUG_MSG("lexing " << m_source->size() << " bytes with the DFA core");
+    lex_dfa(0, m_source->size(), DFA_STATE_START);
+}
+
+uint8_t Lexer::lex_dfa(size_t begin, size_t end, uint8_t entry_state) {
+    const char *data = m_source->data();
+    const size_t size = m_source->size();
+    const auto &classes = DFA_TABLES.m_classes;
+
+    uint8_t state = entry_state;
+    size_t token_start = begin;
+    // one extra iteration at the end of the buffer feeds a virtual newline which flushes or rejects
+    // whatever is pending
+    const size_t stop = end == size ? end + 1 : end;
+    for (size_t position = begin; position < stop; ++position) {
+        uint8_t char_class = position < end ? classes[static_cast<unsigned char>(data[position])] : DFA_CLASS_NEWLINE;
+        const DfaTransition &transition = DFA_TABLES.transition(state, char_class);
+        state = transition.m_next;
+
+        if (transition.m_emit_before != DFA_EMIT_NONE) {
+            emit_lexeme(transition.m_emit_before, std::string_view(data + token_start, position - token_start));
+        }
+        if (transition.m_flags != 0) {
+            if (transition.m_flags & DFA_FLAG_UNCLOSED_STRING) {
+                report(UNCLOSED_STRING_LITERAL, data + token_start);
+            }
+            if (transition.m_flags & DFA_FLAG_UNCLOSED_CHAR) {
+                report(UNCLOSED_CHAR_LITERAL, data + token_start);
+            }
+            token_start = position;
+        }
+        if (transition.m_emit_through != DFA_EMIT_NONE) {
+            emit_lexeme(transition.m_emit_through, std::string_view(data + token_start, position + 1 - token_start));
+        }
+
+        // the rest of an identifier, literal, comment or whitespace run can't change the state
+        if (position + 1 < end && DFA_TABLES.m_self_loops[state][static_cast<unsigned char>(data[position + 1])]) {
+            position = skip_byte_set(data + position + 2, data + end, DFA_SELF_LOOP_SETS[state]) - data - 1;
         }
     }
-    return false;
+    return state;
+}
 
+void Lexer::emit_lexeme(uint8_t dfa_emit, std::string_view lexeme) {
+    switch (dfa_emit) {
+        case DFA_EMIT_WORD: {
+            TOKEN_TYPE keyword = KEYWORD_TABLE.find(lexeme);
+            emit_token(keyword == TOKEN_TYPE::EMPTY ? TOKEN_TYPE::IDENTIFIER : keyword, lexeme, lexeme);
+            break;
+        }
+        case DFA_EMIT_INTEGER:
+            emit_token(TOKEN_TYPE::INTEGER, lexeme, parse_int(lexeme));
+            break;
+        case DFA_EMIT_STRING:
+            emit_token(TOKEN_TYPE::STRING, lexeme, lexeme.substr(1, lexeme.size() - 2));
+            break;
+        case DFA_EMIT_CHARACTER:
+            emit_token(TOKEN_TYPE::CHARACTER, lexeme, lexeme[1]);
+            break;
+        default: {
+            TOKEN_TYPE operator_type = lexeme.size() == SINGLE_OPERATOR_SIZE
+                                       ? SINGLE_OPERATOR_TABLE[static_cast<unsigned char>(lexeme[0])]
+                                       : COMPOUND_OPERATOR_TABLE.find(lexeme);
+            if (operator_type != TOKEN_TYPE::EMPTY) {
+                emit_token(operator_type, lexeme, lexeme);
+            }
+        }
+    }
+}
+
+bool Lexer::scan_token(std::string_view possible_token, TOKEN_TYPE token_type) {
+    if (token_type == TOKEN_TYPE::EMPTY) {
+        return false;
+    }
+    DEBUG_MSG("token: " << possible_token);
+    emit_token(token_type, possible_token, possible_token);
+    return true;
+}
+
+int Lexer::parse_int(std::string_view literal) {
+    int value = 0;
+    auto [end, error] = std::from_chars(literal.data(), literal.data() + literal.size(), value);
+    if (error != std::errc()) {
+        report(INTEGER_OUT_OF_RANGE, literal.data());
+        return 0;
+    }
+    return value;
+}
+
+void Lexer::report(const char *message, const char *position) {
+    if (m_source && position >= m_source->data() && position <= m_source->data() + m_source->size()) {
+        m_diagnostics.report(message, m_source->location(position - m_source->data()));
+    } else {
+        m_diagnostics.report(message);
+    }
 }
 
+void Lexer::emit_token(TOKEN_TYPE type, std::string_view lexeme, std::string_view value) {
+    // keyword and operator spellings are interned once up front
+    Symbol symbol = type == TOKEN_TYPE::IDENTIFIER || type == TOKEN_TYPE::STRING
+                    ? Symbol::from_id(m_symbols.intern(value)) : token_symbol(type);
+    if (m_stream) {
+        m_stream->push_back(type, lexeme.data() - m_source->data(), lexeme.size(), symbol.m_id);
+    } else {
+        m_tokens->push_back({type, symbol});
+    }
+}
+
+void Lexer::emit_token(TOKEN_TYPE type, std::string_view lexeme, int value) {
+    if (m_stream) {
+        m_stream->push_back(type, lexeme.data() - m_source->data(), lexeme.size(), static_cast<uint32_t>(value));
+    } else {
+        m_tokens->push_back({type, value});
+    }
+}
+
+void Lexer::emit_token(TOKEN_TYPE type, std::string_view lexeme, char value) {
+    if (m_stream) {
+        m_stream->push_back(type, lexeme.data() - m_source->data(), lexeme.size(), static_cast<unsigned char>(value));
+    } else {
+        m_tokens->push_back({type, value});
+    }
+}
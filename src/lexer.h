@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <charconv>
 #include <vector>
 #include <fstream>
 #include <string>
@@ -10,33 +12,118 @@
 
 #include "macros.h"
 #include "exceptions.h"
+#include "diagnostics.h"
 #include "token.h"
+#include "source_buffer.h"
+#include "token_stream.h"
+#include "lexer_dfa.h"
+#include "simd_scan.h"
+#include "thread_pool.h"
 
 constexpr std::string_view LINE_COMMENT = "//";
 constexpr char STRING_DELIMITER = '"';
 constexpr char CHAR_DELIMITER = '\'';
 constexpr int CHAR_EXPRESSION_LENGTH = 3; // <delimiter><char><delimiter>
+constexpr ByteSet STRING_BODY_BYTES = make_byte_set([](unsigned char c) {
+    return c != STRING_DELIMITER && c != '\n';
+});
+
+constexpr const char *INTEGER_OUT_OF_RANGE = "integer literal out of range";
+constexpr const char *UNCLOSED_STRING_LITERAL = "unclosed string literal";
+constexpr const char *UNCLOSED_CHAR_LITERAL = "unclosed char literal";
+
+// smallest chunk worth handing to another thread when the chunk count is picked automatically
+constexpr size_t MIN_PARALLEL_CHUNK_BYTES = 1 << 20;
+
+enum class LEXER_CORE {
+    CASCADE, // per line, one scan_* function after the other
+    DFA,     // single table driven pass over the whole buffer
+};
 
 
 
 
 class Lexer {
 public:
+    explicit Lexer(LEXER_CORE core = LEXER_CORE::DFA) : m_core(core) {}
+
     std::unique_ptr<std::vector<Token>> lex(std::istream &file_to_lex);
 
+    std::unique_ptr<std::vector<Token>> lex(std::shared_ptr<const SourceBuffer> source);
+
+    std::unique_ptr<std::vector<Token>> lex_file(const std::string &path);
+
+    // compact structure-of-arrays output, token text stays in the source buffer
+    TokenStream lex_stream(std::shared_ptr<const SourceBuffer> source);
+
+    /*
+     * Same tokens as lex_stream, lexed as chunks split at newlines on the shared thread pool.
+     * Every chunk is lexed as if it started a line, a chunk whose predecessor didn't end in that state
+     * is relexed together with it, then the per chunk streams are copied into place in parallel.
+     * chunk_count 0 picks one chunk per thread, but none smaller than MIN_PARALLEL_CHUNK_BYTES.
+     * Always uses the DFA core.
+     */
+    TokenStream lex_stream_parallel(std::shared_ptr<const SourceBuffer> source, size_t chunk_count = 0);
+
+    // appends the tokens of source[begin, end) to tokens, lexing from entry_state with the DFA core,
+    // returns the state after the range. A range ending the buffer also flushes its last token.
+    uint8_t lex_range(std::shared_ptr<const SourceBuffer> source, TokenStream &tokens, size_t begin, size_t end,
+                      uint8_t entry_state = DFA_STATE_START);
+
+    /*
+     * Tokens of previous's source with edit applied, for editors relexing on every keystroke.
+     * Lexing restarts at the beginning of the edited line and stops at the first line end after the edit
+     * where the DFA is back in its start state, from there on the old tokens are reused with shifted offsets.
+     */
+    TokenStream relex(const TokenStream &previous, const TextEdit &edit);
+
+    // the buffer lexed last, kept alive so anything referencing its bytes stays valid
+    const std::shared_ptr<const SourceBuffer> &source() const { return m_source; }
+
+    /*
+     * Errors found by the last lex call, lexing goes on after each one: an unclosed literal is dropped up to
+     * its line end and an out of range integer becomes 0. lex_range adds to the errors of the calls before it,
+     * relex only reports the relexed lines.
+     */
+    const Diagnostics &diagnostics() const { return m_diagnostics; }
+
 private:
+    void lex_buffer();
+
     void lex_line(std::string_view statement);
 
-    bool scan_token(std::string_view possible_token, const std::map<std::string, TOKEN_TYPE> &search_tokens);
+    struct LexedChunk {
+        size_t m_begin;
+        size_t m_end;
+        uint8_t m_entry_state;
+        uint8_t m_exit_state;
+        TokenStream m_tokens;
+        Diagnostics m_diagnostics; // only meaningful once m_entry_state is known to be right
+    };
+
+    void lex_dfa();
+
+    // lexes [begin, end) starting in entry_state and returns the state after the last byte,
+    // the range ending the buffer also gets the virtual newline that flushes the last token
+    uint8_t lex_dfa(size_t begin, size_t end, uint8_t entry_state);
+
+    LexedChunk lex_chunk(size_t begin, size_t end, uint8_t entry_state) const;
+
+    std::vector<size_t> chunk_boundaries(size_t chunk_count) const;
+
+    void emit_lexeme(uint8_t dfa_emit, std::string_view lexeme);
+
+    // emits possible_token when the table lookup found a token type for it
+    bool scan_token(std::string_view possible_token, TOKEN_TYPE token_type);
 
     template<typename Iterator>
     bool scan_line_comment(std::string_view statement, const Iterator &it) {
-        if (std::distance(it, statement.end()) + 1 >= LINE_COMMENT.size()) {
+        if (static_cast<size_t>(std::distance(it, statement.end())) >= LINE_COMMENT.size()) {
 
             std::string_view token_value(it, LINE_COMMENT.size());
 
             if (!token_value.compare(LINE_COMMENT)) {
-                DEBUG_MSG("Skipping line comment: " << it);
+                DEBUG_MSG("Skipping line comment: " << std::string_view(it, statement.end()));
                 return true;
             }
         }
@@ -45,11 +132,11 @@ private:
 
     template<typename Iterator>
     size_t scan_compound_operator(std::string_view statement, const Iterator &it) {
-        if (std::distance(it, statement.end()) + 1 >= COMPOUND_OPERATOR_SIZE) {
+        if (std::distance(it, statement.end()) >= COMPOUND_OPERATOR_SIZE) {
 
             std::string_view token_value(it, COMPOUND_OPERATOR_SIZE);
 
-            if (scan_token(token_value, COMPOUND_OPERATORS)) {
+            if (scan_token(token_value, COMPOUND_OPERATOR_TABLE.find(token_value))) {
                 return COMPOUND_OPERATOR_SIZE;
             }
         }
@@ -62,33 +149,27 @@ private:
 
         std::string_view token_value(it, SINGLE_OPERATOR_SIZE);
 
-        if (scan_token(token_value, SINGLE_OPERATORS)) {
+        if (scan_token(token_value, SINGLE_OPERATOR_TABLE[static_cast<unsigned char>(*it)])) {
             return SINGLE_OPERATOR_SIZE;
         }
         return 0;
     }
 
-    template<class Iterator>
-    size_t scan_whitespace(Iterator &it) {
-
-        // TODO: update column and rows when available
-        return 0;
-    }
-
     template<typename Iterator>
     size_t scan_literal_string(std::string_view statement, const Iterator &it) {
 
         if (*it == STRING_DELIMITER) {
 
-            auto string_end_it = std::find(it + 1, // skip current delimiter
-                                           statement.end(),
-                                           STRING_DELIMITER);
+            auto string_end_it = it + (skip_byte_set(pointer_to(statement, it) + 1, // skip current delimiter
+                                                     statement.data() + statement.size(),
+                                                     STRING_BODY_BYTES) - pointer_to(statement, it));
             if (string_end_it == statement.end()) {
-                throw CompilerException("unclosed string literal");
+                report(UNCLOSED_STRING_LITERAL, pointer_to(statement, it));
+                return std::distance(it, statement.end());
             }
-            std::string string_token(it + 1, string_end_it);
+            std::string_view string_token(it + 1, string_end_it);
             DEBUG_MSG("string token: \"" << string_token << "\"");
-            m_tokens->push_back({TOKEN_TYPE::STRING, string_token});
+            emit_token(TOKEN_TYPE::STRING, std::string_view(it, string_end_it + 1), string_token);
             return std::distance(it, string_end_it) + 1; // add one to skip last delimiter
         }
 
@@ -97,17 +178,18 @@ private:
 
     template<typename Iterator>
     size_t scan_literal_char(std::string_view statement, const Iterator &it) {
-        if (std::distance(it, statement.end()) + 1 >= CHAR_EXPRESSION_LENGTH) {
-            if (*it == CHAR_DELIMITER) {
-                if (*(it + 2) != CHAR_DELIMITER) // expected char delimiter as expression suffix
-                {
-                    throw CompilerException("unclosed char literal");
-                }
-                char char_token = *(it + 1);
-                DEBUG_MSG("char token: '" << std::string(1, char_token) << "'");
-                m_tokens->push_back({TOKEN_TYPE::CHARACTER, char_token});
-                return CHAR_EXPRESSION_LENGTH;
+        if (*it == CHAR_DELIMITER) {
+            if (std::distance(it, statement.end()) < CHAR_EXPRESSION_LENGTH ||
+                *(it + 2) != CHAR_DELIMITER) // expected char delimiter as expression suffix
+            {
+                // drops as much as the DFA core does: the delimiter, the char and the byte which should've closed it
+                report(UNCLOSED_CHAR_LITERAL, pointer_to(statement, it));
+                return std::min<size_t>(CHAR_EXPRESSION_LENGTH, std::distance(it, statement.end()));
             }
+            char char_token = *(it + 1);
+            DEBUG_MSG("char token: '" << std::string(1, char_token) << "'");
+            emit_token(TOKEN_TYPE::CHARACTER, std::string_view(it, CHAR_EXPRESSION_LENGTH), char_token);
+            return CHAR_EXPRESSION_LENGTH;
         }
         return 0;
     }
@@ -115,42 +197,63 @@ private:
     template<typename Iterator>
     size_t scan_literal_int(std::string_view statement, const Iterator &it) {
         if(std::isdigit(*it)){
-            for (auto int_it = it; int_it < statement.end(); ++int_it){
-                if(!std::isdigit(*int_it)){
-                    std::string string_int(it, int_it);
-                    DEBUG_MSG("int literal token: " << string_int);
-                    m_tokens->push_back({TOKEN_TYPE::INTEGER, std::stoi(string_int)});
-                    return std::distance(it, int_it);
-                }
-            }
+            // a literal may run until the end of the line
+            auto int_end = it + (skip_byte_set(pointer_to(statement, it), statement.data() + statement.size(),
+                                               DIGIT_BYTES) - pointer_to(statement, it));
+            std::string_view string_int(it, int_end);
+            DEBUG_MSG("int literal token: " << string_int);
+            emit_token(TOKEN_TYPE::INTEGER, string_int, parse_int(string_int));
+            return string_int.size();
         }
         return 0;
     }
 
     template<typename Iterator>
     size_t scan_keyword_identifier(std::string_view statement, const Iterator&it){
-        // first letter of all keywords / identifiers is alphabetical
-        if(std::isalpha(*it)){
-            for (auto word_it = it; word_it < statement.end(); ++word_it){
-                // non first letter in an identifier can be alphanumeric
-                if(!std::isalnum(*word_it) && *word_it != '_'){
-                    std::string word_string(it, word_it);
-                    if(KEYWORDS.find(word_string) != KEYWORDS.end())
-                    {
-                        DEBUG_MSG("keyword token: " << word_string);
-                        m_tokens->push_back({KEYWORDS.at(word_string), word_string});
-                    }
-                    else{
-                        DEBUG_MSG("identifier token: " << word_string);
-                        m_tokens->push_back({TOKEN_TYPE::IDENTIFIER, word_string});
-                    }
-                    return std::distance(it, word_it);
-                }
+        // first letter of all keywords / identifiers is alphabetical or an underscore
+        if(std::isalpha(*it) || *it == '_'){
+            // non first letter in an identifier can be alphanumeric, a word may run until the end of the line
+            auto word_end = it + (skip_byte_set(pointer_to(statement, it), statement.data() + statement.size(),
+                                                IDENTIFIER_BYTES) - pointer_to(statement, it));
+            std::string_view word(it, word_end);
+            TOKEN_TYPE keyword = KEYWORD_TABLE.find(word);
+            if(keyword != TOKEN_TYPE::EMPTY)
+            {
+                DEBUG_MSG("keyword token: " << word);
+                emit_token(keyword, word, word);
+            }
+            else{
+                DEBUG_MSG("identifier token: " << word);
+                emit_token(TOKEN_TYPE::IDENTIFIER, word, word);
             }
+            return word.size();
         }
         return 0;
     }
 
+    template<typename Iterator>
+    static const char *pointer_to(std::string_view statement, const Iterator &it) {
+        return statement.data() + std::distance(statement.begin(), it);
+    }
+
+    // out of range literals are reported and read as 0
+    int parse_int(std::string_view literal);
+
+    // locates position when it points into the source buffer, lines read from a stream have no location
+    void report(const char *message, const char *position);
+
+    // appends to the token stream when lexing into one, otherwise to the token vector
+    void emit_token(TOKEN_TYPE type, std::string_view lexeme, std::string_view value);
+
+    void emit_token(TOKEN_TYPE type, std::string_view lexeme, int value);
+
+    void emit_token(TOKEN_TYPE type, std::string_view lexeme, char value);
+
+    LEXER_CORE m_core;
     std::unique_ptr<std::vector<Token>> m_tokens;
+    std::shared_ptr<const SourceBuffer> m_source;
+    TokenStream *m_stream = nullptr;
+    SymbolCache m_symbols;
+    Diagnostics m_diagnostics;
 };
 
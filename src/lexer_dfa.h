@@ -0,0 +1,238 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "token.h"
+#include "simd_scan.h"
+
+/*
+ * Transition table of the single pass lexer core.
+ * Every byte is classified once through DFA_TABLES.m_classes, the (state, class) pair then says which token
+ * (if any) ended before the byte, whether the byte starts a new token, and which token (if any) ends on it.
+ * Operator states and character classes are generated from the spelling lists in token.h.
+ */
+
+// character classes, compound operator characters get a class each starting at DFA_FIRST_OPERATOR_CLASS
+constexpr uint8_t DFA_CLASS_OTHER = 0; // whitespace and anything that isn't part of a token
+constexpr uint8_t DFA_CLASS_NEWLINE = 1;
+constexpr uint8_t DFA_CLASS_LETTER = 2;
+constexpr uint8_t DFA_CLASS_DIGIT = 3;
+constexpr uint8_t DFA_CLASS_QUOTE = 4;
+constexpr uint8_t DFA_CLASS_APOSTROPHE = 5;
+constexpr uint8_t DFA_CLASS_SLASH = 6;
+constexpr uint8_t DFA_CLASS_SINGLE_OPERATOR = 7;
+constexpr uint8_t DFA_FIRST_OPERATOR_CLASS = 8;
+constexpr uint8_t DFA_MAX_CLASSES = 16;
+
+// states, one state per compound operator prefix starting at DFA_FIRST_PREFIX_STATE
+constexpr uint8_t DFA_STATE_START = 0;
+constexpr uint8_t DFA_STATE_WORD = 1;
+constexpr uint8_t DFA_STATE_INTEGER = 2;
+constexpr uint8_t DFA_STATE_STRING = 3;
+constexpr uint8_t DFA_STATE_COMMENT = 4;
+constexpr uint8_t DFA_STATE_SLASH = 5;
+constexpr uint8_t DFA_STATE_CHAR_OPEN = 6;
+constexpr uint8_t DFA_STATE_CHAR_BODY = 7;
+constexpr uint8_t DFA_FIRST_PREFIX_STATE = 8;
+constexpr uint8_t DFA_MAX_STATES = 16;
+
+// kinds of emitted lexemes
+constexpr uint8_t DFA_EMIT_NONE = 0;
+constexpr uint8_t DFA_EMIT_WORD = 1;
+constexpr uint8_t DFA_EMIT_INTEGER = 2;
+constexpr uint8_t DFA_EMIT_STRING = 3;
+constexpr uint8_t DFA_EMIT_CHARACTER = 4;
+constexpr uint8_t DFA_EMIT_OPERATOR = 5;
+
+// transition flags
+constexpr uint8_t DFA_FLAG_STARTS_TOKEN = 1;
+constexpr uint8_t DFA_FLAG_UNCLOSED_STRING = 2;
+constexpr uint8_t DFA_FLAG_UNCLOSED_CHAR = 4;
+constexpr uint8_t DFA_ERROR_FLAGS = DFA_FLAG_UNCLOSED_STRING | DFA_FLAG_UNCLOSED_CHAR;
+
+struct DfaTransition {
+    uint8_t m_next;
+    uint8_t m_emit_before;  // lexeme [token start, current byte) is complete
+    uint8_t m_emit_through; // lexeme [token start, current byte] is complete
+    uint8_t m_flags;
+};
+
+struct DfaTables {
+    std::array<uint8_t, 256> m_classes{};
+    std::array<char, DFA_MAX_CLASSES> m_class_chars{};
+    std::array<DfaTransition, DFA_MAX_STATES * DFA_MAX_CLASSES> m_transitions{};
+    // bytes on which a state loops back to itself without emitting, runs of them are skipped in a tight loop
+    std::array<std::array<bool, 256>, DFA_MAX_STATES> m_self_loops{};
+    uint8_t m_class_count = DFA_FIRST_OPERATOR_CLASS;
+    uint8_t m_state_count = DFA_FIRST_PREFIX_STATE;
+
+    constexpr const DfaTransition &transition(uint8_t state, uint8_t char_class) const {
+        return m_transitions[state * DFA_MAX_CLASSES + char_class];
+    }
+};
+
+consteval DfaTables make_dfa_tables() {
+    DfaTables tables;
+    auto &classes = tables.m_classes;
+
+    for (int c = 0; c < 256; ++c) {
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') {
+            classes[c] = DFA_CLASS_LETTER;
+        } else if (c >= '0' && c <= '9') {
+            classes[c] = DFA_CLASS_DIGIT;
+        }
+    }
+    classes['\n'] = DFA_CLASS_NEWLINE;
+    classes['"'] = DFA_CLASS_QUOTE;
+    classes['\''] = DFA_CLASS_APOSTROPHE;
+    for (const auto &[spelling, type]: SINGLE_OPERATOR_SPELLINGS) {
+        classes[static_cast<unsigned char>(spelling[0])] = DFA_CLASS_SINGLE_OPERATOR;
+    }
+    classes['/'] = DFA_CLASS_SLASH; // operator or start of a comment
+
+    std::array<uint8_t, 256> prefix_states{};
+    for (const auto &[spelling, type]: COMPOUND_OPERATOR_SPELLINGS) {
+        for (char c: spelling) {
+            auto &char_class = classes[static_cast<unsigned char>(c)];
+            if (char_class < DFA_FIRST_OPERATOR_CLASS) {
+                if (tables.m_class_count == DFA_MAX_CLASSES) {
+                    throw "too many compound operator characters";
+                }
+                tables.m_class_chars[tables.m_class_count] = c;
+                char_class = tables.m_class_count++;
+            }
+        }
+        auto &prefix_state = prefix_states[static_cast<unsigned char>(spelling[0])];
+        if (prefix_state == 0) {
+            if (tables.m_state_count == DFA_MAX_STATES) {
+                throw "too many compound operator prefixes";
+            }
+            prefix_state = tables.m_state_count++;
+        }
+    }
+
+    auto is_single_operator = [](char c) {
+        for (const auto &[spelling, type]: SINGLE_OPERATOR_SPELLINGS) {
+            if (spelling[0] == c) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto is_compound_operator = [](char first, char second) {
+        for (const auto &[spelling, type]: COMPOUND_OPERATOR_SPELLINGS) {
+            if (spelling[0] == first && spelling[1] == second) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto set = [&tables](uint8_t state, uint8_t char_class, DfaTransition transition) {
+        tables.m_transitions[state * DFA_MAX_CLASSES + char_class] = transition;
+    };
+
+    // a token begins
+    set(DFA_STATE_START, DFA_CLASS_OTHER, {DFA_STATE_START, DFA_EMIT_NONE, DFA_EMIT_NONE, 0});
+    set(DFA_STATE_START, DFA_CLASS_NEWLINE, {DFA_STATE_START, DFA_EMIT_NONE, DFA_EMIT_NONE, 0});
+    set(DFA_STATE_START, DFA_CLASS_LETTER, {DFA_STATE_WORD, DFA_EMIT_NONE, DFA_EMIT_NONE, DFA_FLAG_STARTS_TOKEN});
+    set(DFA_STATE_START, DFA_CLASS_DIGIT, {DFA_STATE_INTEGER, DFA_EMIT_NONE, DFA_EMIT_NONE, DFA_FLAG_STARTS_TOKEN});
+    set(DFA_STATE_START, DFA_CLASS_QUOTE, {DFA_STATE_STRING, DFA_EMIT_NONE, DFA_EMIT_NONE, DFA_FLAG_STARTS_TOKEN});
+    set(DFA_STATE_START, DFA_CLASS_APOSTROPHE,
+        {DFA_STATE_CHAR_OPEN, DFA_EMIT_NONE, DFA_EMIT_NONE, DFA_FLAG_STARTS_TOKEN});
+    set(DFA_STATE_START, DFA_CLASS_SLASH, {DFA_STATE_SLASH, DFA_EMIT_NONE, DFA_EMIT_NONE, DFA_FLAG_STARTS_TOKEN});
+    set(DFA_STATE_START, DFA_CLASS_SINGLE_OPERATOR,
+        {DFA_STATE_START, DFA_EMIT_NONE, DFA_EMIT_OPERATOR, DFA_FLAG_STARTS_TOKEN});
+    for (uint8_t char_class = DFA_FIRST_OPERATOR_CLASS; char_class < tables.m_class_count; ++char_class) {
+        char c = tables.m_class_chars[char_class];
+        auto prefix_state = prefix_states[static_cast<unsigned char>(c)];
+        if (prefix_state != 0) {
+            set(DFA_STATE_START, char_class, {prefix_state, DFA_EMIT_NONE, DFA_EMIT_NONE, DFA_FLAG_STARTS_TOKEN});
+        } else if (is_single_operator(c)) {
+            set(DFA_STATE_START, char_class, {DFA_STATE_START, DFA_EMIT_NONE, DFA_EMIT_OPERATOR, DFA_FLAG_STARTS_TOKEN});
+        } else {
+            set(DFA_STATE_START, char_class, {DFA_STATE_START, DFA_EMIT_NONE, DFA_EMIT_NONE, 0});
+        }
+    }
+
+    // the pending token ends before this byte, which is then handled as if in the start state
+    auto restart = [&tables](uint8_t char_class, uint8_t emit) {
+        DfaTransition transition = tables.transition(DFA_STATE_START, char_class);
+        transition.m_emit_before = emit;
+        return transition;
+    };
+
+    for (uint8_t char_class = 0; char_class < tables.m_class_count; ++char_class) {
+        bool is_word_char = char_class == DFA_CLASS_LETTER || char_class == DFA_CLASS_DIGIT;
+        set(DFA_STATE_WORD, char_class, is_word_char ? DfaTransition{DFA_STATE_WORD, DFA_EMIT_NONE, DFA_EMIT_NONE, 0}
+                                                     : restart(char_class, DFA_EMIT_WORD));
+        set(DFA_STATE_INTEGER, char_class, char_class == DFA_CLASS_DIGIT
+                                           ? DfaTransition{DFA_STATE_INTEGER, DFA_EMIT_NONE, DFA_EMIT_NONE, 0}
+                                           : restart(char_class, DFA_EMIT_INTEGER));
+
+        // literals and comments never span lines
+        if (char_class == DFA_CLASS_QUOTE) {
+            set(DFA_STATE_STRING, char_class, {DFA_STATE_START, DFA_EMIT_NONE, DFA_EMIT_STRING, 0});
+        } else if (char_class == DFA_CLASS_NEWLINE) {
+            set(DFA_STATE_STRING, char_class, {DFA_STATE_START, DFA_EMIT_NONE, DFA_EMIT_NONE, DFA_FLAG_UNCLOSED_STRING});
+        } else {
+            set(DFA_STATE_STRING, char_class, {DFA_STATE_STRING, DFA_EMIT_NONE, DFA_EMIT_NONE, 0});
+        }
+        set(DFA_STATE_COMMENT, char_class, char_class == DFA_CLASS_NEWLINE
+                                           ? DfaTransition{DFA_STATE_START, DFA_EMIT_NONE, DFA_EMIT_NONE, 0}
+                                           : DfaTransition{DFA_STATE_COMMENT, DFA_EMIT_NONE, DFA_EMIT_NONE, 0});
+        set(DFA_STATE_SLASH, char_class, char_class == DFA_CLASS_SLASH
+                                         ? DfaTransition{DFA_STATE_COMMENT, DFA_EMIT_NONE, DFA_EMIT_NONE, 0}
+                                         : restart(char_class, DFA_EMIT_OPERATOR));
+
+        // <delimiter><any char><delimiter>
+        set(DFA_STATE_CHAR_OPEN, char_class, char_class == DFA_CLASS_NEWLINE
+                                             ? DfaTransition{DFA_STATE_START, DFA_EMIT_NONE, DFA_EMIT_NONE,
+                                                             DFA_FLAG_UNCLOSED_CHAR}
+                                             : DfaTransition{DFA_STATE_CHAR_BODY, DFA_EMIT_NONE, DFA_EMIT_NONE, 0});
+        set(DFA_STATE_CHAR_BODY, char_class, char_class == DFA_CLASS_APOSTROPHE
+                                             ? DfaTransition{DFA_STATE_START, DFA_EMIT_NONE, DFA_EMIT_CHARACTER, 0}
+                                             : DfaTransition{DFA_STATE_START, DFA_EMIT_NONE, DFA_EMIT_NONE,
+                                                             DFA_FLAG_UNCLOSED_CHAR});
+    }
+
+    for (int first = 0; first < 256; ++first) {
+        uint8_t prefix_state = prefix_states[first];
+        if (prefix_state == 0) {
+            continue;
+        }
+        for (uint8_t char_class = 0; char_class < tables.m_class_count; ++char_class) {
+            if (char_class >= DFA_FIRST_OPERATOR_CLASS &&
+                is_compound_operator(static_cast<char>(first), tables.m_class_chars[char_class])) {
+                set(prefix_state, char_class, {DFA_STATE_START, DFA_EMIT_NONE, DFA_EMIT_OPERATOR, 0});
+            } else {
+                set(prefix_state, char_class, restart(char_class, DFA_EMIT_OPERATOR));
+            }
+        }
+    }
+
+    for (uint8_t state = 0; state < tables.m_state_count; ++state) {
+        for (int c = 0; c < 256; ++c) {
+            const auto &transition = tables.transition(state, classes[c]);
+            tables.m_self_loops[state][c] = transition.m_next == state &&
+                                            transition.m_emit_before == DFA_EMIT_NONE &&
+                                            transition.m_emit_through == DFA_EMIT_NONE && transition.m_flags == 0;
+        }
+    }
+
+    return tables;
+}
+
+constexpr DfaTables DFA_TABLES = make_dfa_tables();
+
+consteval std::array<ByteSet, DFA_MAX_STATES> make_dfa_self_loop_sets() {
+    std::array<ByteSet, DFA_MAX_STATES> sets{};
+    for (uint8_t state = 0; state < DFA_MAX_STATES; ++state) {
+        sets[state] = make_byte_set(DFA_TABLES.m_self_loops[state]);
+    }
+    return sets;
+}
+
+// vectorized form of m_self_loops
+constexpr std::array<ByteSet, DFA_MAX_STATES> DFA_SELF_LOOP_SETS = make_dfa_self_loop_sets();
@@ -1,8 +1,22 @@
+#include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include "ast_cache.h"
+#include "constant_folder.h"
+#include "ir_builder.h"
+#include "ir_verifier.h"
 #include "lexer.h"
+#include "name_resolver.h"
+#include "type_checker.h"
+#include "parser.hpp"
 #include "macros.h"
 
+// directory of the lexed and parsed translation unit cache, no caching when unset
+constexpr const char *CACHE_DIRECTORY_VARIABLE = "C_COMPILER_CACHE_DIR";
+// a pass broke an IR invariant, a bug in the compiler rather than in the program
+constexpr const char *INVALID_IR = "internal compiler error: lowering produced invalid IR";
+
 int main(int argc, char **argv) {
     if (argc != 2) {
         std::cout << "Unsupported syntax!" << std::endl << "Supported Syntax: ./c_compiler <code.c>" << std::endl;
@@ -10,10 +24,77 @@ int main(int argc, char **argv) {
     }
 
     DEBUG_MSG("Compiling " << argv[1]);
-    std::ifstream input_file(argv[1]);
+    std::shared_ptr<const SourceBuffer> source;
+    try {
+        source = SourceBuffer::from_file(argv[1]);
+    }
+    catch (CompilerException &exc) {
+        std::cerr << argv[1] << ": error: " << exc.what() << std::endl;
+        return 1;
+    }
+
+    // entries are only stored for sources which went through every pass without an error, and the compiler has
+    // nothing to emit besides its diagnostics, so an unchanged file compiled cleanly before is done once it maps
+    std::optional<AstCache> cache;
+    if (const char *cache_directory = std::getenv(CACHE_DIRECTORY_VARIABLE)) {
+        cache.emplace(cache_directory);
+        if (auto cached = cache->load(source->view())) {
+            DEBUG_MSG("cache hit, " << cached->roots().size() << " declarations");
+            return 0;
+        }
+    }
 
     Lexer lexer;
-    auto tokens = lexer.lex(input_file);
+    TokenStream tokens = lexer.lex_stream(source);
+    Parser parser;
+    auto it = tokens.begin();
+    NodeList declarations = parser.parse_translation_unit(it, tokens.end());
+    DEBUG_MSG("parsed " << declarations.size() << " declarations");
+
+    NameResolver resolver;
+    resolver.resolve(declarations, source.get());
+    DEBUG_MSG("resolved " << resolver.resolved_count() << " references");
+    TypeChecker checker(resolver);
+    checker.check(declarations);
+
+    lexer.diagnostics().print(std::cerr, argv[1]);
+    parser.diagnostics().print(std::cerr, argv[1]);
+    resolver.diagnostics().print(std::cerr, argv[1]);
+    checker.diagnostics().print(std::cerr, argv[1]);
+    if (!lexer.diagnostics().empty() || !parser.diagnostics().empty() || !resolver.diagnostics().empty() ||
+        !checker.diagnostics().empty()) {
+        return 1;
+    }
 
+    ConstantFolder folder;
+    folder.fold(declarations, source.get());
+    DEBUG_MSG("folded " << folder.folded_count() << " operations");
+    folder.diagnostics().print(std::cerr, argv[1]);
+    if (!folder.diagnostics().empty()) {
+        return 1;
+    }
+
+    IrBuilder builder(resolver, checker);
+    std::vector<IrFunction> functions = builder.lower(declarations);
+    DEBUG_MSG("lowered " << functions.size() << " functions");
+#ifndef NDEBUG
+    IrVerifier verifier;
+    for (const IrFunction &function: functions) {
+        verifier.verify(function);
+    }
+    verifier.diagnostics().print(std::cerr, argv[1]);
+    if (!verifier.diagnostics().empty()) {
+        std::cerr << argv[1] << ": error: " << INVALID_IR << std::endl;
+        return 1;
+    }
+#endif
+
+    if (cache) {
+        FlatAst ast;
+        for (const ASTNode *declaration: declarations) {
+            ast.add_tree(declaration);
+        }
+        cache->store(source->view(), tokens, ast);
+    }
     return 0;
 }
\ No newline at end of file
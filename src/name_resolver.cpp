@@ -0,0 +1,103 @@
+#include "name_resolver.h"
+
+#include <vector>
+
+#include "ast_visitor.h"
+
+namespace {
+
+    uint32_t name_of(const ASTNode *node) {
+        return std::get<Symbol>(node->m_token.m_value).m_id;
+    }
+
+    bool is_definition(const ASTNode *node) {
+        if (node_kind(*node) != NODE_KIND::FUNC_DECLARATION) {
+            return false;
+        }
+        const auto &function = std::get<FuncDeclaration>(node->m_members);
+        return function.body || function.deferred_body != NO_DEFERRED_BODY;
+    }
+}
+
+void NameResolver::resolve(const NodeList &declarations, const SourceBuffer *source) {
+    m_source = source;
+    // a function's parameters and its body's statements share the scope the function opens
+    struct Visitor {
+        NameResolver &m_resolver;
+        std::vector<const ASTNode *> m_functions; // being walked, a prototype in a body nests in its function
+
+        bool is_function_body(const ASTNode *block) const {
+            return !m_functions.empty() && std::get<FuncDeclaration>(m_functions.back()->m_members).body == block;
+        }
+
+        void enter(TreeNode tree_node) {
+            const ASTNode *node = tree_node.node();
+            switch (tree_node.kind()) {
+                case NODE_KIND::LEAF:
+                    if (node->m_token.m_type == TOKEN_TYPE::IDENTIFIER) {
+                        m_resolver.reference(node);
+                    }
+                    break;
+                case NODE_KIND::FUNC_CALL:
+                    m_resolver.reference(node);
+                    break;
+                case NODE_KIND::VARIABLE_DECLARATION:
+                    m_resolver.declare(node);
+                    break;
+                case NODE_KIND::FUNC_DECLARATION:
+                    // the function is visible in its own body
+                    m_resolver.declare(node);
+                    m_resolver.m_symbols.enter_scope();
+                    m_functions.push_back(node);
+                    break;
+                case NODE_KIND::BLOCK:
+                    if (!is_function_body(node)) {
+                        m_resolver.m_symbols.enter_scope();
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void leave(TreeNode tree_node) {
+            if (tree_node.kind() == NODE_KIND::FUNC_DECLARATION) {
+                m_resolver.m_symbols.leave_scope();
+                m_functions.pop_back();
+            } else if (tree_node.kind() == NODE_KIND::BLOCK && !is_function_body(tree_node.node())) {
+                m_resolver.m_symbols.leave_scope();
+            }
+        }
+    };
+    Visitor visitor{*this, {}};
+    for (const ASTNode *declaration: declarations) {
+        walk(TreeNode(declaration), visitor);
+    }
+}
+
+void NameResolver::declare(const ASTNode *declaration) {
+    if (declaration->m_token.m_type == TOKEN_TYPE::EMPTY) {
+        return; // unnamed parameter
+    }
+    const ASTNode *previous = m_symbols.declare(name_of(declaration), declaration);
+    if (!previous) {
+        return;
+    }
+    bool both_functions = node_kind(*previous) == NODE_KIND::FUNC_DECLARATION &&
+                          node_kind(*declaration) == NODE_KIND::FUNC_DECLARATION;
+    if (both_functions && !(is_definition(previous) && is_definition(declaration))) {
+        if (is_definition(declaration)) {
+            m_symbols.replace(name_of(declaration), declaration);
+        }
+        return;
+    }
+    report(DUPLICATE_DECLARATION + declaration->m_token.to_string(), declaration);
+}
+
+void NameResolver::reference(const ASTNode *node) {
+    if (const ASTNode *declaration = m_symbols.lookup(name_of(node))) {
+        m_resolutions[node] = declaration;
+    } else {
+        report(UNDECLARED_IDENTIFIER + node->m_token.to_string(), node);
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "ast.h"
+#include "diagnostics.h"
+#include "symbol_table.h"
+
+constexpr const char *UNDECLARED_IDENTIFIER = "use of undeclared identifier: ";
+constexpr const char *DUPLICATE_DECLARATION = "redeclaration of: ";
+
+/*
+ * Semantic pass binding every identifier reference (a variable leaf or a call) to the declaration it names,
+ * following C's scopes: file scope, a function's parameters and outermost body block sharing one scope,
+ * every other block opening its own. A name is visible from its declaration on.
+ * Functions may be declared any number of times but defined once, the definition is what references
+ * resolve to once it's been seen. Unparsed lazy bodies are skipped.
+ * Diagnostics are located at the node they're about when given the source the tree was parsed from.
+ */
+class NameResolver {
+public:
+    // resolves the declarations of a translation unit, errors are reported into diagnostics()
+    void resolve(const NodeList &declarations, const SourceBuffer *source = nullptr);
+
+    // what the declarations were parsed from, null when resolve wasn't given it
+    const SourceBuffer *source() const { return m_source; }
+
+    // the VARIABLE_DECLARATION or FUNC_DECLARATION reference names, null when it didn't resolve
+    const ASTNode *declaration_of(const ASTNode *reference) const {
+        auto found = m_resolutions.find(reference);
+        return found == m_resolutions.end() ? nullptr : found->second;
+    }
+
+    size_t resolved_count() const { return m_resolutions.size(); }
+
+    const Diagnostics &diagnostics() const { return m_diagnostics; }
+
+private:
+    void declare(const ASTNode *declaration);
+
+    void reference(const ASTNode *node);
+
+    void report(std::string message, const ASTNode *node) {
+        m_diagnostics.report(std::move(message), node_location(*node, m_source));
+    }
+
+    SymbolTable m_symbols;
+    std::unordered_map<const ASTNode *, const ASTNode *> m_resolutions;
+    Diagnostics m_diagnostics;
+    const SourceBuffer *m_source = nullptr;
+};
@@ -4,61 +4,15 @@
 #include <string>
 #include <memory>
 #include <optional>
-#include <stack>
+#include <type_traits>
 
 #include "lexer.h"
+#include "ast.h"
+#include "diagnostics.h"
+#include "thread_pool.h"
+#include "token_cursor.h"
 
 
-struct ASTNode;
-
-struct BinaryOperation {
-    BinaryOperation(std::unique_ptr<ASTNode> lhs, std::unique_ptr<ASTNode> rhs) : lhs(std::move(lhs)),
-                                                                                  rhs(std::move(rhs)) {}
-
-    std::unique_ptr<ASTNode> rhs;
-    std::unique_ptr<ASTNode> lhs;
-};
-
-struct FuncCall {
-    std::vector<std::unique_ptr<ASTNode>> arg;
-};
-
-struct Block {
-    std::vector<std::unique_ptr<ASTNode>> statements;
-};
-
-
-struct VariableDeclaration {
-    Token type;
-};
-
-struct FuncDeclaration {
-    Token return_type;
-    std::vector<Token> args_types;
-};
-
-struct ASTNode {
-    ASTNode(const Token &token) : m_token(token) {};
-
-    ASTNode(const Token &token, FuncCall &&func_members) : m_token(token), m_members(std::move(func_members)) {};
-
-    ASTNode(const Token &token, BinaryOperation &&operation_members) : m_token(token),
-                                                                       m_members(std::move(operation_members)) {};
-
-    ASTNode(const Token &token, VariableDeclaration &&variable_declaration) : m_token(token),
-                                                                              m_members(std::move(
-                                                                                      variable_declaration)) {};
-
-    ASTNode(const Token &token, FuncDeclaration &&function_declaration) : m_token(token),
-                                                                          m_members(std::move(function_declaration)) {};
-
-    ASTNode(const Token &token, Block &&block) : m_token(token),
-                                                 m_members(std::move(block)) {};
-
-    Token m_token;
-    std::variant<std::monostate, FuncCall, BinaryOperation, VariableDeclaration, FuncDeclaration, Block> m_members;
-};
-
 constexpr const char *NON_COMMA_SEPARATED_ARGS_ERROR = "unexpected two arguments in a row";
 constexpr const char *NON_SEMICOLON_STATEMENT_SUFFIX = "missing an expected semicolon at the end of the statement";
 constexpr const char *VARIABLE_DEFINITION_WITHOUT_TYPE = "missing a type at variable definition";
@@ -72,87 +26,224 @@ constexpr const char *DANGLING_FUNC_DECLARATION = "Expected opening parentheses
 constexpr const char *FUNC_DECLARATION_PARAM_MISSING_TYPE = "Expected parameter type in function declaration";
 
 constexpr const char *UNCLOSED_SCOPE = "Expected scope close suffix";
+constexpr const char *UNEXPECTED_END_OF_EXPRESSION = "Expected an expression before the end of the statement";
+constexpr const char *UNCLOSED_PARENTHESES = "Expected a closing parentheses after the expression";
+constexpr const char *UNCLOSED_INDEX = "Expected a closing bracket after the index";
+constexpr const char *UNCLOSED_FUNC_CALL = "unclosed function call";
+constexpr const char *UNCLOSED_FUNC_DECLARATION = "unclosed function declaration";
+constexpr const char *UNSUPPORTED_FACTOR = "unsupported factor token: ";
+constexpr const char *MISSING_CONDITION = "Expected a parenthesized condition";
+constexpr const char *EXPECTED_BLOCK = "Expected an opening brace";
+constexpr const char *MISSING_STATEMENT = "Expected a statement before the end of the input";
+constexpr const char *JUMP_OUTSIDE_LOOP = "break / continue outside of a loop";
+constexpr const char *EXPECTED_DECLARATION = "Expected a declaration or function definition";
+constexpr const char *POINTER_DEPTH_LIMIT = "too many levels of pointers";
+
+// how tightly each binary operator binds, indexed by TOKEN_TYPE, 0 for tokens which aren't binary operators
+constexpr std::array<uint8_t, TOKEN_TYPE_COUNT> BINARY_PRECEDENCE = [] {
+    std::array<uint8_t, TOKEN_TYPE_COUNT> precedence{};
+    constexpr std::array<std::pair<TOKEN_TYPE, uint8_t>, ARITHMETIC_TOKENS.size()> levels = {{
+            {TOKEN_TYPE::LOR, 1},
+            {TOKEN_TYPE::LAND, 2},
+            {TOKEN_TYPE::PIPE, 3},
+            {TOKEN_TYPE::AMP, 4},
+            {TOKEN_TYPE::EQ, 5}, {TOKEN_TYPE::NEQ, 5},
+            {TOKEN_TYPE::LESS, 6}, {TOKEN_TYPE::GREAT, 6}, {TOKEN_TYPE::LEQ, 6}, {TOKEN_TYPE::GEQ, 6},
+            {TOKEN_TYPE::ADD, 7}, {TOKEN_TYPE::SUB, 7},
+            {TOKEN_TYPE::STAR, 8}, {TOKEN_TYPE::DIV, 8}, {TOKEN_TYPE::MOD, 8},
+    }};
+    for (const auto &[type, level]: levels) {
+        precedence[static_cast<size_t>(type)] = level;
+    }
+    return precedence;
+}();
+
+// prefix operators, indexed by TOKEN_TYPE, mapped to the token type of the node they make
+constexpr std::array<TOKEN_TYPE, TOKEN_TYPE_COUNT> UNARY_OPERATORS = [] {
+    std::array<TOKEN_TYPE, TOKEN_TYPE_COUNT> operators{};
+    operators.fill(TOKEN_TYPE::EMPTY);
+    operators[static_cast<size_t>(TOKEN_TYPE::SUB)] = TOKEN_TYPE::SUB;
+    operators[static_cast<size_t>(TOKEN_TYPE::BANG)] = TOKEN_TYPE::BANG;
+    operators[static_cast<size_t>(TOKEN_TYPE::STAR)] = TOKEN_TYPE::DEREF;
+    operators[static_cast<size_t>(TOKEN_TYPE::AMP)] = TOKEN_TYPE::ADDRESSOF;
+    return operators;
+}();
+
+
+/*
+ * Where the token at it starts, the end of the input once it reaches end.
+ * Only token streams and cursors know where their tokens are, other token sequences have no locations.
+ */
+template<typename Iterator>
+std::optional<SourceLocation> location_of(const Iterator &it, const Iterator &end) {
+    if constexpr (std::is_same_v<Iterator, TokenStream::const_iterator>) {
+        const TokenStream &stream = *it.stream();
+        return it < end ? stream.location(it.index()) : stream.source()->location(stream.source()->size());
+    } else if constexpr (std::is_same_v<Iterator, TokenCursor::iterator>) {
+        const SourceBuffer &source = *it.cursor()->source();
+        return it < end ? source.location(it->m_lexeme.data() - source.data()) : source.location(source.size());
+    } else {
+        return std::nullopt;
+    }
+}
+
+// byte offset of the token at it, NO_SOURCE_OFFSET for the token sequences location_of can't locate
+template<typename Iterator>
+uint32_t source_offset(const Iterator &it) {
+    if constexpr (std::is_same_v<Iterator, TokenStream::const_iterator>) {
+        return it.stream()->offset(it.index());
+    } else if constexpr (std::is_same_v<Iterator, TokenCursor::iterator>) {
+        return it->m_lexeme.data() - it.cursor()->source()->data();
+    } else {
+        return NO_SOURCE_OFFSET;
+    }
+}
+
+template<typename Iterator>
+Diagnostic error_at(std::string message, const Iterator &it, const Iterator &end) {
+    return {std::move(message), location_of(it, end)};
+}
+
+/*
+ * Remembers a token to report an error at once the parser has moved far past it, like the opening of a
+ * scope. A TokenCursor's iterator stops working when its token leaves the window, so for those the
+ * token's byte offset is kept instead; the location itself is only worked out for an error.
+ */
+template<typename Iterator>
+class TokenMark {
+public:
+    TokenMark(const Iterator &it, const Iterator &end) : m_it(it), m_end(end) {}
+
+    std::optional<SourceLocation> location() const { return location_of(m_it, m_end); }
+
+private:
+    Iterator m_it;
+    Iterator m_end;
+};
+
+template<>
+class TokenMark<TokenCursor::iterator> {
+public:
+    TokenMark(const TokenCursor::iterator &it, const TokenCursor::iterator &end)
+            : m_source(it.cursor()->source().get()),
+              m_offset(it < end ? it->m_lexeme.data() - m_source->data() : m_source->size()) {}
+
+    std::optional<SourceLocation> location() const { return m_source->location(m_offset); }
+
+private:
+    const SourceBuffer *m_source;
+    size_t m_offset;
+};
+
+template<typename Iterator>
+Diagnostic error_at(std::string message, const TokenMark<Iterator> &mark) {
+    return {std::move(message), mark.location()};
+}
 
 
+/*
+ * The scope_suffix closing the first scope_prefix at or after begin.
+ * Over a TokenStream that's a lookup in its bracket table, anything else is scanned with a depth count.
+ */
 template<typename Iterator, typename T>
-Iterator get_scope_end(const Iterator &begin, const Iterator &end, const T &scope_prefix, const T &scope_suffix) {
-    std::stack<Token> stack;
-    for (auto it = begin; it < end; ++it) {
-        if (*it == scope_prefix) {
-            stack.push(*it);
-        } else if (*it == scope_suffix) {
-            stack.pop();
-            if (stack.empty()) {
+Result<Iterator> get_scope_end(const Iterator &begin, const Iterator &end, const T &scope_prefix, const T &scope_suffix) {
+    auto opening = begin;
+    while (opening < end && !(*opening == scope_prefix)) {
+        ++opening;
+    }
+    TokenMark<Iterator> opening_mark(opening, end); // the scan can take the opening out of a cursor's window
+    if constexpr (std::is_same_v<Iterator, TokenStream::const_iterator>) {
+        if (opening < end) {
+            uint32_t partner = opening.stream()->partner(opening.index());
+            if (partner != NO_PARTNER && partner < end.index()) {
+                return opening + (partner - opening.index());
+            }
+        }
+    } else {
+        size_t depth = 0;
+        for (auto it = opening; it < end; ++it) {
+            if (*it == scope_prefix) {
+                ++depth;
+            } else if (*it == scope_suffix && --depth == 0) {
                 return it;
             }
         }
     }
-    throw CompilerException(UNCLOSED_SCOPE);
+    return error_at(UNCLOSED_SCOPE, opening_mark);
 }
 
 
+/*
+ * Nodes returned by the parse_* functions are owned by the parser's arena
+ * and stay valid for as long as the parser does.
+ * A parse_* function that fails returns the diagnostic instead of a node, leaving it wherever the error was
+ * found. parse_statements reports those into diagnostics() and carries on with the next statement.
+ */
 class Parser {
 public:
+    Parser() = default;
 
-    template<typename Iterator>
-    std::unique_ptr<ASTNode> parse_func_call(Iterator &it, const Iterator &statement_end) {
-        auto func_node = std::make_unique<ASTNode>(Token(TOKEN_TYPE::FUNC_CALL, it->m_value),
-                                                   FuncCall({}));
+    // allocate nodes one by one from node_resource instead of bump allocating them
+    explicit Parser(std::pmr::memory_resource *node_resource) : m_arena(node_resource) {}
 
-        DEBUG_MSG("parsing function call: " << func_node->m_token.to_string() << "(");
-        it += 2; // skip function name and left parentheses
+    AstArena &arena() { return m_arena; }
 
-        bool is_arg = true; // used to enforce commas between arguments
+    // errors reported by parse_statements
+    const Diagnostics &diagnostics() const { return m_diagnostics; }
 
-        while (it->m_type != TOKEN_TYPE::RPARENS) {
-            if (it >= statement_end) {
-                throw CompilerException("unclosed function call");
-            }
-
-            if (it->m_type == TOKEN_TYPE::COMMA) {
-                ++it;
-                is_arg = true;
-                continue;
-            }
+    // type of the token k places after it, EMPTY past statement_end. No construct needs k > 2,
+    // so every parse_* function decides from a fixed window and never scans ahead or rescans
+    template<typename Iterator>
+    static TOKEN_TYPE peek(const Iterator &it, const Iterator &statement_end, size_t k) {
+        auto ahead = it + static_cast<std::ptrdiff_t>(k);
+        return ahead < statement_end ? ahead->m_type : TOKEN_TYPE::EMPTY;
+    }
 
-            if (!is_arg) {
-                throw CompilerException(NON_COMMA_SEPARATED_ARGS_ERROR);
-            }
+    static bool is_type(TOKEN_TYPE type) {
+        return type == TOKEN_TYPE::INT || type == TOKEN_TYPE::CHAR || type == TOKEN_TYPE::VOID;
+    }
 
-            // not parsing an expression because I don't expect assignments
-            auto argument = parse_arithmetic( it, statement_end);
-            DEBUG_MSG("parsed arg: " << argument->m_token.to_string());
+    // print and input are keywords, but they're declared and called like any other function
+    static bool is_function_name(TOKEN_TYPE type) {
+        return type == TOKEN_TYPE::IDENTIFIER || type == TOKEN_TYPE::PRINT || type == TOKEN_TYPE::INPUT;
+    }
 
-            std::get<FuncCall>(func_node->m_members).arg.push_back(std::move(argument));
-            is_arg = false;
+    // type keyword followed by any number of '*'
+    template<typename Iterator>
+    Result<TypeName> parse_type(Iterator &it, const Iterator &statement_end) {
+        TypeName type{*it++};
+        while (peek(it, statement_end, 0) == TOKEN_TYPE::STAR) {
+            if (type.pointer_depth == UINT8_MAX) {
+                return error_at(POINTER_DEPTH_LIMIT, it, statement_end);
+            }
+            ++type.pointer_depth;
+            ++it;
         }
-        ++it;
-        DEBUG_MSG(")");
-
-        return std::move(func_node);
+        return type;
     }
 
     template<typename Iterator>
-    std::unique_ptr<ASTNode> parse_func_declaration(Iterator &it, const Iterator &statement_end) {
-        Token return_type = *it++;
-        auto func_node = std::make_unique<ASTNode>(*it++);
+    Result<ASTNode *> parse_func_declaration(Iterator &it, const Iterator &statement_end, const TypeName &return_type) {
+        auto func_node = make_node(it, *it);
+        ++it;
 
-        DEBUG_MSG("parsing function declaration: " << return_type.to_string() << " " << func_node->m_token.to_string()
-                                                   << "(");
+        DEBUG_MSG("parsing function declaration: " << return_type.base.to_string() << " "
+                                                   << func_node->m_token.to_string() << "(");
 
-        func_node->m_members = FuncDeclaration({.return_type = return_type});
+        func_node->m_members = FuncDeclaration{return_type, m_arena.list()};
+        auto &params = std::get<FuncDeclaration>(func_node->m_members).params;
 
         bool is_arg = true; // used to enforce commas between arguments
 
-        if (it->m_type != TOKEN_TYPE::LPARENS) {
-            throw CompilerException(DANGLING_FUNC_DECLARATION);
+        if (it >= statement_end || it->m_type != TOKEN_TYPE::LPARENS) {
+            return error_at(DANGLING_FUNC_DECLARATION, it, statement_end);
         }
         ++it; // skip left parentheses
 
 
-        while (it->m_type != TOKEN_TYPE::RPARENS) {
+        while (it >= statement_end || it->m_type != TOKEN_TYPE::RPARENS) {
             if (it >= statement_end) {
-                throw CompilerException("unclosed function declaration");
+                return error_at(UNCLOSED_FUNC_DECLARATION, it, statement_end);
             }
 
             if (it->m_type == TOKEN_TYPE::COMMA) {
@@ -162,160 +253,728 @@ public:
             }
 
             if (!is_arg) {
-                throw CompilerException(NON_COMMA_SEPARATED_ARGS_ERROR);
+                return error_at(NON_COMMA_SEPARATED_ARGS_ERROR, it, statement_end);
             }
 
-            if (it->m_type == TOKEN_TYPE::INT || it->m_type == TOKEN_TYPE::CHAR) {
+            if (is_type(it->m_type)) {
                 DEBUG_MSG("parsing arg type: " << it->to_string());
-                std::get<FuncDeclaration>(func_node->m_members).args_types.push_back(*it++);
-                if (it->m_type == TOKEN_TYPE::IDENTIFIER) {
-                    ++it; // param name isn't interesting
+                uint32_t type_offset = source_offset(it);
+                auto type = parse_type(it, statement_end);
+                if (!type) {
+                    return type.error();
+                }
+                if (peek(it, statement_end, 0) == TOKEN_TYPE::IDENTIFIER) {
+                    params.push_back(make_node(it, *it, VariableDeclaration{*type}));
+                    ++it;
+                } else {
+                    // an unnamed parameter is located at its type
+                    params.push_back(m_arena.make(Token(TOKEN_TYPE::EMPTY, Symbol()), VariableDeclaration{*type}));
+                    params.back()->m_offset = type_offset;
                 }
                 is_arg = false;
             } else {
-                throw CompilerException(FUNC_DECLARATION_PARAM_MISSING_TYPE);
+                return error_at(FUNC_DECLARATION_PARAM_MISSING_TYPE, it, statement_end);
             }
         }
         ++it;
         DEBUG_MSG(")");
 
-        return std::move(func_node);
+        // f(void) takes no parameters
+        if (params.size() == 1 && params[0]->m_token.m_type == TOKEN_TYPE::EMPTY) {
+            const TypeName &type = std::get<VariableDeclaration>(params[0]->m_members).type;
+            if (type.base.m_type == TOKEN_TYPE::VOID && type.pointer_depth == 0) {
+                params.clear();
+            }
+        }
+
+        return func_node;
     }
 
     template<typename Iterator>
-    std::unique_ptr<ASTNode> parse_variable_declaration(Iterator &it, const Iterator &statement_end) {
-        Token type = *it++;
-        auto declaration_node = std::make_unique<ASTNode>(*it++);
-        declaration_node->m_members = VariableDeclaration({type});
+    Result<ASTNode *> parse_variable_declaration(Iterator &it, const Iterator &statement_end, const TypeName &type) {
+        if (peek(it, statement_end, 0) != TOKEN_TYPE::IDENTIFIER) {
+            return error_at(VARIABLE_DEFINITION_WITHOUT_NAME, it, statement_end);
+        }
+        auto declaration_node = make_node(it, *it, VariableDeclaration({type}));
+        ++it;
         DEBUG_MSG("parsing declaration: " << declaration_node->m_token.to_string()
-                                          << " of type " << type.to_string());
-        return std::move(declaration_node);
+                                          << " of type " << type.base.to_string());
+        return declaration_node;
     }
 
+    // { statements }, nested statements are parsed without recursion, see parse_statement
     template<typename Iterator>
-    std::unique_ptr<ASTNode> parse_block(Iterator &it, const Iterator &statement_end) {
-
+    Result<ASTNode *> parse_block(Iterator &it, const Iterator &statement_end) {
+        if (peek(it, statement_end, 0) != TOKEN_TYPE::LBRACE) {
+            return error_at(EXPECTED_BLOCK, it, statement_end);
+        }
+        return parse_statement(it, statement_end);
     }
 
+    /*
+     * Precedence climbing over explicit stacks of operators and operands instead of the call stack, so no amount
+     * of nesting overflows it. Operands bind to the operator with the higher BINARY_PRECEDENCE, equal precedences
+     * associate to the left. Prefix operators bind tighter than any binary operator and looser than indexing,
+     * assignment is the loosest and associates to the right: a = b = c is a = (b = c).
+     * Parentheses, index brackets and argument lists are kept open on a stack of their own and finish the operators
+     * inside them as they close. Arguments can't be assignments. The tree is built as the tokens go by.
+     */
     template<typename Iterator>
-    std::unique_ptr<ASTNode> parse_factor(Iterator &it, const Iterator &statement_end) {
-        switch (it->m_type) {
-            case TOKEN_TYPE::INTEGER:
-            case TOKEN_TYPE::CHARACTER:
-            case TOKEN_TYPE::STRING:
-                return std::make_unique<ASTNode>(*it++);
-            case TOKEN_TYPE::IDENTIFIER:
-                if (std::distance(it, statement_end) > 1 && (it + 1)->m_type == TOKEN_TYPE::LPARENS) {
-                    return parse_func_call(it, statement_end);
+    Result<ASTNode *> parse_expression(Iterator &it, const Iterator &statement_end) {
+        enum class BRACKET : uint8_t { PARENTHESES, INDEX, CALL };
+        struct OpenBracket {
+            BRACKET m_kind;
+            ASTNode *m_node;    // the index or call it makes
+            size_t m_operators; // pending from before it was opened
+        };
+        std::vector<OpenBracket> brackets;
+        std::vector<ASTNode *> operators; // waiting for their right operand
+        std::vector<ASTNode *> operands;
+
+        auto precedence = [](const ASTNode *node) -> uint8_t {
+            if (node_kind(*node) == NODE_KIND::UNARY_OPERATION) {
+                return UINT8_MAX;
+            }
+            return BINARY_PRECEDENCE[static_cast<size_t>(node->m_token.m_type)]; // 0 for an assignment
+        };
+        // finishes the operators of the innermost bracket binding at least as tightly as min_precedence
+        auto reduce = [&](uint8_t min_precedence) {
+            size_t floor = brackets.empty() ? 0 : brackets.back().m_operators;
+            while (operators.size() > floor && precedence(operators.back()) >= min_precedence) {
+                ASTNode *node = operators.back();
+                operators.pop_back();
+                ASTNode *rhs = operands.back();
+                operands.pop_back();
+                if (auto *unary = std::get_if<UnaryOperation>(&node->m_members)) {
+                    unary->operand = rhs;
                 } else {
-                    // variables
-                    DEBUG_MSG("parsing variable identifier: " << it->to_string());
-                    return std::make_unique<ASTNode>(*it++);
+                    node->m_members = BinaryOperation(operands.back(), rhs);
+                    operands.pop_back();
                 }
-            default:
-                throw CompilerException((std::string("unsupported factor token: ") + it->to_string()).c_str());
-        }
-    }
-
-    template<typename Iterator>
-    std::unique_ptr<ASTNode> parse_arithmetic(Iterator &it, const Iterator &statement_end) {
-        auto lhs = parse_factor(it, statement_end);
-
-        while (std::find(ARITHMETIC_TOKENS.begin(), ARITHMETIC_TOKENS.end(), it->m_type) != ARITHMETIC_TOKENS.end()) {
-            DEBUG_MSG("parsing arithmetic: " << it->to_string());
+                operands.push_back(node);
+            }
+        };
+
+        bool expecting_operand = true;
+        bool argument_start = false; // right after a call's '(' or a ',', where ',' and ')' are taken as they come
+        while (true) {
+            if (expecting_operand) {
+                if (argument_start) {
+                    if (it >= statement_end) {
+                        return error_at(UNCLOSED_FUNC_CALL, it, statement_end);
+                    }
+                    if (it->m_type == TOKEN_TYPE::COMMA) {
+                        ++it;
+                        continue;
+                    }
+                    argument_start = false;
+                    if (it->m_type == TOKEN_TYPE::RPARENS) {
+                        ++it;
+                        operands.push_back(brackets.back().m_node);
+                        brackets.pop_back();
+                        expecting_operand = false;
+                        continue;
+                    }
+                }
+                if (it >= statement_end) {
+                    return error_at(UNEXPECTED_END_OF_EXPRESSION, it, statement_end);
+                }
+                TOKEN_TYPE type = it->m_type;
+                if (UNARY_OPERATORS[static_cast<size_t>(type)] != TOKEN_TYPE::EMPTY) {
+                    Token operator_token = *it;
+                    operator_token.m_type = UNARY_OPERATORS[static_cast<size_t>(type)];
+                    DEBUG_MSG("parsing unary operator: " << operator_token.to_string());
+                    operators.push_back(make_node(it, operator_token, UnaryOperation{nullptr}));
+                    ++it;
+                    continue;
+                }
+                switch (type) {
+                    case TOKEN_TYPE::INTEGER:
+                    case TOKEN_TYPE::CHARACTER:
+                    case TOKEN_TYPE::STRING:
+                        operands.push_back(make_node(it, *it));
+                        ++it;
+                        expecting_operand = false;
+                        continue;
+                    case TOKEN_TYPE::IDENTIFIER:
+                    case TOKEN_TYPE::PRINT:
+                    case TOKEN_TYPE::INPUT:
+                        if (peek(it, statement_end, 1) == TOKEN_TYPE::LPARENS) {
+                            Token func_token = *it;
+                            func_token.m_type = TOKEN_TYPE::FUNC_CALL;
+                            DEBUG_MSG("parsing function call: " << func_token.to_string() << "(");
+                            auto func_node = make_node(it, func_token, FuncCall{m_arena.list()});
+                            brackets.push_back({BRACKET::CALL, func_node, operators.size()});
+                            it += 2; // skip function name and left parentheses
+                            argument_start = true;
+                            continue;
+                        }
+                        if (type == TOKEN_TYPE::IDENTIFIER) {
+                            DEBUG_MSG("parsing variable identifier: " << it->to_string());
+                            operands.push_back(make_node(it, *it));
+                            ++it;
+                            expecting_operand = false;
+                            continue;
+                        }
+                        break;
+                    case TOKEN_TYPE::LPARENS:
+                        brackets.push_back({BRACKET::PARENTHESES, nullptr, operators.size()});
+                        ++it;
+                        continue;
+                    default:
+                        break;
+                }
+                return error_at(std::string(UNSUPPORTED_FACTOR) + it->to_string(), it, statement_end);
+            }
 
-            auto arithmetic_node = std::make_unique<ASTNode>(*it++);
-            arithmetic_node->m_members = BinaryOperation(std::move(lhs), parse_factor(it, statement_end));
+            // after an operand: an index, an operator, or the end of a bracket or of the whole expression
+            TOKEN_TYPE type = peek(it, statement_end, 0);
+            if (type == TOKEN_TYPE::LBRACKET) {
+                DEBUG_MSG("parsing index");
+                brackets.push_back({BRACKET::INDEX, make_node(it, *it), operators.size()});
+                ++it;
+                expecting_operand = true;
+                continue;
+            }
+            uint8_t binary_precedence = BINARY_PRECEDENCE[static_cast<size_t>(type)];
+            bool in_call = !brackets.empty() && brackets.back().m_kind == BRACKET::CALL;
+            if (binary_precedence != 0 || (type == TOKEN_TYPE::ASSIGN && !in_call)) {
+                DEBUG_MSG("parsing operator: " << it->to_string());
+                reduce(type == TOKEN_TYPE::ASSIGN ? 1 : binary_precedence);
+                operators.push_back(make_node(it, *it));
+                ++it;
+                expecting_operand = true;
+                continue;
+            }
 
-            lhs = std::move(arithmetic_node);
+            reduce(0);
+            if (brackets.empty()) {
+                return operands.back();
+            }
+            OpenBracket &bracket = brackets.back();
+            switch (bracket.m_kind) {
+                case BRACKET::PARENTHESES:
+                    if (type != TOKEN_TYPE::RPARENS) {
+                        return error_at(UNCLOSED_PARENTHESES, it, statement_end);
+                    }
+                    break;
+                case BRACKET::INDEX: {
+                    if (type != TOKEN_TYPE::RBRACKET) {
+                        return error_at(UNCLOSED_INDEX, it, statement_end);
+                    }
+                    ASTNode *index = operands.back();
+                    operands.pop_back();
+                    bracket.m_node->m_members = BinaryOperation(operands.back(), index);
+                    operands.back() = bracket.m_node;
+                    break;
+                }
+                case BRACKET::CALL:
+                    if (type == TOKEN_TYPE::EMPTY) {
+                        return error_at(UNCLOSED_FUNC_CALL, it, statement_end);
+                    }
+                    if (type != TOKEN_TYPE::COMMA && type != TOKEN_TYPE::RPARENS) {
+                        return error_at(NON_COMMA_SEPARATED_ARGS_ERROR, it, statement_end);
+                    }
+                    std::get<FuncCall>(bracket.m_node->m_members).arg.push_back(operands.back());
+                    operands.pop_back();
+                    if (type == TOKEN_TYPE::COMMA) {
+                        ++it;
+                        expecting_operand = true;
+                        argument_start = true;
+                        continue;
+                    }
+                    operands.push_back(bracket.m_node);
+                    break;
+            }
+            ++it;
+            brackets.pop_back();
         }
-
-        return lhs;
     }
 
-    template<typename Iterator>
-    std::unique_ptr<ASTNode> parse_expression(Iterator &it, const Iterator &statement_end) {
-        auto lhs = parse_arithmetic(it, statement_end);
-
-        while (it->m_type == TOKEN_TYPE::ASSIGN) {
-            DEBUG_MSG("parsing expression " << it->to_string());
-
-            auto assign_node = std::make_unique<ASTNode>(*it++);
-
-            assign_node->m_members = BinaryOperation(std::move(lhs), parse_arithmetic(it, statement_end));
-
-            lhs = std::move(assign_node);
+    // only variables, indexed values and dereferenced pointers can be assigned to
+    static bool is_assignable(const ASTNode *assignment) {
+        const ASTNode *target = std::get<BinaryOperation>(assignment->m_members).lhs;
+        switch (target->m_token.m_type) {
+            case TOKEN_TYPE::IDENTIFIER:
+            case TOKEN_TYPE::LBRACKET:
+            case TOKEN_TYPE::DEREF:
+                return true;
+            default:
+                return false;
         }
-
-        return lhs;
     }
 
+    /*
+     * type name ;               variable declaration
+     * type name = expression ;  variable declaration with an initializer, an assignment to the declaration
+     * type name ( ... ) ;       function declaration
+     * After the type and its '*'s the token after the name decides, nothing further ahead is looked at.
+     */
     template<typename Iterator>
-    void validate_assignment(const Iterator &statement_start, const Iterator &it) {
-        const auto &assign_it = std::find(statement_start, it, Token(TOKEN_TYPE::ASSIGN, "="));
-        const auto lhs_length = std::distance(statement_start, assign_it);
-        if (lhs_length > 1) {
-            // definition
-            if (std::find(TYPES.begin(), TYPES.end(), statement_start->m_type) == TYPES.end()) {
-                throw CompilerException(VARIABLE_DEFINITION_WITHOUT_TYPE);
-            }
-            if ((assign_it - 1)->m_type != TOKEN_TYPE::IDENTIFIER) {
-                throw CompilerException(VARIABLE_DEFINITION_WITHOUT_NAME);
-            }
-        } else {
-            // assignment of existing variable
-            if (statement_start->m_type != TOKEN_TYPE::IDENTIFIER) {
-                throw CompilerException(BAD_ASSIGNMENT);
+    Result<ASTNode *> parse_declaration(Iterator &it, const Iterator &statement_end) {
+        auto type = parse_type(it, statement_end);
+        if (!type) {
+            return type.error();
+        }
+        TOKEN_TYPE name = peek(it, statement_end, 0);
+        TOKEN_TYPE after_name = peek(it, statement_end, 1);
+        if (name == TOKEN_TYPE::EMPTY) {
+            return error_at(UNEXPECTED_DANGLING_DECLARATION, it, statement_end);
+        }
+        if (name != TOKEN_TYPE::IDENTIFIER && !(is_function_name(name) && after_name == TOKEN_TYPE::LPARENS)) {
+            return error_at(BAD_DECLARATION, it, statement_end);
+        }
+        switch (after_name) {
+            case TOKEN_TYPE::LPARENS:
+                return parse_func_declaration(it, statement_end, *type);
+            case TOKEN_TYPE::ASSIGN: {
+                auto declaration_node = parse_variable_declaration(it, statement_end, *type);
+                if (!declaration_node) {
+                    return declaration_node;
+                }
+                auto assign_node = make_node(it, *it);
+                ++it;
+                auto initializer = parse_expression(it, statement_end);
+                if (!initializer) {
+                    return initializer;
+                }
+                assign_node->m_members = BinaryOperation(*declaration_node, *initializer);
+                return assign_node;
             }
+            default:
+                return parse_variable_declaration(it, statement_end, *type);
         }
-
     }
 
+    // ( expression ) after if and while
     template<typename Iterator>
-    std::unique_ptr<ASTNode> parse_declaration(Iterator &it, const Iterator &statement_end) {
-        if (std::distance(it, statement_end) < 1) {
-            throw CompilerException(UNEXPECTED_DANGLING_DECLARATION);
-        }
-        if ((it + 1)->m_type == TOKEN_TYPE::IDENTIFIER) {
-            if (std::find(it, statement_end, Token(TOKEN_TYPE::LPARENS, "(")) == statement_end) {
-                // might be variable declaration
-                return parse_variable_declaration(it, statement_end);
-            } else {
-                // function declaration
-                return parse_func_declaration(it, statement_end);
-            }
+    Result<ASTNode *> parse_condition(Iterator &it, const Iterator &statement_end) {
+        if (peek(it, statement_end, 0) != TOKEN_TYPE::LPARENS) {
+            return error_at(MISSING_CONDITION, it, statement_end);
+        }
+        ++it;
+        auto condition = parse_expression(it, statement_end);
+        if (!condition) {
+            return condition;
+        }
+        if (peek(it, statement_end, 0) != TOKEN_TYPE::RPARENS) {
+            return error_at(UNCLOSED_PARENTHESES, it, statement_end);
         }
-        throw CompilerException(BAD_DECLARATION);
+        ++it;
+        return condition;
     }
 
+    // a statement which can't hold other statements, up to and including its semicolon
     template<typename Iterator>
-    std::unique_ptr<ASTNode> parse_statement(Iterator &it, const Iterator &statement_end) {
-        std::unique_ptr<ASTNode> statement;
+    Result<ASTNode *> parse_simple_statement(Iterator &it, const Iterator &statement_end, bool in_loop) {
+        TokenMark<Iterator> statement_begin(it, statement_end);
+        Result<ASTNode *> statement = nullptr;
         DEBUG_MSG("parsing statement: " << it->to_string());
-        auto statement_start = it;
         switch (it->m_type) {
             case TOKEN_TYPE::INT:
             case TOKEN_TYPE::CHAR:
             case TOKEN_TYPE::VOID:
                 statement = parse_declaration( it, statement_end);
                 break;
+            case TOKEN_TYPE::RETURN: {
+                auto return_node = make_node(it, *it, ReturnStatement{});
+                ++it;
+                if (peek(it, statement_end, 0) != TOKEN_TYPE::SEMICOLON) {
+                    statement = parse_expression(it, statement_end);
+                    if (!statement) {
+                        break;
+                    }
+                    std::get<ReturnStatement>(return_node->m_members).value = *statement;
+                }
+                statement = return_node;
+                break;
+            }
+            case TOKEN_TYPE::BREAK:
+            case TOKEN_TYPE::CONTINUE:
+                if (!in_loop) {
+                    return error_at(JUMP_OUTSIDE_LOOP, it, statement_end);
+                }
+                statement = make_node(it, *it);
+                ++it;
+                break;
             default:
                 statement = parse_expression(it, statement_end);
+                if (!statement) {
+                    break;
+                }
                 switch (statement->m_token.m_type) {
                     case TOKEN_TYPE::ASSIGN:
-                        validate_assignment(statement_start, it);
+                        if (!is_assignable(*statement)) {
+                            return error_at(BAD_ASSIGNMENT, statement_begin);
+                        }
                     case TOKEN_TYPE::FUNC_CALL:
                         break;
                     default:
-                        throw CompilerException(UNEXPECTED_DANLGING_EXPRESSION);
+                        return error_at(UNEXPECTED_DANLGING_EXPRESSION, statement_begin);
                 }
         }
-        if (it->m_type != TOKEN_TYPE::SEMICOLON) {
-            throw CompilerException(NON_SEMICOLON_STATEMENT_SUFFIX);
+        if (!statement) {
+            return statement;
+        }
+        if (it >= statement_end || it->m_type != TOKEN_TYPE::SEMICOLON) {
+            return error_at(NON_SEMICOLON_STATEMENT_SUFFIX, it, statement_end);
         }
         ++it;
-        return std::move(statement);
+        return statement;
     }
-};
 
+    /*
+     * One statement, blocks, ifs and whiles included. Statements holding other statements are kept on
+     * an explicit stack instead of the call stack, so no amount of nesting overflows it.
+     * A statement failing inside a block is reported into diagnostics() and skipped, the block goes on.
+     * A failure outside of any block fails the whole statement.
+     */
+    template<typename Iterator>
+    Result<ASTNode *> parse_statement(Iterator &it, const Iterator &statement_end) {
+        // what the innermost unfinished statement waits for
+        enum class AWAITING : uint8_t { BLOCK_STATEMENT, THEN_BRANCH, ELSE_BRANCH, LOOP_BODY };
+        struct OpenStatement {
+            AWAITING m_awaiting;
+            ASTNode *m_node;
+            TokenMark<Iterator> m_begin;
+        };
+        std::vector<OpenStatement> open;
+        size_t open_loops = 0;
+
+        while (true) {
+            Result<ASTNode *> statement = nullptr;
+            if (it >= statement_end) {
+                bool in_block = !open.empty() && open.back().m_awaiting == AWAITING::BLOCK_STATEMENT;
+                return in_block ? error_at(UNCLOSED_SCOPE, open.back().m_begin)
+                                : error_at(MISSING_STATEMENT, it, statement_end);
+            }
+            switch (it->m_type) {
+                case TOKEN_TYPE::LBRACE:
+                    open.push_back({AWAITING::BLOCK_STATEMENT, make_node(it, *it, Block{m_arena.list()}), {it, statement_end}});
+                    ++it;
+                    continue;
+                case TOKEN_TYPE::RBRACE:
+                    if (!open.empty() && open.back().m_awaiting == AWAITING::BLOCK_STATEMENT) {
+                        ++it;
+                        statement = open.back().m_node;
+                        open.pop_back();
+                    } else {
+                        statement = error_at(std::string(UNSUPPORTED_FACTOR) + it->to_string(), it, statement_end);
+                    }
+                    break;
+                case TOKEN_TYPE::IF:
+                case TOKEN_TYPE::WHILE: {
+                    TokenMark<Iterator> begin(it, statement_end);
+                    bool is_if = it->m_type == TOKEN_TYPE::IF;
+                    auto keyword_node = is_if ? make_node(it, *it, IfStatement{nullptr, nullptr})
+                                              : make_node(it, *it, WhileLoop{nullptr});
+                    ++it;
+                    statement = parse_condition(it, statement_end);
+                    if (!statement) {
+                        break;
+                    }
+                    if (is_if) {
+                        std::get<IfStatement>(keyword_node->m_members).condition = *statement;
+                        open.push_back({AWAITING::THEN_BRANCH, keyword_node, begin});
+                    } else {
+                        std::get<WhileLoop>(keyword_node->m_members).condition = *statement;
+                        open.push_back({AWAITING::LOOP_BODY, keyword_node, begin});
+                        ++open_loops;
+                    }
+                    continue;
+                }
+                default:
+                    statement = parse_simple_statement(it, statement_end, open_loops > 0);
+            }
 
+            // a finished statement completes the ones waiting for it, innermost first
+            bool awaiting_more = false;
+            while (statement && !open.empty() && !awaiting_more) {
+                OpenStatement &parent = open.back();
+                switch (parent.m_awaiting) {
+                    case AWAITING::BLOCK_STATEMENT:
+                        std::get<Block>(parent.m_node->m_members).statements.push_back(*statement);
+                        awaiting_more = true;
+                        continue;
+                    case AWAITING::THEN_BRANCH:
+                        std::get<IfStatement>(parent.m_node->m_members).then_branch = *statement;
+                        if (peek(it, statement_end, 0) == TOKEN_TYPE::ELSE) {
+                            ++it;
+                            parent.m_awaiting = AWAITING::ELSE_BRANCH;
+                            awaiting_more = true;
+                            continue;
+                        }
+                        break;
+                    case AWAITING::ELSE_BRANCH:
+                        std::get<IfStatement>(parent.m_node->m_members).else_branch = *statement;
+                        break;
+                    case AWAITING::LOOP_BODY:
+                        std::get<WhileLoop>(parent.m_node->m_members).body = *statement;
+                        --open_loops;
+                        break;
+                }
+                statement = parent.m_node;
+                open.pop_back();
+            }
+            if (awaiting_more) {
+                continue;
+            }
+            if (statement) {
+                return statement;
+            }
+
+            // the error drops every statement it's nested in up to the closest block, which goes on after it
+            while (!open.empty() && open.back().m_awaiting != AWAITING::BLOCK_STATEMENT) {
+                open_loops -= open.back().m_awaiting == AWAITING::LOOP_BODY;
+                open.pop_back();
+            }
+            if (open.empty()) {
+                return statement;
+            }
+            m_diagnostics.report(statement.error());
+            synchronize(it, statement_end);
+        }
+    }
+
+    // a declaration ended by a semicolon, or a function definition
+    template<typename Iterator>
+    Result<ASTNode *> parse_external_declaration(Iterator &it, const Iterator &statement_end) {
+        return parse_external_declaration(it, statement_end, [this](Iterator &it, const Iterator &statement_end,
+                                                                    ASTNode *) {
+            return parse_block(it, statement_end);
+        });
+    }
+
+    /*
+     * Skips the rest of a statement which failed to parse: past the next ';', past a block it runs into,
+     * or up to a '}' which closes the enclosing block.
+     */
+    template<typename Iterator>
+    static void synchronize(Iterator &it, const Iterator &statement_end) {
+        while (it < statement_end) {
+            switch (it->m_type) {
+                case TOKEN_TYPE::SEMICOLON:
+                    ++it;
+                    return;
+                case TOKEN_TYPE::RBRACE:
+                    return;
+                case TOKEN_TYPE::LBRACE: {
+                    auto block_end = get_scope_end(it, statement_end, Token(TOKEN_TYPE::LBRACE, "{"),
+                                                   Token(TOKEN_TYPE::RBRACE, "}"));
+                    it = block_end ? *block_end + 1 : statement_end;
+                    return;
+                }
+                default:
+                    ++it;
+            }
+        }
+    }
+
+    /*
+     * Every statement in [it, statement_end). A statement which fails to parse is reported into diagnostics()
+     * and skipped, so one run finds all the errors, only the statements which parsed are returned.
+     */
+    template<typename Iterator>
+    NodeList parse_statements(Iterator &it, const Iterator &statement_end) {
+        return parse_recovering(it, statement_end, [this](Iterator &it, const Iterator &statement_end) {
+            return parse_statement(it, statement_end);
+        });
+    }
+
+    // the declarations and function definitions of a whole file, errors are handled like parse_statements does
+    template<typename Iterator>
+    NodeList parse_translation_unit(Iterator &it, const Iterator &end) {
+        return parse_recovering(it, end, [this](Iterator &it, const Iterator &end) {
+            return parse_external_declaration(it, end);
+        });
+    }
+
+    /*
+     * Same nodes and diagnostics as parse_translation_unit, but the declarations are only skimmed serially,
+     * each function body is jumped over through its brace partner and parsed later on the pool.
+     * A worker parses into its own parser so nodes are bump allocated without sharing an arena,
+     * those parsers live as long as this one. Bodies are attached and their diagnostics spliced in source
+     * order, so the result doesn't depend on scheduling. Unbalanced braces parse serially since partners
+     * can't be trusted to end the bodies there.
+     */
+    NodeList parse_translation_unit_parallel(const TokenStream &tokens, ThreadPool &pool = ThreadPool::shared()) {
+        if (tokens.first_unbalanced() != NO_PARTNER) {
+            auto it = tokens.begin();
+            return parse_translation_unit(it, tokens.end());
+        }
+
+        struct PendingBody {
+            ASTNode *m_declaration;
+            size_t m_diagnostics_before; // skim diagnostics preceding the body
+            Result<ASTNode *> m_body = nullptr;
+            size_t m_worker = 0;
+            size_t m_diagnostics_begin = 0; // body diagnostics, in its worker's parser
+            size_t m_diagnostics_end = 0;
+        };
+        std::vector<PendingBody> bodies;
+        size_t diagnostics_start = m_diagnostics.size();
+        NodeList declarations = skim_translation_unit(tokens, [&](ASTNode *declaration) {
+            bodies.push_back({declaration, m_diagnostics.size() - diagnostics_start});
+        });
+        if (bodies.empty()) {
+            return declarations;
+        }
+
+        while (m_body_parsers.size() < pool.thread_count()) {
+            m_body_parsers.push_back(std::make_unique<Parser>());
+        }
+        pool.parallel_for(bodies.size(), [&](size_t index, size_t worker) {
+            PendingBody &pending = bodies[index];
+            Parser &parser = *m_body_parsers[worker];
+            uint32_t lbrace = std::get<FuncDeclaration>(pending.m_declaration->m_members).deferred_body;
+            auto body_it = tokens.begin() + static_cast<std::ptrdiff_t>(lbrace);
+            pending.m_worker = worker;
+            pending.m_diagnostics_begin = parser.m_diagnostics.size();
+            pending.m_body = parser.parse_block(body_it, tokens.end());
+            pending.m_diagnostics_end = parser.m_diagnostics.size();
+            if (pending.m_body && body_it.index() != tokens.partner(lbrace) + 1) {
+                pending.m_body = error_at(UNCLOSED_SCOPE, body_it, tokens.end());
+            }
+        });
+
+        Diagnostics skim_diagnostics;
+        for (size_t index = diagnostics_start; index < m_diagnostics.size(); ++index) {
+            skim_diagnostics.report(m_diagnostics[index]);
+        }
+        m_diagnostics.truncate(diagnostics_start);
+        size_t next_skim_diagnostic = 0;
+        for (PendingBody &pending: bodies) {
+            if (!pending.m_body) {
+                // can't happen with balanced braces, but if a body didn't end at its partner the skim went wrong
+                m_diagnostics.truncate(diagnostics_start);
+                auto it = tokens.begin();
+                return parse_translation_unit(it, tokens.end());
+            }
+            for (; next_skim_diagnostic < pending.m_diagnostics_before; ++next_skim_diagnostic) {
+                m_diagnostics.report(skim_diagnostics[next_skim_diagnostic]);
+            }
+            const Diagnostics &body_diagnostics = m_body_parsers[pending.m_worker]->m_diagnostics;
+            for (size_t index = pending.m_diagnostics_begin; index < pending.m_diagnostics_end; ++index) {
+                m_diagnostics.report(body_diagnostics[index]);
+            }
+            auto &function = std::get<FuncDeclaration>(pending.m_declaration->m_members);
+            function.body = *pending.m_body;
+            function.deferred_body = NO_DEFERRED_BODY;
+        }
+        for (; next_skim_diagnostic < skim_diagnostics.size(); ++next_skim_diagnostic) {
+            m_diagnostics.report(skim_diagnostics[next_skim_diagnostic]);
+        }
+        return declarations;
+    }
+
+    /*
+     * Declarations only: function bodies are skipped through their brace partners and parsed by
+     * function_body on first use, so a run which only needs signatures costs time in the number of declarations
+     * rather than the size of the code. The parser keeps a pointer to tokens, which must outlive the deferred
+     * bodies. Unbalanced braces parse everything up front since partners can't be trusted to end the bodies.
+     */
+    NodeList parse_translation_unit_lazy(const TokenStream &tokens) {
+        if (tokens.first_unbalanced() != NO_PARTNER) {
+            auto it = tokens.begin();
+            return parse_translation_unit(it, tokens.end());
+        }
+        m_lazy_tokens = &tokens;
+        return skim_translation_unit(tokens, [](ASTNode *) {});
+    }
+
+    /*
+     * Body of a function declaration, null for a prototype. A body deferred by parse_translation_unit_lazy is
+     * parsed on the first call and kept in the node, its errors are reported into diagnostics() then,
+     * and one which fails to parse stays null. Not safe to call from several threads at once.
+     */
+    ASTNode *function_body(ASTNode &declaration) {
+        auto &function = std::get<FuncDeclaration>(declaration.m_members);
+        if (function.deferred_body != NO_DEFERRED_BODY) {
+            auto it = m_lazy_tokens->begin() + static_cast<std::ptrdiff_t>(function.deferred_body);
+            function.deferred_body = NO_DEFERRED_BODY;
+            auto body = parse_block(it, m_lazy_tokens->end());
+            if (body) {
+                function.body = *body;
+            } else {
+                m_diagnostics.report(body.error());
+            }
+        }
+        return function.body;
+    }
+
+private:
+    // node for token, located at the token at it. Made before the parser moves on, a cursor forgets passed tokens
+    template<typename Iterator, typename... Members>
+    ASTNode *make_node(const Iterator &at, const Token &token, Members &&... members) {
+        ASTNode *node = m_arena.make(token, std::forward<Members>(members)...);
+        node->m_offset = source_offset(at);
+        return node;
+    }
+
+    /*
+     * parse_translation_unit with every function body jumped over through its brace partner instead of parsed.
+     * The declaration keeps the index of the body's '{' in deferred_body and is handed to on_deferred.
+     */
+    template<typename OnDeferred>
+    NodeList skim_translation_unit(const TokenStream &tokens, OnDeferred on_deferred) {
+        using Iterator = TokenStream::const_iterator;
+        auto it = tokens.begin();
+        return parse_recovering(it, tokens.end(), [&](Iterator &it, const Iterator &end) {
+            return parse_external_declaration(it, end, [&](Iterator &it, const Iterator &, ASTNode *declaration) {
+                std::get<FuncDeclaration>(declaration->m_members).deferred_body = it.index();
+                on_deferred(declaration);
+                it = tokens.begin() + static_cast<std::ptrdiff_t>(tokens.partner(it.index()) + 1);
+                return Result<ASTNode *>(nullptr);
+            });
+        });
+    }
+
+    // parse_body parses or defers the body of a function definition, given the declaration it belongs to
+    template<typename Iterator, typename ParseBody>
+    Result<ASTNode *> parse_external_declaration(Iterator &it, const Iterator &statement_end, ParseBody parse_body) {
+        if (!is_type(it->m_type)) {
+            return error_at(EXPECTED_DECLARATION, it, statement_end);
+        }
+        auto declaration = parse_declaration(it, statement_end);
+        if (!declaration) {
+            return declaration;
+        }
+        if (node_kind(**declaration) == NODE_KIND::FUNC_DECLARATION && peek(it, statement_end, 0) == TOKEN_TYPE::LBRACE) {
+            auto body = parse_body(it, statement_end, *declaration);
+            if (!body) {
+                return body;
+            }
+            std::get<FuncDeclaration>(declaration->m_members).body = *body;
+            return declaration;
+        }
+        if (peek(it, statement_end, 0) != TOKEN_TYPE::SEMICOLON) {
+            return error_at(NON_SEMICOLON_STATEMENT_SUFFIX, it, statement_end);
+        }
+        ++it;
+        return declaration;
+    }
+
+    template<typename Iterator, typename ParseOne>
+    NodeList parse_recovering(Iterator &it, const Iterator &end, ParseOne parse_one) {
+        NodeList parsed = m_arena.list();
+        while (it < end) {
+            auto begin = it;
+            auto node = parse_one(it, end);
+            if (node) {
+                parsed.push_back(*node);
+                continue;
+            }
+            m_diagnostics.report(node.error());
+            synchronize(it, end);
+            if (it == begin) {
+                ++it; // a stray '}', nothing else fails without consuming a token
+            }
+        }
+        return parsed;
+    }
+
+    AstArena m_arena;
+    Diagnostics m_diagnostics;
+    const TokenStream *m_lazy_tokens = nullptr; // of the deferred bodies
+    std::vector<std::unique_ptr<Parser>> m_body_parsers; // one per pool thread, see parse_translation_unit_parallel
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+/*
+ * Collision free lookup table over a fixed set of spellings, built entirely at compile time.
+ * The constructor searches for a seed under which every key lands in its own slot,
+ * so a lookup is one hash, one slot and one compare.
+ */
+template<typename Value, size_t TableSize>
+class PerfectHashTable {
+    static_assert((TableSize & (TableSize - 1)) == 0, "table size must be a power of two");
+
+public:
+    template<size_t N>
+    consteval PerfectHashTable(const std::array<std::pair<std::string_view, Value>, N> &entries, Value missing)
+            : m_missing(missing) {
+        static_assert(N <= TableSize, "more entries than slots");
+
+        for (uint32_t seed = 1;; ++seed) {
+            std::array<bool, TableSize> taken{};
+            bool collision = false;
+            for (const auto &[key, value]: entries) {
+                size_t slot = hash(key, seed) & (TableSize - 1);
+                if (taken[slot]) {
+                    collision = true;
+                    break;
+                }
+                taken[slot] = true;
+            }
+            if (!collision) {
+                m_seed = seed;
+                break;
+            }
+        }
+
+        for (auto &slot: m_slots) {
+            slot = {std::string_view(), missing};
+        }
+        for (const auto &entry: entries) {
+            m_slots[hash(entry.first, m_seed) & (TableSize - 1)] = entry;
+        }
+    }
+
+    constexpr Value find(std::string_view key) const {
+        const auto &[slot_key, slot_value] = m_slots[hash(key, m_seed) & (TableSize - 1)];
+        return slot_key == key ? slot_value : m_missing;
+    }
+
+private:
+    static constexpr uint32_t hash(std::string_view key, uint32_t seed) {
+        // FNV-1a with the seed folded into the offset basis
+        uint32_t value = 2166136261u ^ (seed * 0x9e3779b9u);
+        for (char c: key) {
+            value = (value ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        return value ^ (value >> 15);
+    }
+
+    std::array<std::pair<std::string_view, Value>, TableSize> m_slots{};
+    uint32_t m_seed = 0;
+    Value m_missing;
+};
+
+// direct 256 entry table for single character spellings
+template<typename Value, size_t N>
+consteval std::array<Value, 256>
+make_char_table(const std::array<std::pair<std::string_view, Value>, N> &entries, Value missing) {
+    std::array<Value, 256> table{};
+    for (auto &slot: table) {
+        slot = missing;
+    }
+    for (const auto &[key, value]: entries) {
+        table[static_cast<unsigned char>(key[0])] = value;
+    }
+    return table;
+}
@@ -0,0 +1,120 @@
+#include "simd_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_SCAN_X86
+#endif
+
+namespace {
+
+    const char *skip_scalar(const char *begin, const char *end, const ByteSet &set) {
+        while (begin < end && set.m_members[static_cast<unsigned char>(*begin)]) {
+            ++begin;
+        }
+        return begin;
+    }
+
+#ifdef SIMD_SCAN_X86
+
+    __attribute__((target("sse4.2")))
+    const char *skip_sse42(const char *begin, const char *end, const ByteSet &set) {
+        const __m128i low_table = _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.m_low_nibbles.data()));
+        const __m128i high_table = _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.m_high_nibbles.data()));
+        const __m128i nibble_mask = _mm_set1_epi8(0x0f);
+        const __m128i zero = _mm_setzero_si128();
+        const uint32_t non_ascii_misses = set.m_non_ascii_members ? 0 : 0xffff;
+
+        while (end - begin >= 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+            __m128i low = _mm_shuffle_epi8(low_table, _mm_and_si128(bytes, nibble_mask));
+            __m128i high = _mm_shuffle_epi8(high_table, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble_mask));
+            auto ascii_misses = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(low, high), zero)));
+            auto non_ascii = static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+            uint32_t misses = (ascii_misses & ~non_ascii) | (non_ascii & non_ascii_misses);
+            if (misses != 0) {
+                return begin + __builtin_ctz(misses);
+            }
+            begin += 16;
+        }
+        return skip_scalar(begin, end, set);
+    }
+
+    __attribute__((target("avx2")))
+    const char *skip_avx2(const char *begin, const char *end, const ByteSet &set) {
+        const __m256i low_table = _mm256_broadcastsi128_si256(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.m_low_nibbles.data())));
+        const __m256i high_table = _mm256_broadcastsi128_si256(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.m_high_nibbles.data())));
+        const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+        const __m256i zero = _mm256_setzero_si256();
+        const uint32_t non_ascii_misses = set.m_non_ascii_members ? 0 : 0xffffffff;
+
+        while (end - begin >= 32) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+            __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(bytes, nibble_mask));
+            __m256i high = _mm256_shuffle_epi8(high_table,
+                                               _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble_mask));
+            auto ascii_misses = static_cast<uint32_t>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(low, high), zero)));
+            auto non_ascii = static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+            uint32_t misses = (ascii_misses & ~non_ascii) | (non_ascii & non_ascii_misses);
+            if (misses != 0) {
+                return begin + __builtin_ctz(misses);
+            }
+            begin += 32;
+        }
+        return skip_sse42(begin, end, set);
+    }
+
+#endif
+
+    SkipFunction skip_function_for(SIMD_LEVEL level) {
+        switch (level) {
+#ifdef SIMD_SCAN_X86
+            case SIMD_LEVEL::AVX2:
+                return skip_avx2;
+            case SIMD_LEVEL::SSE42:
+                return skip_sse42;
+#endif
+            default:
+                return skip_scalar;
+        }
+    }
+
+    SIMD_LEVEL current_level = best_simd_level();
+}
+
+SkipFunction skip_byte_set_function = skip_function_for(current_level);
+
+SIMD_LEVEL best_simd_level() {
+#ifdef SIMD_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SIMD_LEVEL::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return SIMD_LEVEL::SSE42;
+    }
+#endif
+    return SIMD_LEVEL::SCALAR;
+}
+
+SIMD_LEVEL simd_level() {
+    return current_level;
+}
+
+void set_simd_level(SIMD_LEVEL level) {
+    current_level = level > best_simd_level() ? best_simd_level() : level;
+    skip_byte_set_function = skip_function_for(current_level);
+}
+
+const char *simd_level_name(SIMD_LEVEL level) {
+    switch (level) {
+        case SIMD_LEVEL::AVX2:
+            return "avx2";
+        case SIMD_LEVEL::SSE42:
+            return "sse4.2";
+        default:
+            return "scalar";
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/*
+ * Vectorized "skip while the byte belongs to a set" kernels used by the lexer for identifier bodies,
+ * digits, whitespace, comments and string bodies.
+ * Sets are classified 16 (SSE4.2) or 32 (AVX2) bytes at a time with the nibble lookup technique:
+ * a byte is a member when low_nibbles[byte & 0xf] & high_nibbles[byte >> 4] is non zero.
+ * The implementation is picked once at startup from what the CPU supports.
+ */
+
+enum class SIMD_LEVEL {
+    SCALAR,
+    SSE42,
+    AVX2,
+};
+
+struct ByteSet {
+    std::array<bool, 256> m_members{};
+    std::array<uint8_t, 16> m_low_nibbles{};
+    std::array<uint8_t, 16> m_high_nibbles{};
+    bool m_non_ascii_members = false; // bytes >= 0x80 are either all members or none
+};
+
+consteval ByteSet make_byte_set(const std::array<bool, 256> &members) {
+    ByteSet set;
+    set.m_members = members;
+    set.m_non_ascii_members = members[0x80];
+    for (int c = 0; c < 256; ++c) {
+        if (c >= 0x80) {
+            if (members[c] != set.m_non_ascii_members) {
+                throw "byte sets must treat all non ascii bytes alike";
+            }
+            continue;
+        }
+        if (members[c]) {
+            set.m_low_nibbles[c & 0xf] |= 1 << (c >> 4);
+        }
+    }
+    for (int high = 0; high < 8; ++high) {
+        set.m_high_nibbles[high] = 1 << high;
+    }
+    return set;
+}
+
+// builds a set from a predicate on bytes
+template<typename Predicate>
+consteval ByteSet make_byte_set(Predicate is_member) {
+    std::array<bool, 256> members{};
+    for (int c = 0; c < 256; ++c) {
+        members[c] = is_member(static_cast<unsigned char>(c));
+    }
+    return make_byte_set(members);
+}
+
+constexpr ByteSet IDENTIFIER_BYTES = make_byte_set([](unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+});
+constexpr ByteSet DIGIT_BYTES = make_byte_set([](unsigned char c) { return c >= '0' && c <= '9'; });
+constexpr ByteSet NON_NEWLINE_BYTES = make_byte_set([](unsigned char c) { return c != '\n'; });
+
+// first byte in [begin, end) which isn't in the set, end if there's none
+using SkipFunction = const char *(*)(const char *begin, const char *end, const ByteSet &set);
+
+extern SkipFunction skip_byte_set_function;
+
+inline const char *skip_byte_set(const char *begin, const char *end, const ByteSet &set) {
+    return skip_byte_set_function(begin, end, set);
+}
+
+SIMD_LEVEL best_simd_level();
+
+SIMD_LEVEL simd_level();
+
+// lets tests and benchmarks compare implementations, levels the CPU lacks fall back to the best one available
+void set_simd_level(SIMD_LEVEL level);
+
+const char *simd_level_name(SIMD_LEVEL level);
@@ -0,0 +1,110 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include "source_buffer.h"
+#include "exceptions.h"
+#include "macros.h"
+#include "simd_scan.h"
+
+namespace {
+
+    std::string read_descriptor(int fd) {
+        std::string content;
+        char chunk[1 << 16];
+        while (true) {
+            ssize_t bytes_read = ::read(fd, chunk, sizeof(chunk));
+            if (bytes_read == 0) {
+                break;
+            }
+            if (bytes_read < 0) {
+                ::close(fd);
+                throw CompilerException(SOURCE_READ_ERROR);
+            }
+            content.append(chunk, bytes_read);
+        }
+        return content;
+    }
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::from_file(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw CompilerException(SOURCE_OPEN_ERROR);
+    }
+
+    struct stat file_stat{};
+    if (::fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0) {
+        void *mapping = ::mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            ::close(fd);
+            ::madvise(mapping, file_stat.st_size, MADV_SEQUENTIAL);
+
+            std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+            buffer->m_data = static_cast<const char *>(mapping);
+            buffer->m_size = file_stat.st_size;
+            buffer->m_mapped_size = file_stat.st_size;
+            DEBUG_MSG("mapped " << path << " (" << buffer->m_size << " bytes)");
+            return buffer;
+        }
+    }
+
+    // pipes, character devices, empty or unmappable files
+    DEBUG_MSG("reading " << path << " into memory");
+    std::string content = read_descriptor(fd);
+    ::close(fd);
+    return from_string(std::move(content));
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::from_stream(std::istream &stream) {
+    return from_string(std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()));
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::from_string(std::string content) {
+    std::shared_ptr<SourceBuffer> buffer(new SourceBuffer());
+    buffer->m_owned = std::move(content);
+    buffer->m_data = buffer->m_owned.data();
+    buffer->m_size = buffer->m_owned.size();
+    return buffer;
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::edited(const TextEdit &edit) const {
+    if (edit.m_offset + edit.m_removed_length > m_size) {
+        throw CompilerException(EDIT_OUT_OF_RANGE);
+    }
+    std::string content;
+    content.reserve(m_size - edit.m_removed_length + edit.m_inserted.size());
+    content.append(m_data, edit.m_offset);
+    content.append(edit.m_inserted);
+    content.append(m_data + edit.m_offset + edit.m_removed_length, m_size - edit.m_offset - edit.m_removed_length);
+    return from_string(std::move(content));
+}
+
+SourceBuffer::~SourceBuffer() {
+    if (m_mapped_size != 0) {
+        ::munmap(const_cast<char *>(m_data), m_mapped_size);
+    }
+}
+
+const std::vector<uint32_t> &SourceBuffer::line_starts() const {
+    std::call_once(m_line_starts_built, [this] {
+        m_line_starts.push_back(0);
+        const char *end = m_data + m_size;
+        for (const char *newline = skip_byte_set(m_data, end, NON_NEWLINE_BYTES);
+             newline < end; newline = skip_byte_set(newline + 1, end, NON_NEWLINE_BYTES)) {
+            m_line_starts.push_back(newline + 1 - m_data);
+        }
+        DEBUG_MSG("built line table of " << m_line_starts.size() << " lines");
+    });
+    return m_line_starts;
+}
+
+SourceLocation SourceBuffer::location(size_t offset) const {
+    const auto &starts = line_starts();
+    auto line = std::upper_bound(starts.begin(), starts.end(), offset) - 1;
+    return {static_cast<uint32_t>(line - starts.begin() + 1), static_cast<uint32_t>(offset - *line + 1)};
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "source_location.h"
+
+constexpr const char *SOURCE_OPEN_ERROR = "could not open source file";
+constexpr const char *SOURCE_READ_ERROR = "could not read source file";
+constexpr const char *EDIT_OUT_OF_RANGE = "edit reaches past the end of the source";
+
+// replace removed_length bytes at offset with inserted
+struct TextEdit {
+    size_t m_offset;
+    size_t m_removed_length;
+    std::string m_inserted;
+};
+
+/*
+ * Owns the bytes of a whole translation unit.
+ * Regular files are mmapped read-only, anything else (pipes, ttys, streams) is read into memory once.
+ * The buffer is shared so that tokens referencing it can outlive the lexer that produced them.
+ * Tokens only keep byte offsets, line and column are resolved from a table of line starts
+ * which is built the first time a location is asked for.
+ */
+class SourceBuffer {
+public:
+    static std::shared_ptr<const SourceBuffer> from_file(const std::string &path);
+
+    static std::shared_ptr<const SourceBuffer> from_stream(std::istream &stream);
+
+    static std::shared_ptr<const SourceBuffer> from_string(std::string content);
+
+    // a new in-memory buffer holding this one's bytes with the edit applied
+    std::shared_ptr<const SourceBuffer> edited(const TextEdit &edit) const;
+
+    SourceBuffer(const SourceBuffer &) = delete;
+
+    SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+    ~SourceBuffer();
+
+    const char *data() const { return m_data; }
+
+    size_t size() const { return m_size; }
+
+    std::string_view view() const { return {m_data, m_size}; }
+
+    // offsets at which every line starts, the first one is 0
+    const std::vector<uint32_t> &line_starts() const;
+
+    // binary search in the line table, offset may be size() for the end of the buffer
+    SourceLocation location(size_t offset) const;
+
+private:
+    SourceBuffer() = default;
+
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_mapped_size = 0; // non zero when m_data is an mmapped region
+    std::string m_owned;
+    mutable std::once_flag m_line_starts_built;
+    mutable std::vector<uint32_t> m_line_starts;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+// 1 based line and column (in bytes) of a position in a source buffer
+struct SourceLocation {
+    uint32_t m_line;
+    uint32_t m_column;
+
+    bool operator==(const SourceLocation &other) const = default;
+};
@@ -0,0 +1,78 @@
+#include "symbol_table.h"
+
+namespace {
+    constexpr size_t INITIAL_SLOTS = 64;
+}
+
+SymbolTable::SymbolTable() : m_slots(INITIAL_SLOTS) {}
+
+void SymbolTable::leave_scope() {
+    size_t start = m_scope_starts.back();
+    m_scope_starts.pop_back();
+    while (m_undo.size() > start) {
+        slot(m_undo.back().m_name).m_binding = m_undo.back().m_previous;
+        m_undo.pop_back();
+    }
+}
+
+const ASTNode *SymbolTable::declare(uint32_t name, const ASTNode *declaration) {
+    Slot &declared = slot(name);
+    if (declared.m_binding.m_declaration && declared.m_binding.m_depth == depth()) {
+        return declared.m_binding.m_declaration;
+    }
+    if (depth() > 0) {
+        m_undo.push_back({name, declared.m_binding});
+    }
+    declared.m_binding = {declaration, depth()};
+    return nullptr;
+}
+
+void SymbolTable::replace(uint32_t name, const ASTNode *declaration) {
+    slot(name).m_binding.m_declaration = declaration;
+}
+
+const ASTNode *SymbolTable::lookup(uint32_t name) const {
+    const Slot *found = find(name);
+    return found ? found->m_binding.m_declaration : nullptr;
+}
+
+SymbolTable::Slot &SymbolTable::slot(uint32_t name) {
+    // at most half full, probe sequences stay short
+    if ((m_used + 1) * 2 > m_slots.size()) {
+        grow();
+    }
+    size_t index = home(name);
+    while (m_slots[index].m_name != name && m_slots[index].m_name != EMPTY_NAME) {
+        index = (index + 1) & (m_slots.size() - 1);
+    }
+    if (m_slots[index].m_name == EMPTY_NAME) {
+        m_slots[index].m_name = name;
+        ++m_used;
+    }
+    return m_slots[index];
+}
+
+const SymbolTable::Slot *SymbolTable::find(uint32_t name) const {
+    size_t index = home(name);
+    while (m_slots[index].m_name != EMPTY_NAME) {
+        if (m_slots[index].m_name == name) {
+            return &m_slots[index];
+        }
+        index = (index + 1) & (m_slots.size() - 1);
+    }
+    return nullptr;
+}
+
+void SymbolTable::grow() {
+    std::vector<Slot> old_slots(m_slots.size() * 2);
+    old_slots.swap(m_slots);
+    for (const Slot &old_slot: old_slots) {
+        if (old_slot.m_name != EMPTY_NAME) {
+            size_t index = home(old_slot.m_name);
+            while (m_slots[index].m_name != EMPTY_NAME) {
+                index = (index + 1) & (m_slots.size() - 1);
+            }
+            m_slots[index] = old_slot;
+        }
+    }
+}
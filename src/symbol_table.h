@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ast.h"
+
+/*
+ * Declarations visible at a point of a scoped walk, keyed by interned identifier.
+ * A single flat open addressed table holds the innermost binding of every name, shadowed bindings live in
+ * an undo log instead of per scope tables: declaring logs what the slot held before, leaving a scope
+ * replays the log back to where the scope started. Lookups are one probe sequence however deep the scopes
+ * nest, and a scope that declares nothing costs one push and one pop.
+ */
+class SymbolTable {
+public:
+    SymbolTable();
+
+    void enter_scope() { m_scope_starts.push_back(m_undo.size()); }
+
+    void leave_scope();
+
+    // scopes entered and not left, 0 is the outermost (file) scope
+    size_t depth() const { return m_scope_starts.size(); }
+
+    // binds name in the innermost scope, unless it's declared there already: then nothing changes and
+    // the earlier declaration is returned
+    const ASTNode *declare(uint32_t name, const ASTNode *declaration);
+
+    // points name's binding in the innermost scope, which must exist, at another declaration
+    void replace(uint32_t name, const ASTNode *declaration);
+
+    // innermost visible declaration of name, null when there's none
+    const ASTNode *lookup(uint32_t name) const;
+
+private:
+    static constexpr uint32_t EMPTY_NAME = UINT32_MAX;
+
+    struct Binding {
+        const ASTNode *m_declaration = nullptr; // null once the scope declaring it was left
+        size_t m_depth = 0;
+    };
+
+    struct Slot {
+        uint32_t m_name = EMPTY_NAME;
+        Binding m_binding;
+    };
+
+    struct Undo {
+        uint32_t m_name;
+        Binding m_previous;
+    };
+
+    // the name's slot, claiming an empty one for it when it has none yet
+    Slot &slot(uint32_t name);
+
+    const Slot *find(uint32_t name) const;
+
+    size_t home(uint32_t name) const {
+        return static_cast<size_t>((name * 0x9E3779B97F4A7C15ull) >> 32) & (m_slots.size() - 1);
+    }
+
+    void grow();
+
+    // names keep their slot once they have one, slots never need deleting
+    std::vector<Slot> m_slots;
+    size_t m_used = 0;
+    std::vector<Undo> m_undo;
+    std::vector<size_t> m_scope_starts;
+};
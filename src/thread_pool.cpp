@@ -0,0 +1,158 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace {
+
+    uint64_t pack_range(uint32_t begin, uint32_t end) {
+        return static_cast<uint64_t>(begin) << 32 | end;
+    }
+
+    uint32_t range_begin(uint64_t range) {
+        return static_cast<uint32_t>(range >> 32);
+    }
+
+    uint32_t range_end(uint64_t range) {
+        return static_cast<uint32_t>(range);
+    }
+}
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    thread_count = std::max<size_t>(thread_count, 1);
+    m_slices = std::make_unique<TaskSlice[]>(thread_count);
+    for (size_t worker = 1; worker < thread_count; ++worker) {
+        m_workers.emplace_back(&ThreadPool::work, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto &worker: m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(size_t task_count, const std::function<void(size_t)> &task) {
+    parallel_for(task_count, [&task](size_t index, size_t) { task(index); });
+}
+
+void ThreadPool::parallel_for(size_t task_count, const std::function<void(size_t, size_t)> &task) {
+    std::lock_guard run_lock(m_run_mutex);
+    // slices hold 32 bit indices, bigger counts run as consecutive rounds
+    constexpr size_t max_round = std::numeric_limits<uint32_t>::max();
+    for (size_t first = 0; first < task_count; first += max_round) {
+        size_t round = std::min(task_count - first, max_round);
+        {
+            std::lock_guard lock(m_mutex);
+            for (size_t worker = 0; worker < thread_count(); ++worker) {
+                m_slices[worker].m_range = pack_range(round * worker / thread_count(),
+                                                      round * (worker + 1) / thread_count());
+            }
+            m_task = &task;
+            m_first_task = first;
+            m_busy_workers = m_workers.size();
+            m_error = nullptr;
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        run_tasks(0);
+
+        std::unique_lock lock(m_mutex);
+        m_done.wait(lock, [this] { return m_busy_workers == 0; });
+        m_task = nullptr;
+        if (m_error) {
+            std::rethrow_exception(std::exchange(m_error, nullptr));
+        }
+    }
+}
+
+ThreadPool &ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::work(size_t worker) {
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stopping || m_generation != seen_generation; });
+            if (m_stopping) {
+                return;
+            }
+            seen_generation = m_generation;
+        }
+
+        run_tasks(worker);
+
+        std::lock_guard lock(m_mutex);
+        if (--m_busy_workers == 0) {
+            m_done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::run_tasks(size_t worker) {
+    size_t index;
+    while (take_own(worker, index) || (steal(worker) && take_own(worker, index))) {
+        try {
+            (*m_task)(m_first_task + index, worker);
+        }
+        catch (...) {
+            std::lock_guard lock(m_mutex);
+            if (!m_error) {
+                m_error = std::current_exception();
+            }
+        }
+    }
+}
+
+bool ThreadPool::take_own(size_t worker, size_t &index) {
+    auto &range = m_slices[worker].m_range;
+    uint64_t current = range.load(std::memory_order_acquire);
+    while (range_begin(current) < range_end(current)) {
+        if (range.compare_exchange_weak(current, pack_range(range_begin(current) + 1, range_end(current)),
+                                        std::memory_order_acq_rel)) {
+            index = range_begin(current);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::steal(size_t worker) {
+    while (true) {
+        // the victim is whoever has the most left
+        size_t victim = worker;
+        uint64_t victim_range = 0;
+        uint32_t most_left = 0;
+        for (size_t other = 0; other < thread_count(); ++other) {
+            uint64_t range = m_slices[other].m_range.load(std::memory_order_acquire);
+            if (other != worker && range_end(range) > range_begin(range) &&
+                range_end(range) - range_begin(range) > most_left) {
+                victim = other;
+                victim_range = range;
+                most_left = range_end(range) - range_begin(range);
+            }
+        }
+        if (victim == worker) {
+            return false;
+        }
+
+        // the victim keeps the front half, a single task left moves over whole
+        uint32_t middle = range_begin(victim_range) + most_left / 2;
+        if (m_slices[victim].m_range.compare_exchange_strong(victim_range,
+                                                             pack_range(range_begin(victim_range), middle),
+                                                             std::memory_order_acq_rel)) {
+            m_slices[worker].m_range.store(pack_range(middle, range_end(victim_range)), std::memory_order_release);
+            return true;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Fixed set of worker threads for data parallel passes (chunked lexing, function bodies and the like).
+ * Every participant, the calling thread included, starts out owning an even contiguous slice of the task
+ * indices and runs it front to back. One which runs dry steals the back half of the largest slice left,
+ * so uneven tasks still balance while neighbouring indices mostly stay on the same thread.
+ * parallel_for returns once every index ran, the first exception thrown by a task is rethrown to the caller.
+ * Calls from different threads are serialized, calling parallel_for from inside a task deadlocks.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // workers plus the calling thread
+    size_t thread_count() const { return m_workers.size() + 1; }
+
+    void parallel_for(size_t task_count, const std::function<void(size_t)> &task);
+
+    // task also gets the index of the participant running it, below thread_count() and 0 for the caller,
+    // for state kept per thread
+    void parallel_for(size_t task_count, const std::function<void(size_t task, size_t worker)> &task);
+
+    static ThreadPool &shared();
+
+private:
+    // [begin, end) of the task indices a participant still owns, packed so owner and thieves can CAS it
+    struct alignas(64) TaskSlice {
+        std::atomic<uint64_t> m_range = 0;
+    };
+
+    void work(size_t worker);
+
+    void run_tasks(size_t worker);
+
+    bool take_own(size_t worker, size_t &index);
+
+    bool steal(size_t worker);
+
+    std::vector<std::thread> m_workers;
+    std::unique_ptr<TaskSlice[]> m_slices;
+    std::mutex m_run_mutex; // one parallel_for at a time
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const std::function<void(size_t, size_t)> *m_task = nullptr;
+    size_t m_first_task = 0;
+    size_t m_busy_workers = 0;
+    uint64_t m_generation = 0;
+    bool m_stopping = false;
+    std::exception_ptr m_error;
+};
@@ -1,7 +1,10 @@
+#include <limits>
+#include <type_traits>
+
 #include "token.h"
 
 
-Token::Token(const TOKEN_TYPE &token_type, const std::variant<int, std::string, char>& value) :
+Token::Token(const TOKEN_TYPE &token_type, const std::variant<int, Symbol, char>& value) :
         m_type(token_type),
         m_value(value) {
 
@@ -11,8 +14,8 @@ std::string Token::to_string() const {
     switch(m_value.index()){
         case 0: // int
             return std::to_string(std::get<int>(m_value));
-        case 1: // string
-            return std::get<std::string>(m_value);
+        case 1: // symbol
+            return std::string(std::get<Symbol>(m_value).text());
         default: // char
             return std::string(1, std::get<char>(m_value)); // NOLINT(modernize-return-braced-init-list)
     }
@@ -21,3 +24,19 @@ std::string Token::to_string() const {
 bool Token::operator==(const Token &other) const {
     return m_value == other.m_value && m_type == other.m_type;
 }
+
+Symbol token_symbol(TOKEN_TYPE token_type) {
+    static const auto symbols = [] {
+        std::array<Symbol, std::numeric_limits<std::underlying_type_t<TOKEN_TYPE>>::max() + 1> table{};
+        auto add_spellings = [&table](const auto &spellings) {
+            for (const auto &[spelling, type]: spellings) {
+                table[static_cast<size_t>(type)] = Symbol(spelling);
+            }
+        };
+        add_spellings(KEYWORD_SPELLINGS);
+        add_spellings(COMPOUND_OPERATOR_SPELLINGS);
+        add_spellings(SINGLE_OPERATOR_SPELLINGS);
+        return table;
+    }();
+    return symbols[static_cast<size_t>(token_type)];
+}
@@ -1,10 +1,17 @@
 #pragma once
+#include <array>
+#include <cstdint>
 #include <variant>
 #include <map>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <utility>
 
-enum class TOKEN_TYPE {
+#include "interner.h"
+#include "perfect_hash.h"
+
+enum class TOKEN_TYPE : uint8_t {
     IF,
     EQ,
     OR,
@@ -56,7 +63,15 @@ enum class TOKEN_TYPE {
     VOID
 };
 
-const std::map<std::string, TOKEN_TYPE> KEYWORDS = {
+constexpr size_t TOKEN_TYPE_COUNT = static_cast<size_t>(TOKEN_TYPE::VOID) + 1;
+
+using TokenSpelling = std::pair<std::string_view, TOKEN_TYPE>;
+
+/*
+ * The spelling lists below are the single source of truth,
+ * both the std::map views and the compile time lookup tables are generated from them.
+ */
+constexpr std::array<TokenSpelling, 11> KEYWORD_SPELLINGS = {{
 
         {"if",       TOKEN_TYPE::IF},
         {"else",     TOKEN_TYPE::ELSE},
@@ -71,7 +86,7 @@ const std::map<std::string, TOKEN_TYPE> KEYWORDS = {
         {"int",      TOKEN_TYPE::INT},
         {"char",     TOKEN_TYPE::CHAR},
         {"void",     TOKEN_TYPE::VOID},
-};
+}};
 
 const std::vector<TOKEN_TYPE> TYPES = {
         TOKEN_TYPE::INT,
@@ -80,7 +95,7 @@ const std::vector<TOKEN_TYPE> TYPES = {
 };
 
 constexpr int COMPOUND_OPERATOR_SIZE = 2;
-const std::map<std::string, TOKEN_TYPE> COMPOUND_OPERATORS = {
+constexpr std::array<TokenSpelling, 6> COMPOUND_OPERATOR_SPELLINGS = {{
 
         // Dual Character Operators
         {"==", TOKEN_TYPE::EQ},
@@ -89,10 +104,10 @@ const std::map<std::string, TOKEN_TYPE> COMPOUND_OPERATORS = {
         {">=", TOKEN_TYPE::GEQ},
         {"&&", TOKEN_TYPE::LAND},
         {"||", TOKEN_TYPE::LOR},
-};
+}};
 
 constexpr int SINGLE_OPERATOR_SIZE = 1;
-const std::map<std::string, TOKEN_TYPE> SINGLE_OPERATORS = {
+constexpr std::array<TokenSpelling, 19> SINGLE_OPERATOR_SPELLINGS = {{
         // Single Character Operators @NOTE : We don't insert '/' here as it needs to be check for start-of-comment use before being able to assert if its an operator.
         {"+", TOKEN_TYPE::ADD},
         {"-", TOKEN_TYPE::SUB},
@@ -115,7 +130,26 @@ const std::map<std::string, TOKEN_TYPE> SINGLE_OPERATORS = {
         {"{", TOKEN_TYPE::LBRACE},
         {"}", TOKEN_TYPE::RBRACE},
         {";", TOKEN_TYPE::SEMICOLON},
-};
+}};
+
+template<size_t N>
+std::map<std::string, TOKEN_TYPE> make_token_map(const std::array<TokenSpelling, N> &spellings) {
+    std::map<std::string, TOKEN_TYPE> map;
+    for (const auto &[spelling, type]: spellings) {
+        map.emplace(spelling, type);
+    }
+    return map;
+}
+
+const std::map<std::string, TOKEN_TYPE> KEYWORDS = make_token_map(KEYWORD_SPELLINGS);
+const std::map<std::string, TOKEN_TYPE> COMPOUND_OPERATORS = make_token_map(COMPOUND_OPERATOR_SPELLINGS);
+const std::map<std::string, TOKEN_TYPE> SINGLE_OPERATORS = make_token_map(SINGLE_OPERATOR_SPELLINGS);
+
+// O(1), allocation free lookups used by the lexer, EMPTY when the spelling isn't one of the table's tokens
+constexpr PerfectHashTable<TOKEN_TYPE, 32> KEYWORD_TABLE(KEYWORD_SPELLINGS, TOKEN_TYPE::EMPTY);
+constexpr PerfectHashTable<TOKEN_TYPE, 16> COMPOUND_OPERATOR_TABLE(COMPOUND_OPERATOR_SPELLINGS, TOKEN_TYPE::EMPTY);
+constexpr std::array<TOKEN_TYPE, 256> SINGLE_OPERATOR_TABLE = make_char_table(SINGLE_OPERATOR_SPELLINGS,
+                                                                              TOKEN_TYPE::EMPTY);
 
 constexpr std::array<TOKEN_TYPE, 15> ARITHMETIC_TOKENS = {
         TOKEN_TYPE::LOR,    // ||
@@ -137,11 +171,14 @@ constexpr std::array<TOKEN_TYPE, 15> ARITHMETIC_TOKENS = {
 
 struct Token {
 
-    Token(const TOKEN_TYPE& token_type, const std::variant<int, std::string, char>& value);
+    Token(const TOKEN_TYPE& token_type, const std::variant<int, Symbol, char>& value);
     bool operator==(const Token& other) const;
 
     TOKEN_TYPE m_type;
-    std::variant<int, std::string, char> m_value;
+    std::variant<int, Symbol, char> m_value;
 
     std::string to_string() const;
 };
+
+// interned spelling of a keyword / operator token type
+Symbol token_symbol(TOKEN_TYPE token_type);
@@ -0,0 +1,82 @@
+#include "token_cursor.h"
+
+#include <cstring>
+
+std::strong_ordering TokenCursor::iterator::operator<=>(const iterator &other) const {
+    if (m_is_end && other.m_is_end) {
+        return std::strong_ordering::equal;
+    }
+    if (m_is_end) {
+        return 0 <=> (other <=> *this);
+    }
+    if (!other.m_is_end) {
+        return m_index <=> other.m_index;
+    }
+    // only lex as far as this token, end() is behind it whenever it exists
+    if (m_cursor->reach(m_index)) {
+        return std::strong_ordering::less;
+    }
+    return m_index <=> m_cursor->lexed_count();
+}
+
+size_t TokenCursor::iterator::index() const {
+    if (m_is_end) {
+        while (m_cursor->reach(m_cursor->lexed_count())) {}
+        return m_cursor->lexed_count();
+    }
+    return m_index;
+}
+
+TokenCursor::TokenCursor(std::shared_ptr<const SourceBuffer> source, size_t window)
+        : m_source(std::move(source)), m_window(std::max<size_t>(window, 1)), m_pending(m_source) {}
+
+bool TokenCursor::reach(size_t index) {
+    while (m_lexed_count <= index) {
+        if (m_next_pending == m_pending.size()) {
+            if (m_lexed_bytes == m_source->size()) {
+                return false;
+            }
+            lex_batch();
+            continue;
+        }
+        m_window[m_lexed_count % m_window.size()] = {m_pending.kind(m_next_pending), m_pending.offset(m_next_pending),
+                                                     m_pending.length(m_next_pending),
+                                                     m_pending.payload(m_next_pending)};
+        ++m_next_pending;
+        ++m_lexed_count;
+    }
+    return true;
+}
+
+TokenView TokenCursor::at(size_t index) {
+    if (index + m_window.size() < m_lexed_count) {
+        throw CompilerException(TOKEN_OUTSIDE_WINDOW);
+    }
+    if (!reach(index)) {
+        throw CompilerException(TOKEN_PAST_END);
+    }
+    const Slot &slot = m_window[index % m_window.size()];
+    return {slot.m_type, std::string_view(m_source->data() + slot.m_offset, slot.m_length), slot.m_payload};
+}
+
+size_t TokenCursor::memory_usage() const {
+    return m_window.capacity() * sizeof(Slot) + m_pending.memory_usage();
+}
+
+void TokenCursor::lex_batch() {
+    const char *data = m_source->data();
+    const size_t size = m_source->size();
+    size_t end = size;
+    if (size - m_lexed_bytes > LEX_BATCH_BYTES) {
+        auto newline = static_cast<const char *>(std::memchr(data + m_lexed_bytes + LEX_BATCH_BYTES, '\n',
+                                                             size - m_lexed_bytes - LEX_BATCH_BYTES));
+        end = newline == nullptr ? size : newline - data + 1;
+    }
+
+    m_pending.clear();
+    m_next_pending = 0;
+    DEBUG_MSG("lexing bytes " << m_lexed_bytes << " to " << end << " on demand");
+    size_t begin = m_lexed_bytes;
+    m_lexed_bytes = end; // a batch that throws isn't retried
+    m_lexer.lex_range(m_source, m_pending, begin, end);
+}
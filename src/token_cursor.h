@@ -0,0 +1,147 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "lexer.h"
+#include "token_stream.h"
+
+constexpr size_t DEFAULT_TOKEN_WINDOW = 1 << 12;
+constexpr size_t LEX_BATCH_BYTES = 1 << 12; // lexed a few lines at a time, cut at the next newline
+
+constexpr const char *TOKEN_OUTSIDE_WINDOW = "token is no longer in the lexer window, use a larger window";
+constexpr const char *TOKEN_PAST_END = "token past the end of the input";
+
+/*
+ * Pull based token source: tokens are lexed only when the parser reaches them and only the last
+ * window tokens stay around, so token memory doesn't grow with the input.
+ * Its iterators support what Parser's templates use (including it + n and comparisons with end()),
+ * comparing against end() lexes at most up to the compared token. Looking further back than the window
+ * throws TOKEN_OUTSIDE_WINDOW.
+ * The iterator category is bidirectional so standard algorithms walk towards end() instead of
+ * measuring the distance to it, which would lex the whole input at once.
+ */
+class TokenCursor {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = TokenView;
+        using difference_type = std::ptrdiff_t;
+        using reference = TokenView;
+
+        struct pointer {
+            TokenView m_view;
+
+            const TokenView *operator->() const { return &m_view; }
+        };
+
+        iterator() = default;
+
+        iterator(TokenCursor *cursor, size_t index, bool is_end) : m_cursor(cursor), m_index(index), m_is_end(is_end) {}
+
+        TokenView operator*() const { return m_cursor->at(m_index); }
+
+        pointer operator->() const { return {m_cursor->at(m_index)}; }
+
+        TokenView operator[](difference_type offset) const { return m_cursor->at(m_index + offset); }
+
+        iterator &operator++() {
+            ++m_index;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            auto previous = *this;
+            ++m_index;
+            return previous;
+        }
+
+        iterator &operator--() {
+            --m_index;
+            return *this;
+        }
+
+        iterator operator--(int) {
+            auto previous = *this;
+            --m_index;
+            return previous;
+        }
+
+        iterator &operator+=(difference_type offset) {
+            m_index += offset;
+            return *this;
+        }
+
+        iterator &operator-=(difference_type offset) {
+            m_index -= offset;
+            return *this;
+        }
+
+        iterator operator+(difference_type offset) const { return {m_cursor, m_index + offset, false}; }
+
+        iterator operator-(difference_type offset) const { return {m_cursor, m_index - offset, false}; }
+
+        // involving end() lexes the rest of the input
+        difference_type operator-(const iterator &other) const {
+            return static_cast<difference_type>(index()) - static_cast<difference_type>(other.index());
+        }
+
+        bool operator==(const iterator &other) const { return (*this <=> other) == 0; }
+
+        std::strong_ordering operator<=>(const iterator &other) const;
+
+        // position in the whole token sequence, for end() that's the token count
+        size_t index() const;
+
+        TokenCursor *cursor() const { return m_cursor; }
+
+    private:
+        TokenCursor *m_cursor = nullptr;
+        size_t m_index = 0;
+        bool m_is_end = false;
+    };
+
+    explicit TokenCursor(std::shared_ptr<const SourceBuffer> source, size_t window = DEFAULT_TOKEN_WINDOW);
+
+    iterator begin() { return {this, 0, false}; }
+
+    iterator end() { return {this, 0, true}; }
+
+    // lexes until the token at index exists, false when the input ends first
+    bool reach(size_t index);
+
+    TokenView at(size_t index);
+
+    // tokens lexed so far
+    size_t lexed_count() const { return m_lexed_count; }
+
+    // heap bytes held by the window and the batch being handed out
+    size_t memory_usage() const;
+
+    const std::shared_ptr<const SourceBuffer> &source() const { return m_source; }
+
+    // errors in the part of the input lexed so far
+    const Diagnostics &diagnostics() const { return m_lexer.diagnostics(); }
+
+private:
+    struct Slot {
+        TOKEN_TYPE m_type;
+        uint32_t m_offset;
+        uint32_t m_length;
+        uint32_t m_payload;
+    };
+
+    void lex_batch();
+
+    std::shared_ptr<const SourceBuffer> m_source;
+    Lexer m_lexer;
+    std::vector<Slot> m_window; // ring, token i lives at i % window size
+    size_t m_lexed_count = 0;
+    TokenStream m_pending; // tokens of the last lexed batch not yet moved into the window
+    size_t m_next_pending = 0;
+    size_t m_lexed_bytes = 0;
+};
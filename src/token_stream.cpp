@@ -0,0 +1,142 @@
+#include "token_stream.h"
+
+#include <algorithm>
+
+std::string_view TokenView::text() const {
+    if (m_type == TOKEN_TYPE::STRING) {
+        return m_lexeme.substr(1, m_lexeme.size() - 2); // strip delimiters
+    }
+    return m_lexeme;
+}
+
+TokenView::operator Token() const {
+    switch (m_type) {
+        case TOKEN_TYPE::INTEGER:
+            return {m_type, static_cast<int>(m_payload)};
+        case TOKEN_TYPE::CHARACTER:
+            return {m_type, static_cast<char>(m_payload)};
+        default:
+            return {m_type, Symbol::from_id(m_payload)};
+    }
+}
+
+bool TokenView::operator==(const Token &other) const {
+    if (m_type != other.m_type) {
+        return false;
+    }
+    switch (other.m_value.index()) {
+        case 0: // int
+            return m_type == TOKEN_TYPE::INTEGER && static_cast<int>(m_payload) == std::get<int>(other.m_value);
+        case 1: // symbol
+            return m_type != TOKEN_TYPE::INTEGER && m_type != TOKEN_TYPE::CHARACTER &&
+                   m_payload == std::get<Symbol>(other.m_value).m_id;
+        default: // char
+            return m_type == TOKEN_TYPE::CHARACTER && static_cast<char>(m_payload) == std::get<char>(other.m_value);
+    }
+}
+
+bool TokenView::operator==(const TokenView &other) const {
+    return m_type == other.m_type && m_payload == other.m_payload;
+}
+
+std::string TokenView::to_string() const {
+    switch (m_type) {
+        case TOKEN_TYPE::INTEGER:
+            return std::to_string(static_cast<int>(m_payload));
+        case TOKEN_TYPE::CHARACTER:
+            return std::string(1, static_cast<char>(m_payload)); // NOLINT(modernize-return-braced-init-list)
+        default:
+            return std::string(text());
+    }
+}
+
+void TokenStream::reserve(size_t count) {
+    m_kinds.reserve(count);
+    m_offsets.reserve(count);
+    m_lengths.reserve(count);
+    m_payloads.reserve(count);
+}
+
+void TokenStream::resize(size_t count) {
+    m_kinds.resize(count);
+    m_offsets.resize(count);
+    m_lengths.resize(count);
+    m_payloads.resize(count);
+    m_partners.clear(); // stale until brackets are matched again
+    m_first_unbalanced = NO_PARTNER;
+}
+
+void TokenStream::copy_from(const TokenStream &other, size_t index) {
+    std::copy(other.m_kinds.begin(), other.m_kinds.end(), m_kinds.begin() + index);
+    std::copy(other.m_offsets.begin(), other.m_offsets.end(), m_offsets.begin() + index);
+    std::copy(other.m_lengths.begin(), other.m_lengths.end(), m_lengths.begin() + index);
+    std::copy(other.m_payloads.begin(), other.m_payloads.end(), m_payloads.begin() + index);
+}
+
+void TokenStream::append(const TokenStream &other, size_t first, size_t last, int64_t offset_shift) {
+    m_partners.clear();
+    m_kinds.insert(m_kinds.end(), other.m_kinds.begin() + first, other.m_kinds.begin() + last);
+    for (size_t index = first; index < last; ++index) {
+        m_offsets.push_back(static_cast<uint32_t>(other.m_offsets[index] + offset_shift));
+    }
+    m_lengths.insert(m_lengths.end(), other.m_lengths.begin() + first, other.m_lengths.begin() + last);
+    m_payloads.insert(m_payloads.end(), other.m_payloads.begin() + first, other.m_payloads.begin() + last);
+}
+
+size_t TokenStream::first_token_at(uint32_t offset) const {
+    return std::lower_bound(m_offsets.begin(), m_offsets.end(), offset) - m_offsets.begin();
+}
+
+void TokenStream::match_brackets() {
+    m_partners.assign(size(), NO_PARTNER);
+    m_first_unbalanced = NO_PARTNER;
+    std::vector<uint32_t> open;
+    for (uint32_t index = 0; index < size(); ++index) {
+        TOKEN_TYPE opening;
+        switch (m_kinds[index]) {
+            case TOKEN_TYPE::LPARENS:
+            case TOKEN_TYPE::LBRACKET:
+            case TOKEN_TYPE::LBRACE:
+                open.push_back(index);
+                continue;
+            case TOKEN_TYPE::RPARENS:
+                opening = TOKEN_TYPE::LPARENS;
+                break;
+            case TOKEN_TYPE::RBRACKET:
+                opening = TOKEN_TYPE::LBRACKET;
+                break;
+            case TOKEN_TYPE::RBRACE:
+                opening = TOKEN_TYPE::LBRACE;
+                break;
+            default:
+                continue;
+        }
+        if (!open.empty() && m_kinds[open.back()] == opening) {
+            m_partners[open.back()] = index;
+            m_partners[index] = open.back();
+            open.pop_back();
+        } else {
+            m_first_unbalanced = std::min(m_first_unbalanced, index);
+        }
+    }
+    if (!open.empty()) {
+        m_first_unbalanced = std::min(m_first_unbalanced, open.front());
+    }
+}
+
+size_t TokenStream::memory_usage() const {
+    return m_kinds.capacity() * sizeof(TOKEN_TYPE) +
+           m_partners.capacity() * sizeof(uint32_t) +
+           m_offsets.capacity() * sizeof(uint32_t) +
+           m_lengths.capacity() * sizeof(uint32_t) +
+           m_payloads.capacity() * sizeof(uint32_t);
+}
+
+std::vector<Token> TokenStream::to_tokens() const {
+    std::vector<Token> tokens;
+    tokens.reserve(size());
+    for (const auto &view: *this) {
+        tokens.push_back(view);
+    }
+    return tokens;
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "token.h"
+#include "source_buffer.h"
+
+constexpr uint32_t NO_PARTNER = UINT32_MAX;
+
+/*
+ * Lightweight view of a single token inside a TokenStream.
+ * The text is a view into the source buffer, a Token is only materialized when one is asked for.
+ */
+struct TokenView {
+    TOKEN_TYPE m_type;
+    std::string_view m_lexeme; // raw source text, delimiters included
+    uint32_t m_payload;        // integer / character literal value, symbol id otherwise
+
+    operator Token() const; // NOLINT(google-explicit-constructor)
+
+    bool operator==(const Token &other) const;
+
+    bool operator==(const TokenView &other) const;
+
+    std::string_view text() const;
+
+    std::string to_string() const;
+};
+
+/*
+ * Tokens of a translation unit packed as parallel arrays:
+ * kind (1 byte) + source offset (4 bytes) + length (4 bytes) + payload (4 bytes).
+ * Identifiers, keywords, operators and strings carry their interned symbol id as payload.
+ * Every bracket also knows the index of its partner, recorded in one pass once the stream is lexed.
+ */
+class TokenStream {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = TokenView;
+        using difference_type = std::ptrdiff_t;
+        using reference = TokenView;
+
+        struct pointer {
+            TokenView m_view;
+
+            const TokenView *operator->() const { return &m_view; }
+        };
+
+        const_iterator() = default;
+
+        const_iterator(const TokenStream *stream, size_t index) : m_stream(stream), m_index(index) {}
+
+        TokenView operator*() const { return (*m_stream)[m_index]; }
+
+        pointer operator->() const { return {(*m_stream)[m_index]}; }
+
+        TokenView operator[](difference_type offset) const { return (*m_stream)[m_index + offset]; }
+
+        const_iterator &operator++() {
+            ++m_index;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto previous = *this;
+            ++m_index;
+            return previous;
+        }
+
+        const_iterator &operator--() {
+            --m_index;
+            return *this;
+        }
+
+        const_iterator operator--(int) {
+            auto previous = *this;
+            --m_index;
+            return previous;
+        }
+
+        const_iterator &operator+=(difference_type offset) {
+            m_index += offset;
+            return *this;
+        }
+
+        const_iterator &operator-=(difference_type offset) {
+            m_index -= offset;
+            return *this;
+        }
+
+        const_iterator operator+(difference_type offset) const { return {m_stream, m_index + offset}; }
+
+        friend const_iterator operator+(difference_type offset, const const_iterator &it) { return it + offset; }
+
+        const_iterator operator-(difference_type offset) const { return {m_stream, m_index - offset}; }
+
+        difference_type operator-(const const_iterator &other) const {
+            return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index);
+        }
+
+        bool operator==(const const_iterator &other) const { return m_index == other.m_index; }
+
+        auto operator<=>(const const_iterator &other) const { return m_index <=> other.m_index; }
+
+        size_t index() const { return m_index; }
+
+        const TokenStream *stream() const { return m_stream; }
+
+    private:
+        const TokenStream *m_stream = nullptr;
+        size_t m_index = 0;
+    };
+
+    TokenStream() = default;
+
+    explicit TokenStream(std::shared_ptr<const SourceBuffer> source) : m_source(std::move(source)) {}
+
+    void reserve(size_t count);
+
+    void resize(size_t count);
+
+    void clear() { resize(0); }
+
+    // appends other's tokens [first, last) with offset_shift added to their offsets
+    void append(const TokenStream &other, size_t first, size_t last, int64_t offset_shift = 0);
+
+    // index of the first token starting at or after offset, size() if there's none
+    size_t first_token_at(uint32_t offset) const;
+
+    // copies every token of other over [index, index + other.size()), which must already exist
+    void copy_from(const TokenStream &other, size_t index);
+
+    void push_back(TOKEN_TYPE type, uint32_t offset, uint32_t length, uint32_t payload) {
+        m_kinds.push_back(type);
+        m_offsets.push_back(offset);
+        m_lengths.push_back(length);
+        m_payloads.push_back(payload);
+    }
+
+    size_t size() const { return m_kinds.size(); }
+
+    bool empty() const { return m_kinds.empty(); }
+
+    TOKEN_TYPE kind(size_t index) const { return m_kinds[index]; }
+
+    uint32_t offset(size_t index) const { return m_offsets[index]; }
+
+    uint32_t length(size_t index) const { return m_lengths[index]; }
+
+    uint32_t payload(size_t index) const { return m_payloads[index]; }
+
+    std::string_view lexeme(size_t index) const {
+        return {m_source->data() + m_offsets[index], m_lengths[index]};
+    }
+
+    /*
+     * Pairs every (, [ and { with its closing token, in a single pass over the kinds.
+     * A closing token that doesn't match the innermost open one is left unpaired and so is
+     * anything left open at the end. The lexer calls this once a stream is complete.
+     */
+    void match_brackets();
+
+    // index of the bracket closing / opening the one at index, NO_PARTNER when it's unbalanced or not a bracket
+    uint32_t partner(size_t index) const { return m_partners[index]; }
+
+    // index of the first unpaired bracket, NO_PARTNER when all brackets are balanced
+    uint32_t first_unbalanced() const { return m_first_unbalanced; }
+
+    // resolved through the source's line table, nothing per token is stored for it
+    SourceLocation location(size_t index) const { return m_source->location(m_offsets[index]); }
+
+    TokenView operator[](size_t index) const { return {m_kinds[index], lexeme(index), m_payloads[index]}; }
+
+    const_iterator begin() const { return {this, 0}; }
+
+    const_iterator end() const { return {this, size()}; }
+
+    const std::shared_ptr<const SourceBuffer> &source() const { return m_source; }
+
+    // heap bytes held by the parallel arrays
+    size_t memory_usage() const;
+
+    std::vector<Token> to_tokens() const;
+
+private:
+    std::shared_ptr<const SourceBuffer> m_source;
+    std::vector<TOKEN_TYPE> m_kinds;
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_lengths;
+    std::vector<uint32_t> m_payloads;
+    std::vector<uint32_t> m_partners;
+    uint32_t m_first_unbalanced = NO_PARTNER;
+};
@@ -0,0 +1,281 @@
+#include "type_checker.h"
+
+#include "ast_visitor.h"
+
+namespace {
+
+    bool is_comparison(TOKEN_TYPE type) {
+        switch (type) {
+            case TOKEN_TYPE::LESS:
+            case TOKEN_TYPE::GREAT:
+            case TOKEN_TYPE::LEQ:
+            case TOKEN_TYPE::GEQ:
+            case TOKEN_TYPE::EQ:
+            case TOKEN_TYPE::NEQ:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool is_null_constant(const ASTNode *node) {
+        return node->m_token == Token(TOKEN_TYPE::INTEGER, 0) && node_kind(*node) == NODE_KIND::LEAF;
+    }
+}
+
+void TypeChecker::check(const NodeList &declarations) {
+    // children are typed before their parents. An if or while condition is checked as soon as it's typed,
+    // before the walk goes on into the statements, so errors come out in source order
+    struct Visitor {
+        TypeChecker &m_checker;
+
+        void enter(TreeNode node) {
+            if (node.kind() == NODE_KIND::FUNC_DECLARATION) {
+                m_checker.m_return_types.push_back(
+                        m_checker.m_table.return_type(m_checker.declared_type(node.node())));
+            }
+        }
+
+        void before_child(TreeNode node, uint32_t index) {
+            if (index == 1 && (node.kind() == NODE_KIND::IF || node.kind() == NODE_KIND::WHILE)) {
+                m_checker.check_condition(node.child(0).node());
+            }
+        }
+
+        void leave(TreeNode node) {
+            m_checker.leave(node.node());
+        }
+    };
+    Visitor visitor{*this};
+    for (const ASTNode *declaration: declarations) {
+        walk(TreeNode(declaration), visitor);
+    }
+}
+
+void TypeChecker::check_condition(const ASTNode *condition) {
+    TypeId type = type_of(condition);
+    if (type != TypeTable::ERROR_TYPE && !m_table.is_scalar(type)) {
+        report(NON_SCALAR_CONDITION + quoted(type), condition);
+    }
+}
+
+void TypeChecker::leave(const ASTNode *node) {
+    switch (node_kind(*node)) {
+        case NODE_KIND::LEAF:
+            m_node_types[node] = leaf_type(node);
+            break;
+        case NODE_KIND::BINARY_OPERATION:
+            m_node_types[node] = binary_type(node);
+            break;
+        case NODE_KIND::UNARY_OPERATION:
+            m_node_types[node] = unary_type(node);
+            break;
+        case NODE_KIND::FUNC_CALL:
+            m_node_types[node] = call_type(node);
+            break;
+        case NODE_KIND::VARIABLE_DECLARATION:
+            if (declared_type(node) == TypeTable::VOID_TYPE && node->m_token.m_type != TOKEN_TYPE::EMPTY) {
+                report(VOID_VARIABLE + node->m_token.to_string(), node);
+            }
+            break;
+        case NODE_KIND::FUNC_DECLARATION:
+            m_return_types.pop_back();
+            break;
+        case NODE_KIND::RETURN: {
+            TypeId expected = m_return_types.empty() ? TypeTable::ERROR_TYPE : m_return_types.back();
+            const ASTNode *value = std::get<ReturnStatement>(node->m_members).value;
+            if (!value) {
+                if (expected != TypeTable::VOID_TYPE && expected != TypeTable::ERROR_TYPE) {
+                    report(MISSING_RETURN_VALUE, node);
+                }
+            } else if (expected == TypeTable::VOID_TYPE) {
+                report(VOID_RETURN_VALUE, value);
+            } else if (!assignable(expected, type_of(value), value)) {
+                report(INCOMPATIBLE_RETURN + quoted(type_of(value)) + " to " + quoted(expected), value);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+TypeId TypeChecker::declared_type(const ASTNode *declaration) {
+    if (auto known = m_node_types.find(declaration); known != m_node_types.end()) {
+        return known->second;
+    }
+    TypeId type;
+    if (const auto *variable = std::get_if<VariableDeclaration>(&declaration->m_members)) {
+        type = m_table.from_type_name(variable->type);
+    } else {
+        const auto &function = std::get<FuncDeclaration>(declaration->m_members);
+        std::vector<TypeId> params;
+        for (const ASTNode *param: function.params) {
+            params.push_back(declared_type(param));
+        }
+        if (params.size() == 1 && params[0] == TypeTable::VOID_TYPE &&
+            function.params[0]->m_token.m_type == TOKEN_TYPE::EMPTY) {
+            params.clear();
+        }
+        type = m_table.function(m_table.from_type_name(function.return_type), params);
+
+        uint32_t name = std::get<Symbol>(declaration->m_token.m_value).m_id;
+        auto [earlier, first] = m_function_types.try_emplace(name, type);
+        if (!first && earlier->second != type) {
+            report(CONFLICTING_TYPES + declaration->m_token.to_string() + ": " + quoted(earlier->second) + " and " +
+                   quoted(type), declaration);
+        }
+    }
+    m_node_types.emplace(declaration, type);
+    return type;
+}
+
+TypeId TypeChecker::binary_type(const ASTNode *node) {
+    const auto &operation = std::get<BinaryOperation>(node->m_members);
+    TypeId lhs = type_of(operation.lhs);
+    TypeId rhs = type_of(operation.rhs);
+    TOKEN_TYPE op = node->m_token.m_type;
+    if (lhs == TypeTable::ERROR_TYPE || rhs == TypeTable::ERROR_TYPE) {
+        return op == TOKEN_TYPE::ASSIGN ? lhs : TypeTable::ERROR_TYPE;
+    }
+
+    bool integers = m_table.is_integer(lhs) && m_table.is_integer(rhs);
+    bool lhs_pointer = m_table.kind(lhs) == TYPE_KIND::POINTER;
+    bool rhs_pointer = m_table.kind(rhs) == TYPE_KIND::POINTER;
+    switch (op) {
+        case TOKEN_TYPE::ASSIGN:
+            if (!assignable(lhs, rhs, operation.rhs)) {
+                report(INCOMPATIBLE_ASSIGNMENT + quoted(rhs) + " to " + quoted(lhs), node);
+            }
+            return lhs;
+        case TOKEN_TYPE::LBRACKET:
+            if (lhs_pointer && m_table.pointee(lhs) != TypeTable::VOID_TYPE && m_table.is_integer(rhs)) {
+                return m_table.pointee(lhs);
+            }
+            break;
+        case TOKEN_TYPE::ADD:
+            if (integers) {
+                return TypeTable::INT_TYPE;
+            }
+            if (lhs_pointer && m_table.is_integer(rhs)) {
+                return lhs;
+            }
+            if (rhs_pointer && m_table.is_integer(lhs)) {
+                return rhs;
+            }
+            break;
+        case TOKEN_TYPE::SUB:
+            if (integers || (lhs_pointer && lhs == rhs)) {
+                return TypeTable::INT_TYPE;
+            }
+            if (lhs_pointer && m_table.is_integer(rhs)) {
+                return lhs;
+            }
+            break;
+        case TOKEN_TYPE::LAND:
+        case TOKEN_TYPE::LOR:
+            if (m_table.is_scalar(lhs) && m_table.is_scalar(rhs)) {
+                return TypeTable::INT_TYPE;
+            }
+            break;
+        default:
+            if (integers) {
+                return TypeTable::INT_TYPE;
+            }
+            // pointers compare with pointers of the same type, void * and the null pointer constant
+            if (is_comparison(op) && (lhs_pointer || rhs_pointer) &&
+                assignable(lhs_pointer ? lhs : rhs, lhs_pointer ? rhs : lhs, lhs_pointer ? operation.rhs : operation.lhs)) {
+                return TypeTable::INT_TYPE;
+            }
+    }
+    report(INVALID_OPERANDS + node->m_token.to_string() + ": " + quoted(lhs) + " and " + quoted(rhs), node);
+    return TypeTable::ERROR_TYPE;
+}
+
+TypeId TypeChecker::unary_type(const ASTNode *node) {
+    TypeId operand = type_of(std::get<UnaryOperation>(node->m_members).operand);
+    if (operand == TypeTable::ERROR_TYPE) {
+        return TypeTable::ERROR_TYPE;
+    }
+    switch (node->m_token.m_type) {
+        case TOKEN_TYPE::ADDRESSOF:
+            return m_table.pointer_to(operand);
+        case TOKEN_TYPE::DEREF:
+            if (m_table.kind(operand) == TYPE_KIND::POINTER && m_table.pointee(operand) != TypeTable::VOID_TYPE) {
+                return m_table.pointee(operand);
+            }
+            break;
+        case TOKEN_TYPE::BANG:
+            if (m_table.is_scalar(operand)) {
+                return TypeTable::INT_TYPE;
+            }
+            break;
+        default: // negation
+            if (m_table.is_integer(operand)) {
+                return TypeTable::INT_TYPE;
+            }
+    }
+    report(INVALID_OPERAND + node->m_token.to_string() + ": " + quoted(operand), node);
+    return TypeTable::ERROR_TYPE;
+}
+
+TypeId TypeChecker::call_type(const ASTNode *node) {
+    const ASTNode *callee = m_resolver.declaration_of(node);
+    if (!callee) {
+        return TypeTable::ERROR_TYPE; // reported by the resolver
+    }
+    if (node_kind(*callee) != NODE_KIND::FUNC_DECLARATION) {
+        report(NOT_A_FUNCTION + node->m_token.to_string(), node);
+        return TypeTable::ERROR_TYPE;
+    }
+
+    TypeId function = declared_type(callee);
+    auto params = m_table.params(function);
+    const auto &args = std::get<FuncCall>(node->m_members).arg;
+    if (args.size() != params.size()) {
+        report(ARGUMENT_COUNT + node->m_token.to_string() + ": expected " + std::to_string(params.size()) + ", got " +
+               std::to_string(args.size()), node);
+    } else {
+        for (size_t index = 0; index < args.size(); ++index) {
+            TypeId arg = type_of(args[index]);
+            if (!assignable(params[index], arg, args[index])) {
+                report(INCOMPATIBLE_ARGUMENT + node->m_token.to_string() + " " + std::to_string(index + 1) + ": " +
+                       quoted(arg) + " to " + quoted(params[index]), args[index]);
+            }
+        }
+    }
+    return m_table.return_type(function);
+}
+
+TypeId TypeChecker::leaf_type(const ASTNode *node) {
+    switch (node->m_token.m_type) {
+        case TOKEN_TYPE::INTEGER:
+            return TypeTable::INT_TYPE;
+        case TOKEN_TYPE::CHARACTER:
+            return TypeTable::CHAR_TYPE;
+        case TOKEN_TYPE::STRING:
+            return m_table.pointer_to(TypeTable::CHAR_TYPE);
+        case TOKEN_TYPE::IDENTIFIER: {
+            const ASTNode *declaration = m_resolver.declaration_of(node);
+            return declaration ? declared_type(declaration) : TypeTable::ERROR_TYPE;
+        }
+        default: // break, continue
+            return TypeTable::ERROR_TYPE;
+    }
+}
+
+bool TypeChecker::assignable(TypeId target, TypeId value, const ASTNode *value_node) const {
+    if (target == value || target == TypeTable::ERROR_TYPE || value == TypeTable::ERROR_TYPE) {
+        return true;
+    }
+    if (m_table.is_integer(target) && m_table.is_integer(value)) {
+        return true;
+    }
+    if (m_table.kind(target) != TYPE_KIND::POINTER) {
+        return false;
+    }
+    if (m_table.kind(value) == TYPE_KIND::POINTER) {
+        return m_table.pointee(target) == TypeTable::VOID_TYPE || m_table.pointee(value) == TypeTable::VOID_TYPE;
+    }
+    return is_null_constant(value_node);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+#include "diagnostics.h"
+#include "name_resolver.h"
+#include "types.h"
+
+constexpr const char *INVALID_OPERANDS = "invalid operands to binary ";
+constexpr const char *INVALID_OPERAND = "invalid operand to unary ";
+constexpr const char *INCOMPATIBLE_ASSIGNMENT = "incompatible types in assignment: ";
+constexpr const char *NOT_A_FUNCTION = "called object is not a function: ";
+constexpr const char *ARGUMENT_COUNT = "wrong number of arguments to ";
+constexpr const char *INCOMPATIBLE_ARGUMENT = "incompatible argument to ";
+constexpr const char *INCOMPATIBLE_RETURN = "incompatible types in return: ";
+constexpr const char *MISSING_RETURN_VALUE = "non-void function returns no value";
+constexpr const char *VOID_RETURN_VALUE = "void function returns a value";
+constexpr const char *VOID_VARIABLE = "variable declared void: ";
+constexpr const char *NON_SCALAR_CONDITION = "condition is neither an integer nor a pointer: ";
+constexpr const char *CONFLICTING_TYPES = "conflicting types for: ";
+
+/*
+ * Semantic pass run after NameResolver: types every expression, declaration and function with a type from
+ * its own TypeTable and checks operators, assignments, calls, returns and conditions against them. The types
+ * are kept by the checker rather than written into the tree, so checkers run over the same tree never see
+ * each other's ids.
+ * Calls are checked against the parameter types of the declaration they resolved to, a lone unnamed void
+ * parameter meaning none. char and int convert into each other, void * into and from any pointer, and the
+ * literal 0 into any pointer. An expression which fails gets the error type, which checks against anything,
+ * so one mistake is reported once. Diagnostics are located through the source the resolver was given.
+ */
+class TypeChecker {
+public:
+    explicit TypeChecker(const NameResolver &resolver) : m_resolver(resolver) {}
+
+    void check(const NodeList &declarations);
+
+    // the type this checker gave node, an id in types(). The error type when it didn't check it
+    TypeId type_of(const ASTNode *node) const {
+        auto known = m_node_types.find(node);
+        return known == m_node_types.end() ? TypeTable::ERROR_TYPE : known->second;
+    }
+
+    TypeTable &types() { return m_table; }
+
+    const Diagnostics &diagnostics() const { return m_diagnostics; }
+
+private:
+    void check_condition(const ASTNode *condition);
+
+    // types node once its children are typed
+    void leave(const ASTNode *node);
+
+    // the declared type of a variable, a function's type
+    TypeId declared_type(const ASTNode *declaration);
+
+    TypeId binary_type(const ASTNode *node);
+
+    TypeId unary_type(const ASTNode *node);
+
+    TypeId call_type(const ASTNode *node);
+
+    TypeId leaf_type(const ASTNode *node);
+
+    bool assignable(TypeId target, TypeId value, const ASTNode *value_node) const;
+
+    void report(std::string message, const ASTNode *node) {
+        m_diagnostics.report(std::move(message), node_location(*node, m_resolver.source()));
+    }
+
+    std::string quoted(TypeId type) const { return "'" + m_table.to_string(type) + "'"; }
+
+    const NameResolver &m_resolver;
+    TypeTable m_table;
+    std::unordered_map<const ASTNode *, TypeId> m_node_types; // a declaration's worked out on first use
+    std::unordered_map<uint32_t, TypeId> m_function_types; // every declaration of a name must agree
+    std::vector<TypeId> m_return_types; // of the functions being checked, innermost last
+    Diagnostics m_diagnostics;
+};
@@ -0,0 +1,83 @@
+#include "types.h"
+
+#include <algorithm>
+
+#include "xxhash.h"
+
+TypeTable::TypeTable() {
+    for (TYPE_KIND kind: {TYPE_KIND::ERROR, TYPE_KIND::VOID, TYPE_KIND::CHAR, TYPE_KIND::INT}) {
+        add({kind});
+    }
+}
+
+TypeId TypeTable::pointer_to(TypeId pointee) {
+    if (m_pointer_to[pointee] == NO_TYPE) {
+        TypeId pointer = add({TYPE_KIND::POINTER, pointee});
+        m_pointer_to[pointee] = pointer;
+    }
+    return m_pointer_to[pointee];
+}
+
+TypeId TypeTable::function(TypeId return_type, std::span<const TypeId> params) {
+    uint64_t signature_hash = xxh64(params.data(), params.size_bytes(), return_type);
+    auto [first, last] = m_functions.equal_range(signature_hash);
+    for (auto candidate = first; candidate != last; ++candidate) {
+        TypeId type = candidate->second;
+        if (this->return_type(type) == return_type && std::ranges::equal(this->params(type), params)) {
+            return type;
+        }
+    }
+    auto first_param = static_cast<uint32_t>(m_params.size());
+    m_params.insert(m_params.end(), params.begin(), params.end());
+    TypeId type = add({TYPE_KIND::FUNCTION, return_type, first_param, static_cast<uint32_t>(params.size())});
+    m_functions.emplace(signature_hash, type);
+    return type;
+}
+
+TypeId TypeTable::from_type_name(const TypeName &name) {
+    TypeId type;
+    switch (name.base.m_type) {
+        case TOKEN_TYPE::INT:
+            type = INT_TYPE;
+            break;
+        case TOKEN_TYPE::CHAR:
+            type = CHAR_TYPE;
+            break;
+        default:
+            type = VOID_TYPE;
+    }
+    for (uint8_t level = 0; level < name.pointer_depth; ++level) {
+        type = pointer_to(type);
+    }
+    return type;
+}
+
+std::string TypeTable::to_string(TypeId type) const {
+    switch (kind(type)) {
+        case TYPE_KIND::ERROR:
+            return "<error>";
+        case TYPE_KIND::VOID:
+            return "void";
+        case TYPE_KIND::CHAR:
+            return "char";
+        case TYPE_KIND::INT:
+            return "int";
+        case TYPE_KIND::POINTER: {
+            std::string pointee = to_string(this->pointee(type));
+            return pointee + (pointee.back() == '*' ? "*" : " *");
+        }
+        default: {
+            std::string text = to_string(return_type(type)) + " (";
+            for (TypeId param: params(type)) {
+                text += (text.back() == '(' ? "" : ", ") + to_string(param);
+            }
+            return text + ")";
+        }
+    }
+}
+
+TypeId TypeTable::add(Type type) {
+    m_types.push_back(type);
+    m_pointer_to.push_back(NO_TYPE);
+    return static_cast<TypeId>(m_types.size() - 1);
+}
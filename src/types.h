@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+
+enum class TYPE_KIND : uint8_t {
+    ERROR, // stands in for an expression which already failed to check, so one error isn't reported again
+    VOID,
+    CHAR,
+    INT,
+    POINTER,
+    FUNCTION,
+};
+
+/*
+ * Hash consed types: every distinct type is built once and named by a 32 bit id,
+ * so two types are the same exactly when their ids are, and comparing them is one integer compare.
+ * Pointer types are found through a table indexed by the pointee id, function types through a hash
+ * of their signature.
+ */
+class TypeTable {
+public:
+    static constexpr TypeId ERROR_TYPE = 0;
+    static constexpr TypeId VOID_TYPE = 1;
+    static constexpr TypeId CHAR_TYPE = 2;
+    static constexpr TypeId INT_TYPE = 3;
+
+    TypeTable();
+
+    TypeId pointer_to(TypeId pointee);
+
+    TypeId function(TypeId return_type, std::span<const TypeId> params);
+
+    // the type keyword with its '*'s applied
+    TypeId from_type_name(const TypeName &name);
+
+    TYPE_KIND kind(TypeId type) const { return m_types[type].m_kind; }
+
+    // of a pointer type
+    TypeId pointee(TypeId type) const { return m_types[type].m_inner; }
+
+    // of a function type
+    TypeId return_type(TypeId type) const { return m_types[type].m_inner; }
+
+    std::span<const TypeId> params(TypeId type) const {
+        return {m_params.data() + m_types[type].m_first_param, m_types[type].m_param_count};
+    }
+
+    bool is_integer(TypeId type) const { return kind(type) == TYPE_KIND::INT || kind(type) == TYPE_KIND::CHAR; }
+
+    bool is_scalar(TypeId type) const { return is_integer(type) || kind(type) == TYPE_KIND::POINTER; }
+
+    // C spelling, "char **" or "int (int, char *)"
+    std::string to_string(TypeId type) const;
+
+    size_t size() const { return m_types.size(); }
+
+private:
+    static constexpr TypeId NO_TYPE = UINT32_MAX;
+
+    struct Type {
+        TYPE_KIND m_kind;
+        TypeId m_inner = NO_TYPE; // pointee or return type
+        uint32_t m_first_param = 0;
+        uint32_t m_param_count = 0;
+    };
+
+    TypeId add(Type type);
+
+    std::vector<Type> m_types;
+    std::vector<TypeId> m_params;
+    std::vector<TypeId> m_pointer_to; // indexed by pointee, NO_TYPE until the pointer type is made
+    std::unordered_multimap<uint64_t, TypeId> m_functions; // signature hash -> candidates
+};
@@ -0,0 +1,92 @@
+#include "xxhash.h"
+
+#include <bit>
+#include <cstring>
+
+namespace {
+
+    constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ull;
+    constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ull;
+    constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5ull;
+
+    uint64_t rotate_left(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // unaligned little endian loads, the hash is defined over little endian words
+    uint64_t read_64(const unsigned char *bytes) {
+        uint64_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        if constexpr (std::endian::native == std::endian::big) {
+            value = __builtin_bswap64(value);
+        }
+        return value;
+    }
+
+    uint32_t read_32(const unsigned char *bytes) {
+        uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        if constexpr (std::endian::native == std::endian::big) {
+            value = __builtin_bswap32(value);
+        }
+        return value;
+    }
+
+    uint64_t round(uint64_t accumulator, uint64_t input) {
+        accumulator += input * PRIME_2;
+        return rotate_left(accumulator, 31) * PRIME_1;
+    }
+
+    uint64_t merge_round(uint64_t accumulator, uint64_t value) {
+        accumulator ^= round(0, value);
+        return accumulator * PRIME_1 + PRIME_4;
+    }
+}
+
+uint64_t xxh64(const void *data, size_t length, uint64_t seed) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    const unsigned char *end = bytes + length;
+    uint64_t hash;
+
+    if (length >= 32) {
+        // four independent lanes over 32 byte stripes
+        uint64_t lanes[4] = {seed + PRIME_1 + PRIME_2, seed + PRIME_2, seed, seed - PRIME_1};
+        for (; end - bytes >= 32; bytes += 32) {
+            for (int lane = 0; lane < 4; ++lane) {
+                lanes[lane] = round(lanes[lane], read_64(bytes + lane * 8));
+            }
+        }
+        hash = rotate_left(lanes[0], 1) + rotate_left(lanes[1], 7) + rotate_left(lanes[2], 12) +
+               rotate_left(lanes[3], 18);
+        for (uint64_t lane: lanes) {
+            hash = merge_round(hash, lane);
+        }
+    } else {
+        hash = seed + PRIME_5;
+    }
+    hash += length;
+
+    for (; end - bytes >= 8; bytes += 8) {
+        hash ^= round(0, read_64(bytes));
+        hash = rotate_left(hash, 27) * PRIME_1 + PRIME_4;
+    }
+    if (end - bytes >= 4) {
+        hash ^= read_32(bytes) * PRIME_1;
+        hash = rotate_left(hash, 23) * PRIME_2 + PRIME_3;
+        bytes += 4;
+    }
+    for (; bytes < end; ++bytes) {
+        hash ^= *bytes * PRIME_5;
+        hash = rotate_left(hash, 11) * PRIME_1;
+    }
+
+    // avalanche
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+}
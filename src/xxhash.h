@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// XXH64, fast non cryptographic hash of a byte range, matches the reference implementation's output
+uint64_t xxh64(const void *data, size_t length, uint64_t seed = 0);
+
+inline uint64_t xxh64(std::string_view text, uint64_t seed = 0) {
+    return xxh64(text.data(), text.size(), seed);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "src/parser.hpp"
+#include "src/type_checker.h"
+
+/*
+ * Base of the fixtures testing a pass: runs source through the passes before it, each step expecting
+ * the ones before it to have gone through without errors. The fixtures add only the pass they test.
+ */
+class PipelineTestSetup : public ::testing::Test {
+protected:
+    NodeList &parse(const std::string &source) {
+        tokens = lexer.lex_stream(SourceBuffer::from_string(source));
+        auto it = tokens.begin();
+        declarations = parser.parse_translation_unit(it, tokens.end());
+        EXPECT_TRUE(parser.diagnostics().empty());
+        return declarations;
+    }
+
+    NodeList &resolve(const std::string &source) {
+        parse(source);
+        resolver.resolve(declarations, tokens.source().get());
+        return declarations;
+    }
+
+    NodeList &check(const std::string &source) {
+        resolve(source);
+        EXPECT_TRUE(resolver.diagnostics().empty());
+        checker.check(declarations);
+        return declarations;
+    }
+
+    // checked without errors, what the passes after the type checker start from
+    NodeList &analyze(const std::string &source) {
+        check(source);
+        EXPECT_TRUE(checker.diagnostics().empty());
+        return declarations;
+    }
+
+    static std::vector<std::string> messages(const Diagnostics &diagnostics) {
+        std::vector<std::string> collected;
+        for (const auto &diagnostic: diagnostics) {
+            collected.push_back(diagnostic.m_message);
+        }
+        return collected;
+    }
+
+    // line and column of every diagnostic, {0, 0} for one without a location
+    static std::vector<SourceLocation> locations(const Diagnostics &diagnostics) {
+        std::vector<SourceLocation> collected;
+        for (const auto &diagnostic: diagnostics) {
+            collected.push_back(diagnostic.m_location.value_or(SourceLocation{0, 0}));
+        }
+        return collected;
+    }
+
+    Lexer lexer;
+    TokenStream tokens;
+    Parser parser;
+    NodeList declarations;
+    NameResolver resolver;
+    TypeChecker checker{resolver};
+};
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+#include "src/ast_cache.h"
+#include "src/ast_visitor.h"
+#include "src/parser.hpp"
+#include "src/xxhash.h"
+
+class AstCacheTestSetup : public ::testing::Test {
+protected:
+    void SetUp() override {
+        directory = std::filesystem::temp_directory_path() / ("ast_cache_test_" + std::to_string(::getpid()));
+        std::filesystem::remove_all(directory);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    // lexes and parses source, stores it and hands back the flat AST which went in
+    FlatAst store(const AstCache &cache, const std::string &source) {
+        Lexer lexer;
+        auto tokens = lexer.lex_stream(SourceBuffer::from_string(source));
+        auto it = tokens.begin();
+        FlatAst ast;
+        for (const ASTNode *declaration: parser.parse_translation_unit(it, tokens.end())) {
+            ast.add_tree(declaration);
+        }
+        EXPECT_TRUE(cache.store(source, tokens, ast));
+        stored_tokens = std::move(tokens);
+        return ast;
+    }
+
+    std::filesystem::path directory;
+    Parser parser;
+    TokenStream stored_tokens;
+};
+
+struct CountingVisitor {
+    template<typename Node>
+    void enter(const Node &) { ++m_count; }
+
+    size_t m_count = 0;
+};
+
+TEST(UnitTests, TestXxh64) {
+    // reference implementation outputs
+    ASSERT_EQ(xxh64(""), 0xEF46DB3751D8E999ull);
+    ASSERT_EQ(xxh64("a"), 0xD24EC4F1A98C6E5Bull);
+    ASSERT_EQ(xxh64("abc"), 0x44BC2CF5AD770999ull);
+    ASSERT_EQ(xxh64("Nobody inspects the spammish repetition"), 0xFBCEA83C8A378BF1ull);
+}
+
+TEST_F(AstCacheTestSetup, TestRoundTrip) {
+    std::string source = "int get(int a, char **b) { while (a) { a = a - 1; if (b) break; } return b[a]; }\n"
+                         "char *name(int);\n"
+                         "int main() { print(\"text\", 'c', get(1, 0)); return 0; }\n";
+    AstCache cache(directory);
+    FlatAst ast = store(cache, source);
+    auto mapped = cache.load(source);
+    ASSERT_NE(mapped, nullptr);
+
+    ASSERT_EQ(mapped->size(), ast.size());
+    ASSERT_EQ(mapped->offset(mapped->roots()[2]), source.find("main"));
+    ASSERT_TRUE(std::equal(ast.roots().begin(), ast.roots().end(), mapped->roots().begin(), mapped->roots().end()));
+    for (NodeId id = 0; id < ast.size(); ++id) {
+        ASSERT_EQ(mapped->kind(id), ast.kind(id));
+        ASSERT_EQ(mapped->token(id), ast.token(id));
+        ASSERT_EQ(mapped->offset(id), ast.offset(id));
+        ASSERT_EQ(mapped->child_count(id), ast.child_count(id));
+        for (uint32_t index = 0; index < ast.child_count(id); ++index) {
+            ASSERT_EQ(mapped->child(id, index), ast.child(id, index));
+        }
+        ASSERT_EQ(mapped->extra_count(id), ast.extra_count(id));
+        for (uint32_t index = 0; index < ast.extra_count(id); ++index) {
+            ASSERT_EQ(mapped->extra(id, index), ast.extra(id, index));
+        }
+    }
+
+    ASSERT_EQ(mapped->stream_size(), stored_tokens.size());
+    for (size_t index = 0; index < stored_tokens.size(); ++index) {
+        ASSERT_EQ(mapped->stream_kind(index), stored_tokens.kind(index));
+        ASSERT_EQ(mapped->stream_offset(index), stored_tokens.offset(index));
+        ASSERT_EQ(mapped->stream_length(index), stored_tokens.length(index));
+        ASSERT_EQ(mapped->stream_partner(index), stored_tokens.partner(index));
+        ASSERT_EQ(mapped->stream_token(index), Token(stored_tokens[index]));
+    }
+
+    // node handles and walks work on the mapped tree as they are
+    CountingVisitor visitor;
+    walk(*mapped, visitor);
+    ASSERT_EQ(visitor.m_count, ast.size());
+    ASSERT_EQ(FlatNode(*mapped, mapped->roots()[1]).extra(0), (TypeName{Token(TOKEN_TYPE::CHAR, "char"), 1}));
+}
+
+TEST_F(AstCacheTestSetup, TestMisses) {
+    AstCache cache(directory);
+    ASSERT_EQ(cache.load("int x;"), nullptr);
+    store(cache, "int x;");
+    ASSERT_NE(cache.load("int x;"), nullptr);
+    ASSERT_EQ(cache.load("int y;"), nullptr);
+    ASSERT_NE(AstCache::key("int x;"), AstCache::key("int y;"));
+
+    // a truncated entry isn't mapped
+    auto path = cache.entry_path(AstCache::key("int x;"));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    ASSERT_EQ(cache.load("int x;"), nullptr);
+
+    // an entry found under another source's key isn't either
+    store(cache, "int x;");
+    std::filesystem::copy_file(cache.entry_path(AstCache::key("int x;")), cache.entry_path(AstCache::key("int w;")));
+    ASSERT_EQ(cache.load("int w;"), nullptr);
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "src/constant_folder.h"
+#include "tests/pipeline.h"
+
+constexpr auto CODE_FILE = "../../tests/hello_world.c";
+
+class ConstantFolderTestSetup : public PipelineTestSetup {
+protected:
+    // the statements of the last function in source once folded
+    const NodeList &fold(const std::string &source) {
+        analyze(source);
+        folder.fold(declarations, tokens.source().get());
+        return std::get<Block>(std::get<FuncDeclaration>(declarations.back()->m_members).body->m_members).statements;
+    }
+
+    // fully parenthesized expression
+    static std::string render(const ASTNode *node) {
+        switch (node_kind(*node)) {
+            case NODE_KIND::BINARY_OPERATION: {
+                const auto &operation = std::get<BinaryOperation>(node->m_members);
+                return "(" + render(operation.lhs) + " " + std::string(token_symbol(node->m_token.m_type).text()) +
+                       " " + render(operation.rhs) + ")";
+            }
+            case NODE_KIND::UNARY_OPERATION:
+                return std::string(node->m_token.m_type == TOKEN_TYPE::SUB ? "-" : "!") +
+                       render(std::get<UnaryOperation>(node->m_members).operand);
+            case NODE_KIND::FUNC_CALL:
+                return std::string(std::get<Symbol>(node->m_token.m_value).text()) + "()";
+            default:
+                if (node->m_token.m_type == TOKEN_TYPE::INTEGER) {
+                    return std::to_string(std::get<int>(node->m_token.m_value));
+                }
+                return std::string(std::get<Symbol>(node->m_token.m_value).text());
+        }
+    }
+
+    // the right hand side of the assignment statement
+    static std::string assigned(const ASTNode *statement) {
+        return render(std::get<BinaryOperation>(statement->m_members).rhs);
+    }
+
+    ConstantFolder folder;
+};
+
+TEST_F(ConstantFolderTestSetup, TestArithmetic) {
+    const auto &body = fold("void f(int a) {\n"
+                            "  a = 1+0-0*0%2;\n"
+                            "  a = -7 / 2 + -7 % 2 * 10;\n"
+                            "  a = 2147483647 + 1;\n"
+                            "  a = -2147483647 - 1 / -1;\n"
+                            "  a = (-2147483647 - 1) / -1;\n"
+                            "  a = 'a' + 1;\n"
+                            "  a = (3 < 4) + (4 <= 3) * 2 + (5 == 5) * 4 + (1 && 0) * 8 + (0 || 2) * 16 + !7 * 32;\n"
+                            "  a = 6 & 3 | 8;\n"
+                            "}\n");
+    ASSERT_TRUE(folder.diagnostics().empty());
+    ASSERT_EQ(assigned(body[0]), "1");
+    ASSERT_EQ(assigned(body[1]), "-13");
+    ASSERT_EQ(assigned(body[2]), "-2147483648");
+    ASSERT_EQ(assigned(body[3]), "-2147483646");
+    ASSERT_EQ(assigned(body[4]), "-2147483648");
+    ASSERT_EQ(assigned(body[5]), "98");
+    ASSERT_EQ(assigned(body[6]), "21");
+    ASSERT_EQ(assigned(body[7]), "10");
+    // the folded operation is the same node, so it keeps its type
+    ASSERT_EQ(checker.type_of(std::get<BinaryOperation>(body[0]->m_members).rhs), TypeTable::INT_TYPE);
+}
+
+TEST_F(ConstantFolderTestSetup, TestIdentities) {
+    const auto &body = fold("int g(void);\n"
+                            "void f(int a, int *p) {\n"
+                            "  a = a * 1 + 0;\n"
+                            "  a = 1 * (0 + a) - 0;\n"
+                            "  a = a / 1 | 0;\n"
+                            "  a = a & -1;\n"
+                            "  a = a * 0;\n"
+                            "  a = 0 & a;\n"
+                            "  a = a % 1;\n"
+                            "  a = a || 3;\n"
+                            "  a = 0 && g();\n"
+                            "  a = g() * 0;\n"
+                            "  a = (a = 2) & 0;\n"
+                            "  a = p[0 * a] + 0;\n"
+                            "}\n");
+    ASSERT_TRUE(folder.diagnostics().empty());
+    ASSERT_EQ(assigned(body[0]), "a");
+    ASSERT_EQ(assigned(body[1]), "a");
+    ASSERT_EQ(assigned(body[2]), "a");
+    ASSERT_EQ(assigned(body[3]), "a");
+    ASSERT_EQ(assigned(body[4]), "0");
+    ASSERT_EQ(assigned(body[5]), "0");
+    ASSERT_EQ(assigned(body[6]), "0");
+    ASSERT_EQ(assigned(body[7]), "1");
+    ASSERT_EQ(assigned(body[8]), "0");
+    // side effects stay
+    ASSERT_EQ(assigned(body[9]), "(g() * 0)");
+    ASSERT_EQ(assigned(body[10]), "((a = 2) & 0)");
+    ASSERT_EQ(assigned(body[11]), "(p [ 0)");
+
+    // the kept operand is still the node the resolver bound
+    const ASTNode *kept = std::get<BinaryOperation>(body[0]->m_members).rhs;
+    ASSERT_NE(resolver.declaration_of(kept), nullptr);
+}
+
+TEST_F(ConstantFolderTestSetup, TestCanonicalOrder) {
+    const auto &body = fold("void f(int a) {\n"
+                            "  a = 8 * a;\n"
+                            "  a = (a + 1) + 2;\n"
+                            "  a = 2 * (4 * a);\n"
+                            "  a = (a - 1) + 2;\n"
+                            "  a = 0 == a;\n"
+                            "  a = 1 - a;\n"
+                            "}\n");
+    ASSERT_EQ(assigned(body[0]), "(a * 8)");
+    ASSERT_EQ(assigned(body[1]), "(a + 3)");
+    ASSERT_EQ(assigned(body[2]), "(a * 8)");
+    ASSERT_EQ(assigned(body[3]), "((a - 1) + 2)");
+    ASSERT_EQ(assigned(body[4]), "(a == 0)");
+    ASSERT_EQ(assigned(body[5]), "(1 - a)");
+}
+
+TEST_F(ConstantFolderTestSetup, TestDivisionByZero) {
+    const auto &body = fold("void f(int a) {\n"
+                            "  a = 1 / (2 - 2);\n"
+                            "  a = 5 % 0 + 1;\n"
+                            "  a = a / 0;\n"
+                            "}\n");
+    ASSERT_EQ(folder.diagnostics().size(), 2);
+    ASSERT_EQ(folder.diagnostics()[0].m_message, std::string(DIVISION_BY_ZERO) + "1 / 0");
+    ASSERT_EQ(folder.diagnostics()[1].m_message, std::string(DIVISION_BY_ZERO) + "5 % 0");
+    ASSERT_EQ(locations(folder.diagnostics()), (std::vector<SourceLocation>{{2, 9}, {3, 9}}));
+    ASSERT_EQ(assigned(body[0]), "(1 / 0)");
+    ASSERT_EQ(assigned(body[1]), "((5 % 0) + 1)");
+    ASSERT_EQ(assigned(body[2]), "(a / 0)");
+}
+
+TEST_F(ConstantFolderTestSetup, TestDivisionByZeroNotEvaluated) {
+    // short-circuiting skips the division, only one that can run is an error
+    const auto &body = fold("void f(int a) {\n"
+                            "  a = 0 && 1 / 0;\n"
+                            "  a = (2 - 1 || a % 0) + 1;\n"
+                            "  a = 1 && (0 || 4 / 0);\n"
+                            "}\n");
+    ASSERT_EQ(folder.diagnostics().size(), 1);
+    ASSERT_EQ(folder.diagnostics()[0].m_message, std::string(DIVISION_BY_ZERO) + "4 / 0");
+    ASSERT_EQ(assigned(body[0]), "0");
+    ASSERT_EQ(assigned(body[1]), "2");
+    ASSERT_EQ(assigned(body[2]), "(1 && (0 || (4 / 0)))");
+}
+
+TEST_F(ConstantFolderTestSetup, TestDeepNesting) {
+    // a 100000 deep chain of additions folds without recursion
+    std::string expression = "1";
+    for (int index = 0; index < 100000; ++index) {
+        expression += " + 1";
+    }
+    const auto &body = fold("void f(int a) { a = " + expression + "; }\n");
+    ASSERT_EQ(assigned(body[0]), "100001");
+}
+
+TEST_F(ConstantFolderTestSetup, TestHelloWorld) {
+    auto source = SourceBuffer::from_file(CODE_FILE);
+    fold(std::string(source->view()));
+    ASSERT_TRUE(folder.diagnostics().empty());
+    const auto &get_two = std::get<Block>(std::get<FuncDeclaration>(declarations[0]->m_members).body->m_members).statements;
+    ASSERT_EQ(assigned(get_two[0]), "1");
+    ASSERT_EQ(assigned(get_two[1]), "(b [ 0)");
+    ASSERT_EQ(assigned(get_two[2]), "((a < a) > 0)");
+}
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "src/dataflow.h"
+#include "src/ir_builder.h"
+#include "tests/pipeline.h"
+
+TEST(BitVectorTest, TestSetOperations) {
+    // sizes straddling word boundaries, the unused bits of the last word stay clear
+    BitVector first(130);
+    BitVector second(130);
+    first.set(0);
+    first.set(64);
+    first.set(129);
+    second.set(64);
+    second.set(100);
+    ASSERT_EQ(first.count(), 3);
+    ASSERT_TRUE(first.test(129));
+    ASSERT_FALSE(first.test(128));
+
+    BitVector both = first;
+    ASSERT_TRUE(both.intersect(second));
+    ASSERT_FALSE(both.intersect(second));
+    ASSERT_EQ(both.count(), 1);
+    ASSERT_TRUE(both.test(64));
+
+    BitVector either = first;
+    ASSERT_TRUE(either.unite(second));
+    ASSERT_FALSE(either.unite(first));
+    ASSERT_EQ(either.count(), 4);
+
+    ASSERT_TRUE(either.subtract(first));
+    ASSERT_FALSE(either.subtract(first));
+    ASSERT_EQ(either.count(), 1);
+    ASSERT_TRUE(either.test(100));
+    ASSERT_TRUE(either.subtract(second));
+    ASSERT_TRUE(either.empty());
+
+    BitVector full(130, true);
+    ASSERT_EQ(full.count(), 130);
+    ASSERT_EQ(full.words()[2], 0b11);
+
+    BitVector range(200);
+    range.set_range(3, 3);
+    ASSERT_TRUE(range.empty());
+    range.set_range(60, 190);
+    range.set_range(5, 7);
+    ASSERT_EQ(range.count(), 132);
+    BitVector cleared = range;
+    cleared.reset_range(62, 189);
+    cleared.reset_range(5, 6);
+    ASSERT_EQ(cleared.count(), 4);
+    ASSERT_TRUE(cleared.test(6));
+    ASSERT_TRUE(cleared.test(61));
+    ASSERT_FALSE(cleared.test(62));
+    ASSERT_TRUE(cleared.test(189));
+
+    std::vector<size_t> members;
+    range.for_each([&members](size_t index) { members.push_back(index); });
+    ASSERT_EQ(members.size(), 132);
+    ASSERT_EQ(members[0], 5);
+    ASSERT_EQ(members[2], 60);
+    ASSERT_EQ(members.back(), 189);
+    ASSERT_EQ(range.find_next(7), 60);
+    ASSERT_EQ(range.find_next(189), 189);
+    ASSERT_EQ(range.find_next(190), 200);
+}
+
+class DataflowTestSetup : public PipelineTestSetup {
+protected:
+    IrFunction lower(const std::string &source) {
+        auto functions = builder.lower(analyze(source));
+        return std::move(functions.back());
+    }
+
+    // the values live into (or out of) each block
+    static std::vector<std::vector<ValueId>> values(const Liveness &liveness, const std::vector<BitVector> &sets) {
+        std::vector<std::vector<ValueId>> blocks;
+        for (const BitVector &set: sets) {
+            std::vector<ValueId> live;
+            set.for_each([&](size_t bit) { live.push_back(liveness.m_values[bit]); });
+            std::sort(live.begin(), live.end());
+            blocks.push_back(live);
+        }
+        return blocks;
+    }
+
+    IrBuilder builder{resolver, checker};
+};
+
+TEST_F(DataflowTestSetup, TestReachingDefinitions) {
+    IrFunction function = lower("int g;\n"
+                                "int f(int a, int *p) {\n"
+                                "  int x = 1;\n"
+                                "  int *q = &x;\n"
+                                "  if (a) { x = 2; g = 3; } else { g = 4; *p = 5; }\n"
+                                "  while (a) { g = a; a = a - 1; }\n"
+                                "  return x + g;\n"
+                                "}\n");
+    ReachingDefinitions reaching = reaching_definitions(function);
+    // grouped by location: the stores to x, to g, then the one through p
+    ASSERT_EQ(reaching.m_definitions, (std::vector<ValueId>{4, 7, 10, 14, 22, 16}));
+    auto stores = [&reaching](const BitVector &set) {
+        std::vector<ValueId> reached;
+        set.for_each([&](size_t bit) { reached.push_back(reaching.m_definitions[bit]); });
+        std::sort(reached.begin(), reached.end());
+        return reached;
+    };
+    // x = 2 replaces x = 1 on one side only, *p = 5 kills nothing
+    ASSERT_EQ(stores(reaching.m_out[1]), (std::vector<ValueId>{7, 10}));
+    ASSERT_EQ(stores(reaching.m_out[2]), (std::vector<ValueId>{4, 14, 16}));
+    ASSERT_EQ(stores(reaching.m_in[3]), (std::vector<ValueId>{4, 7, 10, 14, 16}));
+    // g = a flows around the loop
+    ASSERT_EQ(stores(reaching.m_in[5]), (std::vector<ValueId>{4, 7, 10, 14, 16, 22}));
+    ASSERT_EQ(stores(reaching.m_out[5]), (std::vector<ValueId>{4, 7, 16, 22}));
+    ASSERT_EQ(stores(reaching.m_in[6]), (std::vector<ValueId>{4, 7, 10, 14, 16, 22}));
+}
+
+TEST_F(DataflowTestSetup, TestLiveness) {
+    IrFunction function = lower("int h(int a, int b) {\n"
+                                "  while (a < b) {\n"
+                                "    if (a == 3) break;\n"
+                                "    a = a + 1;\n"
+                                "  }\n"
+                                "  return a && b;\n"
+                                "}\n");
+    // the function of IrControlFlowTestSetup.TestPhis: %3 is the loop header's phi of a, b is %1,
+    // %13 the incremented a and %9, %16 the operands of the && phi
+    Liveness liveness = live_values(function);
+    ASSERT_EQ(values(liveness, liveness.m_live_in), (std::vector<std::vector<ValueId>>{
+            {}, {1}, {1, 3}, {1, 3}, {1, 3}, {1, 3}, {1}, {}}));
+    // a phi operand is live out of its predecessor only
+    ASSERT_EQ(values(liveness, liveness.m_live_out), (std::vector<std::vector<ValueId>>{
+            {0, 1}, {1, 3}, {1, 3}, {1, 9}, {1, 3}, {1, 13}, {16}, {}}));
+    ASSERT_TRUE(liveness.live_out(5, 13));
+    ASSERT_FALSE(liveness.live_in(5, 13));
+    ASSERT_FALSE(liveness.live_in(1, 4)); // used in its own block only, never tracked
+}
+
+TEST_F(DataflowTestSetup, TestIntersectionMeet) {
+    // the blocks every path from the entry passes through are the dominators
+    IrFunction function = lower("int h(int a, int b) {\n"
+                                "  while (a < b) {\n"
+                                "    if (a == 3) break;\n"
+                                "    a = a + 1;\n"
+                                "  }\n"
+                                "  return a && b;\n"
+                                "}\n");
+    size_t blocks = function.block_count();
+    DataflowProblem problem{DIRECTION::FORWARD, MEET::INTERSECTION, blocks,
+                            std::vector<std::vector<BitRange>>(blocks),
+                            std::vector<std::vector<BitRange>>(blocks),
+                            BitVector(blocks)};
+    for (BlockId block = 0; block < blocks; ++block) {
+        problem.m_gen[block].push_back({block, block + 1});
+    }
+    DataflowSolution solution = solve(function, problem);
+
+    std::vector<BlockId> dominators = immediate_dominators(function);
+    for (BlockId block = 0; block < blocks; ++block) {
+        BitVector expected(blocks);
+        for (BlockId dominator = block; ; dominator = dominators[dominator]) {
+            expected.set(dominator);
+            if (dominator == 0) {
+                break;
+            }
+        }
+        ASSERT_EQ(solution.m_out[block], expected) << "bb" << block;
+    }
+}
+
+TEST_F(DataflowTestSetup, TestLargeFunction) {
+    // a reverse postorder sweep settles each block after a couple of visits whatever the size
+    std::string source = "int f(int a, int b) {\n  int i = 0;\n  int *p = &i;\n  while (i < b) {\n";
+    for (int statement = 0; statement < 2000; ++statement) {
+        source += "    if (a > " + std::to_string(statement) + ") { a = a - b * 3; i = a; } else { b = b + a; }\n";
+    }
+    source += "    i = i + 1;\n  }\n  return a + b;\n}\n";
+    IrFunction function = lower(source);
+    ASSERT_EQ(function.block_count(), 3 * 2000 + 4);
+
+    Liveness liveness = live_values(function);
+    ASSERT_LE(liveness.m_visits, 3 * function.block_count());
+    ReachingDefinitions reaching = reaching_definitions(function);
+    ASSERT_EQ(reaching.m_definitions.size(), 2000 + 2);
+    ASSERT_LE(reaching.m_visits, 3 * function.block_count());
+    // every store to i reaches the loop's exit
+    ASSERT_EQ(reaching.m_in[function.block_count() - 1].count(), 2000 + 2);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "src/parser.hpp"
+#include "src/ast_visitor.h"
+
+// records what it walks over, depth included, so two walks can be compared
+struct RecordingVisitor {
+    template<typename Node>
+    void enter(const Node &node) {
+        std::vector<TypeName> extras;
+        for (uint32_t index = 0; index < node.extra_count(); ++index) {
+            extras.push_back(node.extra(index));
+        }
+        m_visited.emplace_back(m_depth++, node.kind(), node.token(), node.child_count(), extras);
+    }
+
+    template<typename Node>
+    void leave(const Node &) {
+        --m_depth;
+    }
+
+    int m_depth = 0;
+    std::vector<std::tuple<int, NODE_KIND, Token, uint32_t, std::vector<TypeName>>> m_visited;
+};
+
+TEST(UnitTests, TestFlatAstMatchesTree) {
+    Lexer lexer;
+    auto stream = lexer.lex_stream(SourceBuffer::from_string(
+            "a = f(1 + b * 2, 'c', \"str\", g());\n"
+            "int declared_function(int, char);\n"
+            "int x;\n"
+            "b = a - 4 % c;\n"
+            "{ char **p; while (a) { if (b) break; else if (c) continue; } }\n"));
+    Parser parser;
+    auto it = stream.begin();
+    auto statements = parser.parse_statements(it, stream.end());
+    ASSERT_TRUE(parser.diagnostics().empty());
+    ASSERT_EQ(statements.size(), 5);
+
+    FlatAst ast;
+    RecordingVisitor tree_visitor;
+    for (const ASTNode *statement: statements) {
+        ast.add_tree(statement);
+        walk(TreeNode(statement), tree_visitor);
+    }
+    RecordingVisitor flat_visitor;
+    walk(ast, flat_visitor);
+
+    ASSERT_EQ(ast.roots().size(), statements.size());
+    ASSERT_EQ(ast.size(), tree_visitor.m_visited.size());
+    ASSERT_EQ(tree_visitor.m_visited, flat_visitor.m_visited);
+
+    // pre-order numbering: walking ids in order meets the same nodes as the walk
+    for (NodeId id = 0; id < ast.size(); ++id) {
+        ASSERT_EQ(ast.kind(id), std::get<1>(flat_visitor.m_visited[id]));
+        ASSERT_EQ(ast.token(id), std::get<2>(flat_visitor.m_visited[id]));
+    }
+
+    auto declaration = FlatNode(ast, ast.roots()[1]);
+    ASSERT_EQ(declaration.kind(), NODE_KIND::FUNC_DECLARATION);
+    ASSERT_EQ(declaration.extra_count(), 1);
+    ASSERT_EQ(declaration.child_count(), 2);
+    ASSERT_EQ(declaration.child(1).extra(0), TypeName{Token(TOKEN_TYPE::CHAR, "char")});
+}
+
+TEST(UnitTests, TestWalkDeepNesting) {
+    // far deeper than the call stack would allow if walking recursed
+    constexpr int depth = 100000;
+    std::string source;
+    for (int level = 0; level < depth; ++level) {
+        source += "{ ";
+    }
+    source += "a = -1;";
+    for (int level = 0; level < depth; ++level) {
+        source += " }";
+    }
+    Lexer lexer;
+    auto stream = lexer.lex_stream(SourceBuffer::from_string(source));
+    Parser parser;
+    auto it = stream.begin();
+    auto statements = parser.parse_statements(it, stream.end());
+    ASSERT_TRUE(parser.diagnostics().empty());
+
+    FlatAst ast;
+    ast.add_tree(statements[0]);
+    RecordingVisitor tree_visitor;
+    walk(TreeNode(statements[0]), tree_visitor);
+    RecordingVisitor flat_visitor;
+    walk(ast, flat_visitor);
+    ASSERT_EQ(tree_visitor.m_visited.size(), depth + 4);
+    ASSERT_EQ(std::get<0>(tree_visitor.m_visited.back()), depth + 2); // the 1 under - under =
+    ASSERT_EQ(tree_visitor.m_depth, 0);
+    ASSERT_EQ(tree_visitor.m_visited, flat_visitor.m_visited);
+}
@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "src/interner.h"
+#include "src/lexer.h"
+
+TEST(UnitTests, TestInternerStableIds) {
+    Interner interner;
+    auto first = interner.intern("my_identifier");
+    auto second = interner.intern(std::string("my_") + "identifier");
+
+    ASSERT_EQ(first, second);
+    ASSERT_NE(first, interner.intern("other_identifier"));
+    ASSERT_EQ(interner.spelling(first), "my_identifier");
+    ASSERT_EQ(interner.intern(""), 0);
+}
+
+TEST(UnitTests, TestInternerGrowth) {
+    // enough spellings to rehash the table and fill several arena blocks
+    Interner interner;
+    std::vector<uint32_t> ids;
+    for (int i = 0; i < 100000; ++i) {
+        ids.push_back(interner.intern("identifier_" + std::to_string(i)));
+    }
+    for (int i = 0; i < 100000; ++i) {
+        ASSERT_EQ(interner.intern("identifier_" + std::to_string(i)), ids[i]);
+        ASSERT_EQ(interner.spelling(ids[i]), "identifier_" + std::to_string(i));
+    }
+    ASSERT_EQ(interner.size(), 100001); // including the empty spelling
+}
+
+TEST(UnitTests, TestLexerHandsOutSymbols) {
+    Lexer lexer;
+    auto tokens = lexer.lex(SourceBuffer::from_string("abc = abc + \"abc\";"));
+
+    auto identifier = std::get<Symbol>((*tokens)[0].m_value);
+    ASSERT_EQ(identifier, std::get<Symbol>((*tokens)[2].m_value));
+    ASSERT_EQ(identifier, std::get<Symbol>((*tokens)[4].m_value)); // string literal with the same spelling
+    ASSERT_EQ(identifier.text(), "abc");
+    ASSERT_EQ(std::get<Symbol>((*tokens)[1].m_value), token_symbol(TOKEN_TYPE::ASSIGN));
+}
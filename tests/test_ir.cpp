@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include "src/ir_builder.h"
+#include "src/ir_verifier.h"
+#include "tests/pipeline.h"
+
+constexpr auto CODE_FILE = "../../tests/hello_world.c";
+
+class IrTestSetup : public PipelineTestSetup {
+protected:
+    std::vector<IrFunction> lower(const std::string &source) {
+        auto functions = builder.lower(analyze(source));
+        for (const IrFunction &function: functions) {
+            EXPECT_TRUE(verifier.verify(function)) << verifier.diagnostics()[0].m_message << "\n"
+                                                   << dump(function, checker.types());
+        }
+        return functions;
+    }
+
+    IrBuilder builder{resolver, checker};
+    IrVerifier verifier;
+};
+
+TEST_F(IrTestSetup, TestMemoryAndCalls) {
+    auto functions = lower("int g;\n"
+                           "char *print(char *);\n"
+                           "int f(int *p, char c) {\n"
+                           "  int x = 1;\n"
+                           "  int *q = &x;\n"
+                           "  *q = c;\n"
+                           "  p[2] = x + g;\n"
+                           "  g = p - q;\n"
+                           "  print(\"hi\");\n"
+                           "  return -c;\n"
+                           "}\n");
+    ASSERT_EQ(functions.size(), 1);
+    // x has its address taken and lives in a slot, q stays a value
+    ASSERT_EQ(dump(functions[0], checker.types()), "function f: int (int *, char)\n"
+                                                   "bb0:\n"
+                                                   "    %0 = param int * 0\n"
+                                                   "    %1 = param char 1\n"
+                                                   "    %2 = local int *\n"
+                                                   "    %3 = const int 1\n"
+                                                   "    store %2, %3\n"
+                                                   "    %5 = convert int %1\n"
+                                                   "    store %2, %5\n"
+                                                   "    %7 = const int 2\n"
+                                                   "    %8 = element int * %0, %7\n"
+                                                   "    %9 = load int %2\n"
+                                                   "    %10 = global int * @g\n"
+                                                   "    %11 = load int %10\n"
+                                                   "    %12 = add int %9, %11\n"
+                                                   "    store %8, %12\n"
+                                                   "    %14 = global int * @g\n"
+                                                   "    %15 = sub int %0, %2\n"
+                                                   "    %16 = const int 4\n"
+                                                   "    %17 = div int %15, %16\n"
+                                                   "    store %14, %17\n"
+                                                   "    %19 = string char * \"hi\"\n"
+                                                   "    %20 = call char * print(%19)\n"
+                                                   "    %21 = convert int %1\n"
+                                                   "    %22 = neg int %21\n"
+                                                   "    return %22\n");
+}
+
+class IrControlFlowTestSetup : public IrTestSetup {
+protected:
+    IrFunction lower_loop() {
+        return std::move(lower("int h(int a, int b) {\n"
+                               "  while (a < b) {\n"
+                               "    if (a == 3) break;\n"
+                               "    a = a + 1;\n"
+                               "  }\n"
+                               "  return a && b;\n"
+                               "}\n")[0]);
+    }
+};
+
+TEST_F(IrControlFlowTestSetup, TestPhis) {
+    IrFunction function = lower_loop();
+    // the loop header merges a, the exit doesn't need to: both ways out see the header's value
+    ASSERT_EQ(dump(function, checker.types()), "function h: int (int, int)\n"
+                                               "bb0:\n"
+                                               "    %0 = param int 0\n"
+                                               "    %1 = param int 1\n"
+                                               "    jump bb1\n"
+                                               "bb1: ; preds bb0, bb5\n"
+                                               "    %3 = phi int [%0, bb0], [%13, bb5]\n"
+                                               "    %4 = less int %3, %1\n"
+                                               "    branch %4, bb2, bb3\n"
+                                               "bb2: ; preds bb1\n"
+                                               "    %6 = const int 3\n"
+                                               "    %7 = eq int %3, %6\n"
+                                               "    branch %7, bb4, bb5\n"
+                                               "bb3: ; preds bb1, bb4\n"
+                                               "    %9 = const int 0\n"
+                                               "    branch %3, bb6, bb7\n"
+                                               "bb4: ; preds bb2\n"
+                                               "    jump bb3\n"
+                                               "bb5: ; preds bb2\n"
+                                               "    %12 = const int 1\n"
+                                               "    %13 = add int %3, %12\n"
+                                               "    jump bb1\n"
+                                               "bb6: ; preds bb3\n"
+                                               "    %15 = const int 0\n"
+                                               "    %16 = neq int %1, %15\n"
+                                               "    jump bb7\n"
+                                               "bb7: ; preds bb3, bb6\n"
+                                               "    %18 = phi int [%9, bb3], [%16, bb6]\n"
+                                               "    return %18\n");
+
+    std::vector<BlockId> order = {0, 1, 2, 5, 4, 3, 6, 7};
+    ASSERT_EQ(reverse_postorder(function), order);
+    std::vector<BlockId> dominators = {0, 0, 1, 1, 2, 2, 3, 3};
+    ASSERT_EQ(immediate_dominators(function), dominators);
+}
+
+TEST_F(IrControlFlowTestSetup, TestVerifierFindsBrokenInvariants) {
+    IrFunction function = lower_loop();
+    auto messages = [this](const IrFunction &broken) {
+        IrVerifier checking;
+        EXPECT_FALSE(checking.verify(broken));
+        std::vector<std::string> collected;
+        for (const auto &diagnostic: checking.diagnostics()) {
+            collected.push_back(diagnostic.m_message);
+        }
+        return collected;
+    };
+
+    IrFunction broken = function;
+    broken.m_operands[broken.instruction(4).m_first_operand] = 13; // less %13, %1 in the header
+    ASSERT_EQ(messages(broken), std::vector<std::string>{"in h: " + std::string(NOT_DOMINATED) + "%13 used by %4"});
+
+    broken = function;
+    broken.m_instructions[17].m_opcode = OPCODE::CONST; // bb6 falls off its end
+    ASSERT_EQ(messages(broken), std::vector<std::string>{"in h: " + std::string(MISSING_TERMINATOR) + "bb6"});
+
+    broken = function;
+    broken.m_instructions[18].m_operand_count = 1;
+    ASSERT_EQ(messages(broken), std::vector<std::string>{"in h: " + std::string(OPERAND_COUNT) + "%18"});
+
+    broken = function;
+    broken.m_blocks[7].m_predecessors.push_back(2);
+    ASSERT_EQ(messages(broken), (std::vector<std::string>{"in h: " + std::string(OPERAND_COUNT) + "%18",
+                                                          "in h: " + std::string(EDGE_MISMATCH) + "bb2 -> bb7"}));
+
+    broken = function;
+    broken.m_operands[broken.instruction(13).m_first_operand + 1] = 11; // the jump of bb4
+    ASSERT_EQ(messages(broken), std::vector<std::string>{"in h: " + std::string(INVALID_OPERAND_VALUE) + "%13"});
+}
+
+TEST_F(IrTestSetup, TestHelloWorld) {
+    auto source = SourceBuffer::from_file(CODE_FILE);
+    auto functions = lower(std::string(source->view()));
+    ASSERT_EQ(functions.size(), 2);
+    ASSERT_EQ(functions[0].m_name, Symbol("get_two"));
+    ASSERT_EQ(functions[1].m_name, Symbol("main"));
+}
+
+TEST_F(IrTestSetup, TestLargeFunction) {
+    // a function of well over 100k instructions lowers and verifies in linear time
+    std::string source = "int f(int a, int b) {\n  int i = 0;\n  while (i < b) {\n";
+    for (int statement = 0; statement < 10000; ++statement) {
+        source += "    if (a > " + std::to_string(statement) + ") { a = a - b * 3; } else { b = b + a; }\n";
+    }
+    source += "    i = i + 1;\n  }\n  return a + b;\n}\n";
+    auto functions = lower(source);
+    ASSERT_GT(functions[0].size(), 100000);
+    ASSERT_EQ(functions[0].block_count(), 3 * 10000 + 4);
+}
+
+TEST_F(IrTestSetup, TestDeepNesting) {
+    // far deeper than the call stack would allow if lowering recursed
+    constexpr int depth = 100000;
+    std::string source = "int f(int a, int b) ";
+    for (int level = 0; level < depth; ++level) {
+        source += "{ while (a) if (b) ";
+    }
+    source += "a = a - 1;";
+    for (int level = 0; level < depth; ++level) {
+        source += " }";
+    }
+    auto functions = lower(source);
+    ASSERT_EQ(functions.size(), 1);
+}
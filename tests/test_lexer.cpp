@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 #include <string>
 #include <array>
+#include <random>
+#include <tuple>
+#include <fstream>
+#include <iterator>
 #include "src/lexer.h"
 
 constexpr auto CODE_FILE = "../../tests/hello_world.c";
@@ -50,3 +54,255 @@ TEST(UnitTests, TestHelloWorld) {
     }
 
 }
+
+TEST(UnitTests, TestMappedSourceMatchesStream) {
+    std::ifstream input_file(CODE_FILE);
+
+    Lexer stream_lexer;
+    Lexer mapped_lexer;
+    try {
+        auto stream_tokens = stream_lexer.lex(input_file);
+        auto mapped_tokens = mapped_lexer.lex_file(CODE_FILE);
+
+        ASSERT_EQ(*stream_tokens, *mapped_tokens);
+        ASSERT_NE(mapped_lexer.source(), nullptr);
+    }
+    catch (CompilerException &exc) {
+        GTEST_FATAL_FAILURE_(exc.what());
+    }
+}
+
+TEST(UnitTests, TestTokenAtEndOfSource) {
+    // last line without a trailing newline or terminator
+    Lexer lexer;
+    auto tokens = lexer.lex(SourceBuffer::from_string("return value"));
+
+    ASSERT_EQ(tokens->size(), 2);
+    ASSERT_EQ((*tokens)[0], Token(TOKEN_TYPE::RETURN, "return"));
+    ASSERT_EQ((*tokens)[1], Token(TOKEN_TYPE::IDENTIFIER, "value"));
+
+    tokens = lexer.lex(SourceBuffer::from_string("a = 42"));
+    ASSERT_EQ(tokens->back(), Token(TOKEN_TYPE::INTEGER, 42));
+}
+
+TEST(UnitTests, TestTokenStreamMatchesTokens) {
+    auto source = SourceBuffer::from_file(CODE_FILE);
+
+    Lexer lexer;
+    auto tokens = lexer.lex(source);
+    auto stream = lexer.lex_stream(source);
+
+    ASSERT_EQ(stream.size(), tokens->size());
+    for (size_t i = 0; i < stream.size(); ++i) {
+        ASSERT_EQ(stream[i], (*tokens)[i]);
+        // offsets point back at the token in the source
+        ASSERT_EQ(source->view().substr(stream.offset(i), stream.length(i)), stream.lexeme(i));
+    }
+    ASSERT_EQ(stream.to_tokens(), *tokens);
+}
+
+TEST(UnitTests, TestConstexprTokenTables) {
+    for (const auto &[spelling, type]: KEYWORDS) {
+        ASSERT_EQ(KEYWORD_TABLE.find(spelling), type);
+    }
+    for (const auto &[spelling, type]: COMPOUND_OPERATORS) {
+        ASSERT_EQ(COMPOUND_OPERATOR_TABLE.find(spelling), type);
+    }
+    for (const auto &[spelling, type]: SINGLE_OPERATORS) {
+        ASSERT_EQ(SINGLE_OPERATOR_TABLE[static_cast<unsigned char>(spelling[0])], type);
+    }
+
+    static_assert(KEYWORD_TABLE.find("while") == TOKEN_TYPE::WHILE);
+    ASSERT_EQ(KEYWORD_TABLE.find("whale"), TOKEN_TYPE::EMPTY);
+    ASSERT_EQ(KEYWORD_TABLE.find("my_str"), TOKEN_TYPE::EMPTY);
+    ASSERT_EQ(COMPOUND_OPERATOR_TABLE.find("=!"), TOKEN_TYPE::EMPTY);
+    ASSERT_EQ(SINGLE_OPERATOR_TABLE['.'], TOKEN_TYPE::EMPTY);
+}
+
+// "line:column message" of every diagnostic, one per line
+std::string describe(const Diagnostics &diagnostics) {
+    std::string description;
+    for (const auto &diagnostic: diagnostics) {
+        if (diagnostic.m_location) {
+            description += std::to_string(diagnostic.m_location->m_line) + ":" +
+                           std::to_string(diagnostic.m_location->m_column) + " ";
+        }
+        description += diagnostic.m_message + "\n";
+    }
+    return description;
+}
+
+std::pair<std::vector<Token>, std::string> lex_with_core(LEXER_CORE core, const std::string &source) {
+    Lexer lexer(core);
+    auto tokens = lexer.lex(SourceBuffer::from_string(source));
+    return {*tokens, describe(lexer.diagnostics())};
+}
+
+TEST(UnitTests, TestDfaMatchesCascade) {
+    auto source = SourceBuffer::from_file(CODE_FILE);
+    Lexer cascade_lexer(LEXER_CORE::CASCADE);
+    Lexer dfa_lexer(LEXER_CORE::DFA);
+    ASSERT_EQ(*cascade_lexer.lex(source), *dfa_lexer.lex(source));
+
+    // random inputs, both cores must produce the same tokens and recover from the same errors
+    constexpr std::string_view alphabet = "ab_zAZ019 \t\r\n\n\"''//*+-%=!<>&|,()[]{};.#";
+    std::mt19937 random(1355);
+    for (int i = 0; i < 2000; ++i) {
+        std::string text(random() % 40, ' ');
+        for (auto &c: text) {
+            c = alphabet[random() % alphabet.size()];
+        }
+        ASSERT_EQ(lex_with_core(LEXER_CORE::CASCADE, text), lex_with_core(LEXER_CORE::DFA, text)) << text;
+    }
+}
+
+using TokenTuple = std::tuple<TOKEN_TYPE, uint32_t, uint32_t, uint32_t, uint32_t>;
+
+// kinds, positions, payloads and bracket partners of every token
+std::vector<TokenTuple> token_tuples(const TokenStream &stream) {
+    std::vector<TokenTuple> tokens;
+    for (size_t index = 0; index < stream.size(); ++index) {
+        tokens.emplace_back(stream.kind(index), stream.offset(index), stream.length(index), stream.payload(index),
+                            stream.partner(index));
+    }
+    return tokens;
+}
+
+// the tokens and the errors found on the way
+std::pair<std::vector<TokenTuple>, std::string>
+lex_stream_with_chunks(const std::shared_ptr<const SourceBuffer> &source, size_t chunk_count) {
+    Lexer lexer;
+    auto stream = chunk_count == 0 ? lexer.lex_stream(source) : lexer.lex_stream_parallel(source, chunk_count);
+    return {token_tuples(stream), describe(lexer.diagnostics())};
+}
+
+TEST(UnitTests, TestParallelMatchesSerial) {
+    auto source = SourceBuffer::from_file(CODE_FILE);
+    for (size_t chunk_count = 1; chunk_count <= 64; chunk_count *= 2) {
+        ASSERT_EQ(lex_stream_with_chunks(source, 0), lex_stream_with_chunks(source, chunk_count)) << chunk_count;
+    }
+
+    constexpr std::string_view alphabet = "ab_zAZ019 \t\r\n\n\n\"''//*+-%=!<>&|,()[]{};.#";
+    std::mt19937 random(4);
+    for (int i = 0; i < 500; ++i) {
+        std::string text(random() % 200, ' ');
+        for (auto &c: text) {
+            c = alphabet[random() % alphabet.size()];
+        }
+        auto text_source = SourceBuffer::from_string(text);
+        size_t chunk_count = 1 + random() % 12;
+        ASSERT_EQ(lex_stream_with_chunks(text_source, 0), lex_stream_with_chunks(text_source, chunk_count)) << text;
+    }
+}
+
+TEST(UnitTests, TestSourceLocations) {
+    auto source = SourceBuffer::from_string("int a;\n\n  b = 'c';\nlast");
+    ASSERT_EQ(source->line_starts(), std::vector<uint32_t>({0, 7, 8, 19}));
+    ASSERT_EQ(source->location(0), SourceLocation({1, 1}));
+    ASSERT_EQ(source->location(6), SourceLocation({1, 7})); // the newline still belongs to its line
+    ASSERT_EQ(source->location(7), SourceLocation({2, 1}));
+    ASSERT_EQ(source->location(10), SourceLocation({3, 3}));
+    ASSERT_EQ(source->location(source->size()), SourceLocation({4, 5}));
+    ASSERT_EQ(SourceBuffer::from_string("")->location(0), SourceLocation({1, 1}));
+
+    Lexer lexer;
+    auto stream = lexer.lex_stream(source);
+    ASSERT_EQ(stream.lexeme(5), "'c'");
+    ASSERT_EQ(stream.location(5), SourceLocation({3, 7}));
+
+    // lexer errors point at the offending literal, in both cores, and lexing goes on after them
+    for (auto core: {LEXER_CORE::CASCADE, LEXER_CORE::DFA}) {
+        Lexer error_lexer(core);
+        auto tokens = error_lexer.lex(SourceBuffer::from_string(
+                "a = 1;\n  b = \"unclosed;\nc = 'xy;\nd = 99999999999;\ne = 2;"));
+        const auto &diagnostics = error_lexer.diagnostics();
+        ASSERT_EQ(diagnostics.size(), 3);
+        ASSERT_EQ(diagnostics[0], Diagnostic({UNCLOSED_STRING_LITERAL, SourceLocation({2, 7})}));
+        ASSERT_EQ(diagnostics[1], Diagnostic({UNCLOSED_CHAR_LITERAL, SourceLocation({3, 5})}));
+        ASSERT_EQ(diagnostics[2], Diagnostic({INTEGER_OUT_OF_RANGE, SourceLocation({4, 5})}));
+        ASSERT_TRUE(contains_token(*tokens, {TOKEN_TYPE::INTEGER, 0}));
+        ASSERT_TRUE(contains_token(*tokens, {TOKEN_TYPE::IDENTIFIER, "e"}));
+    }
+}
+
+TEST(UnitTests, TestRelexMatchesFullLex) {
+    std::string text;
+    std::ifstream code_file(CODE_FILE);
+    text.assign(std::istreambuf_iterator<char>(code_file), std::istreambuf_iterator<char>());
+
+    constexpr std::string_view alphabet = "ab_zAZ019 \t\n\n\"'//*+-%=!<>&|,()[]{};";
+    std::mt19937 random(10);
+    auto source = SourceBuffer::from_string(text);
+    Lexer lexer;
+    TokenStream stream = lexer.lex_stream(source);
+
+    // chains of edits, every relex starts from the previous relex result
+    for (int i = 0; i < 300; ++i) {
+        TextEdit edit{random() % (source->size() + 1), 0, std::string(random() % 6, ' ')};
+        edit.m_removed_length = std::min<size_t>(random() % 8, source->size() - edit.m_offset);
+        for (auto &c: edit.m_inserted) {
+            c = alphabet[random() % alphabet.size()];
+        }
+        auto edited = source->edited(edit);
+        Lexer full_lexer;
+        auto expected = full_lexer.lex_stream(edited);
+
+        stream = lexer.relex(stream, edit);
+        ASSERT_EQ(stream.source()->view(), edited->view());
+        ASSERT_EQ(token_tuples(stream), token_tuples(expected)) << edited->view();
+        // errors on the relexed lines are the full lex's errors on those lines
+        for (const auto &diagnostic: lexer.diagnostics()) {
+            ASSERT_NE(std::find(full_lexer.diagnostics().begin(), full_lexer.diagnostics().end(), diagnostic),
+                      full_lexer.diagnostics().end()) << diagnostic.m_message;
+        }
+        source = edited;
+    }
+}
+
+TEST(UnitTests, TestBracketPartners) {
+    Lexer lexer;
+    auto stream = lexer.lex_stream(SourceBuffer::from_string("f(a[1], {b}) { }"));
+    ASSERT_EQ(stream.partner(1), 10); // ( )
+    ASSERT_EQ(stream.partner(3), 5);  // [ ]
+    ASSERT_EQ(stream.partner(10), 1);
+    ASSERT_EQ(stream.partner(7), 9);  // { }
+    ASSERT_EQ(stream.partner(0), NO_PARTNER);
+    ASSERT_EQ(stream.first_unbalanced(), NO_PARTNER);
+
+    // random bracket strings against a naive search for the partner
+    constexpr std::string_view brackets = "()[]{}a";
+    std::mt19937 random(14);
+    for (int i = 0; i < 500; ++i) {
+        std::string text(random() % 30, ' ');
+        for (auto &c: text) {
+            c = brackets[random() % brackets.size()];
+        }
+        stream = lexer.lex_stream(SourceBuffer::from_string(text));
+
+        std::vector<uint32_t> expected(stream.size(), NO_PARTNER);
+        std::vector<uint32_t> open;
+        uint32_t first_unbalanced = NO_PARTNER;
+        for (uint32_t index = 0; index < stream.size(); ++index) {
+            char c = stream.lexeme(index)[0];
+            if (c == '(' || c == '[' || c == '{') {
+                open.push_back(index);
+            } else if (c != 'a') {
+                char opening = c == ')' ? '(' : c == ']' ? '[' : '{';
+                if (!open.empty() && stream.lexeme(open.back())[0] == opening) {
+                    expected[index] = open.back();
+                    expected[open.back()] = index;
+                    open.pop_back();
+                } else if (first_unbalanced == NO_PARTNER) {
+                    first_unbalanced = index;
+                }
+            }
+        }
+        if (!open.empty()) {
+            first_unbalanced = std::min(first_unbalanced, open.front());
+        }
+        for (uint32_t index = 0; index < stream.size(); ++index) {
+            ASSERT_EQ(stream.partner(index), expected[index]) << text;
+        }
+        ASSERT_EQ(stream.first_unbalanced(), first_unbalanced) << text;
+    }
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include "tests/pipeline.h"
+
+class NameResolverTestSetup : public PipelineTestSetup {
+};
+
+TEST(UnitTests, TestSymbolTableScopes) {
+    ASTNode outer(Token(TOKEN_TYPE::IDENTIFIER, "x"));
+    ASTNode inner(Token(TOKEN_TYPE::IDENTIFIER, "x"));
+    uint32_t x = Symbol("x").m_id;
+    uint32_t y = Symbol("y").m_id;
+
+    SymbolTable table;
+    ASSERT_EQ(table.lookup(x), nullptr);
+    ASSERT_EQ(table.declare(x, &outer), nullptr);
+    ASSERT_EQ(table.declare(x, &inner), &outer);
+    table.enter_scope();
+    table.enter_scope();
+    ASSERT_EQ(table.declare(x, &inner), nullptr);
+    ASSERT_EQ(table.lookup(x), &inner);
+    table.leave_scope();
+    ASSERT_EQ(table.lookup(x), &outer);
+    ASSERT_EQ(table.declare(y, &inner), nullptr);
+    table.leave_scope();
+    ASSERT_EQ(table.lookup(x), &outer);
+    ASSERT_EQ(table.lookup(y), nullptr);
+
+    // thousands of nested scopes each shadowing the name, past several table growths
+    constexpr size_t depth = 5000;
+    std::vector<ASTNode> nodes(depth, ASTNode(Token(TOKEN_TYPE::IDENTIFIER, "x")));
+    for (size_t level = 0; level < depth; ++level) {
+        table.enter_scope();
+        table.declare(x, &nodes[level]);
+        table.declare(Symbol("name_" + std::to_string(level)).m_id, &nodes[level]);
+    }
+    ASSERT_EQ(table.depth(), depth);
+    ASSERT_EQ(table.lookup(x), &nodes.back());
+    for (size_t level = depth; level-- > 0;) {
+        ASSERT_EQ(table.lookup(x), &nodes[level]);
+        table.leave_scope();
+    }
+    ASSERT_EQ(table.lookup(x), &outer);
+    ASSERT_EQ(table.lookup(Symbol("name_0").m_id), nullptr);
+}
+
+TEST_F(NameResolverTestSetup, TestResolution) {
+    const NodeList &declarations = resolve("int g;\n"
+                                           "int f(int a);\n"
+                                           "int f(int a) { int b = a; { int a = b; g = a; } return f(a); }\n");
+    ASSERT_TRUE(resolver.diagnostics().empty()) << resolver.diagnostics()[0].m_message;
+
+    auto &function = std::get<FuncDeclaration>(declarations[2]->m_members);
+    auto &body = std::get<Block>(function.body->m_members).statements;
+    const ASTNode *param = function.params[0];
+    // int b = a;
+    auto &b_init = std::get<BinaryOperation>(body[0]->m_members);
+    ASSERT_EQ(resolver.declaration_of(b_init.rhs), param);
+    // { int a = b; g = a; } shadows the parameter
+    auto &inner = std::get<Block>(body[1]->m_members).statements;
+    auto &a_init = std::get<BinaryOperation>(inner[0]->m_members);
+    ASSERT_EQ(resolver.declaration_of(a_init.rhs), b_init.lhs);
+    auto &g_assign = std::get<BinaryOperation>(inner[1]->m_members);
+    ASSERT_EQ(resolver.declaration_of(g_assign.lhs), declarations[0]);
+    ASSERT_EQ(resolver.declaration_of(g_assign.rhs), a_init.lhs);
+    // return f(a); calls the definition with the parameter, the inner a is out of scope
+    const ASTNode *call = std::get<ReturnStatement>(body[2]->m_members).value;
+    ASSERT_EQ(resolver.declaration_of(call), declarations[2]);
+    ASSERT_EQ(resolver.declaration_of(std::get<FuncCall>(call->m_members).arg[0]), param);
+}
+
+TEST_F(NameResolverTestSetup, TestUndeclaredAndDuplicates) {
+    resolve("int x;\n"
+            "char x;\n"
+            "int f(int a, int a) { int a; { int a; } return y + a; }\n"
+            "int f() { return h(); }\n"
+            "int g(int, char);\n"
+            "int main() { { int z; } z = 1; return g(1, 'c'); }\n");
+    ASSERT_EQ(messages(resolver.diagnostics()), (std::vector<std::string>{
+            std::string(DUPLICATE_DECLARATION) + "x",
+            std::string(DUPLICATE_DECLARATION) + "a",
+            std::string(DUPLICATE_DECLARATION) + "a",
+            std::string(UNDECLARED_IDENTIFIER) + "y",
+            std::string(DUPLICATE_DECLARATION) + "f",
+            std::string(UNDECLARED_IDENTIFIER) + "h",
+            std::string(UNDECLARED_IDENTIFIER) + "z",
+    }));
+    ASSERT_EQ(locations(resolver.diagnostics()), (std::vector<SourceLocation>{
+            {2, 6}, {3, 18}, {3, 27}, {3, 48}, {4, 5}, {4, 18}, {6, 25},
+    }));
+}
+
+TEST_F(NameResolverTestSetup, TestDeepScopes) {
+    constexpr int depth = 20000;
+    std::string text = "int main() { int v; ";
+    for (int level = 0; level < depth; ++level) {
+        text += "{ int v; v = v; ";
+    }
+    text += std::string(depth, '}') + " return v; }";
+    resolve(text);
+    ASSERT_TRUE(resolver.diagnostics().empty());
+    ASSERT_EQ(resolver.resolved_count(), 2 * depth + 1);
+}
@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 #include "src/lexer.h"
 #include "src/parser.hpp"
+#include "src/ast_visitor.h"
+#include <random>
+
+constexpr auto CODE_FILE = "../../tests/hello_world.c";
 
 
 class ParserTestSetup : public ::testing::Test {
@@ -23,7 +27,7 @@ TEST_F(ParserTestSetup, TestOperations) {
                                        {token,                  value},
                                        {TOKEN_TYPE::INTEGER,    5}});
             auto it = tokens.begin();
-            std::unique_ptr<ASTNode> res = parser.parse_expression(it, tokens.end());
+            ASTNode *res = *parser.parse_expression(it, tokens.end());
             auto &operation_members = std::get<BinaryOperation>(res->m_members);
 
             ASSERT_EQ(res->m_token, tokens[1]);
@@ -39,7 +43,7 @@ TEST_F(ParserTestSetup, TestAssign) {
                                {TOKEN_TYPE::ASSIGN,     "="},
                                {TOKEN_TYPE::INTEGER,    5}});
     auto it = tokens.begin();
-    std::unique_ptr<ASTNode> res = parser.parse_expression(it, tokens.end());
+    ASTNode *res = *parser.parse_expression(it, tokens.end());
     auto &operation_members = std::get<BinaryOperation>(res->m_members);
 
     ASSERT_EQ(res->m_token, tokens[1]);
@@ -64,7 +68,7 @@ TEST_F(ParserTestSetup, TestFunctionLiteral) {
         }
 
         auto it = tokens.begin();
-        std::unique_ptr<ASTNode> res = parser.parse_expression(it, tokens.end());
+        ASTNode *res = *parser.parse_expression(it, tokens.end());
 
         auto &func_members = std::get<FuncCall>(res->m_members);
 
@@ -75,7 +79,7 @@ TEST_F(ParserTestSetup, TestFunctionLiteral) {
             for (int j = 0; j < func_members.arg.size(); ++j) {
                 int token_index = 2; // first argument index
                 token_index += 2 * j; // argument index skipping commas
-                ASSERT_TRUE(tokens[token_index] == std::move(func_members.arg[j])->m_token);
+                ASSERT_TRUE(tokens[token_index] == func_members.arg[j]->m_token);
             }
         }
     }
@@ -94,9 +98,9 @@ TEST_F(ParserTestSetup, TestFunctionExperssion) {
     tokens.insert(tokens.end() - 1, add_expression.begin(), add_expression.end());
 
     auto add_expression_it = add_expression.begin();
-    std::unique_ptr<ASTNode> parsed_add_expression = parser.parse_expression(add_expression_it, add_expression.end());
+    ASTNode *parsed_add_expression = *parser.parse_expression(add_expression_it, add_expression.end());
     auto it = tokens.begin();
-    std::unique_ptr<ASTNode> res = parser.parse_expression(it, tokens.end());
+    ASTNode *res = *parser.parse_expression(it, tokens.end());
     auto &func_members = std::get<FuncCall>(res->m_members);
 
     ASSERT_EQ(res->m_token, Token(TOKEN_TYPE::FUNC_CALL, tokens[0].m_value));
@@ -112,13 +116,9 @@ TEST_F(ParserTestSetup, TestFunctionSyntaxError) {
                                {TOKEN_TYPE::INTEGER,    1},
                                {TOKEN_TYPE::RPARENS,    ")"}});
     auto it = tokens.begin();
-    try {
-        parser.parse_expression(it, tokens.end());
-        FAIL(); // should not reach here due to exception
-    }
-    catch (CompilerException &exception) {
-        ASSERT_STREQ(exception.what(), NON_COMMA_SEPARATED_ARGS_ERROR);
-    }
+    auto res = parser.parse_expression(it, tokens.end());
+    ASSERT_FALSE(res);
+    ASSERT_EQ(res.error().m_message, NON_COMMA_SEPARATED_ARGS_ERROR);
 }
 
 TEST_F(ParserTestSetup, TestDeclarationSyntaxErrorNoIdentifier) {
@@ -132,13 +132,9 @@ TEST_F(ParserTestSetup, TestDeclarationSyntaxErrorNoIdentifier) {
                                {TOKEN_TYPE::INTEGER,   1},
                                {TOKEN_TYPE::SEMICOLON, ";"}});
     auto it = tokens.begin();
-    try {
-        parser.parse_statement(it, tokens.end());
-        FAIL(); // should not reach here due to exception
-    }
-    catch (CompilerException &exception) {
-        ASSERT_STREQ(exception.what(), BAD_DECLARATION);
-    }
+    auto statement = parser.parse_statement(it, tokens.end());
+    ASSERT_FALSE(statement);
+    ASSERT_EQ(statement.error().m_message, BAD_DECLARATION);
 }
 
 TEST_F(ParserTestSetup, TestAssignmentSyntaxErrorNoLValue) {
@@ -152,13 +148,9 @@ TEST_F(ParserTestSetup, TestAssignmentSyntaxErrorNoLValue) {
                                {TOKEN_TYPE::INTEGER,   1},
                                {TOKEN_TYPE::SEMICOLON, ";"}});
     auto it = tokens.begin();
-    try {
-        parser.parse_statement(it, tokens.end());
-        FAIL(); // should not reach here due to exception
-    }
-    catch (CompilerException &exception) {
-        ASSERT_STREQ(exception.what(), BAD_ASSIGNMENT);
-    }
+    auto statement = parser.parse_statement(it, tokens.end());
+    ASSERT_FALSE(statement);
+    ASSERT_EQ(statement.error().m_message, BAD_ASSIGNMENT);
 }
 
 TEST_F(ParserTestSetup, TestFuncDeclaration) {
@@ -182,9 +174,11 @@ TEST_F(ParserTestSetup, TestFuncDeclaration) {
     auto statement = parser.parse_statement(it, tokens.end());
     auto &func_declaration = std::get<FuncDeclaration>(statement->m_members);
 
-    ASSERT_EQ(func_declaration.return_type, return_type);
-    ASSERT_EQ(func_declaration.args_types[0], first_param);
-    ASSERT_EQ(func_declaration.args_types[1], second_param);
+    ASSERT_EQ(func_declaration.return_type, TypeName{return_type});
+    ASSERT_EQ(std::get<VariableDeclaration>(func_declaration.params[0]->m_members).type, TypeName{first_param});
+    ASSERT_EQ(std::get<VariableDeclaration>(func_declaration.params[1]->m_members).type, TypeName{second_param});
+    ASSERT_EQ(func_declaration.params[1]->m_token, Token(TOKEN_TYPE::IDENTIFIER, "second_param_name"));
+    ASSERT_EQ(func_declaration.body, nullptr);
 }
 
 TEST_F(ParserTestSetup, TestFuncDeclarationNoArgsIdentifiers) {
@@ -206,9 +200,10 @@ TEST_F(ParserTestSetup, TestFuncDeclarationNoArgsIdentifiers) {
     auto statement = parser.parse_statement(it, tokens.end());
     auto &func_declaration = std::get<FuncDeclaration>(statement->m_members);
 
-    ASSERT_EQ(func_declaration.return_type, return_type);
-    ASSERT_EQ(func_declaration.args_types[0], first_param);
-    ASSERT_EQ(func_declaration.args_types[1], second_param);
+    ASSERT_EQ(func_declaration.return_type, TypeName{return_type});
+    ASSERT_EQ(std::get<VariableDeclaration>(func_declaration.params[0]->m_members).type, TypeName{first_param});
+    ASSERT_EQ(std::get<VariableDeclaration>(func_declaration.params[1]->m_members).type, TypeName{second_param});
+    ASSERT_EQ(func_declaration.params[1]->m_token.m_type, TOKEN_TYPE::EMPTY);
 }
 
 TEST_F(ParserTestSetup, TestFuncDeclarationBadSyntax) {
@@ -227,12 +222,9 @@ TEST_F(ParserTestSetup, TestFuncDeclarationBadSyntax) {
                                {TOKEN_TYPE::SEMICOLON, ";"}});
 
     auto it = tokens.begin();
-    try {
-        auto statement = parser.parse_statement(it, tokens.end());
-    }
-    catch (CompilerException &exc) {
-        ASSERT_STREQ(exc.what(), FUNC_DECLARATION_PARAM_MISSING_TYPE);
-    }
+    auto statement = parser.parse_statement(it, tokens.end());
+    ASSERT_FALSE(statement);
+    ASSERT_EQ(statement.error().m_message, FUNC_DECLARATION_PARAM_MISSING_TYPE);
 
 }
 
@@ -260,6 +252,7 @@ TEST_F(ParserTestSetup, TestParseStatement) {
 
     for (int i = 0; i < statements.size(); ++i) {
         auto parsed_statement = parser.parse_statement(it, program.end());
+        ASSERT_TRUE(parsed_statement) << parsed_statement.error().m_message;
     }
 
 }
@@ -286,16 +279,528 @@ TEST(UnitTests, TestBracketSuffixFinder) {
                                    scope_suffix});
 
     auto ending_bracket = get_scope_end(simple_tokens.begin(), simple_tokens.end(), scope_prefix, scope_suffix);
-    ASSERT_EQ(simple_tokens[simple_tokens.size() - 1], *ending_bracket);
+    ASSERT_EQ(simple_tokens[simple_tokens.size() - 1], **ending_bracket);
 
     ending_bracket = get_scope_end(complex_tokens.begin(), complex_tokens.end(), scope_prefix, scope_suffix);
-    ASSERT_EQ(complex_tokens[complex_tokens.size() - 2], *ending_bracket);
+    ASSERT_EQ(complex_tokens[complex_tokens.size() - 2], **ending_bracket);
+
+    auto unclosed = get_scope_end(bad_tokens.begin(), bad_tokens.end(), scope_prefix, scope_suffix);
+    ASSERT_FALSE(unclosed);
+    ASSERT_EQ(unclosed.error().m_message, UNCLOSED_SCOPE);
+
+    // over a token stream the suffix comes from the bracket table
+    Lexer lexer;
+    auto stream = lexer.lex_stream(SourceBuffer::from_string("a { = = { = } = } = { {"));
+    auto stream_bracket = get_scope_end(stream.begin(), stream.end(), scope_prefix, scope_suffix);
+    ASSERT_EQ(stream_bracket.value().index(), 8);
+    auto stream_unclosed = get_scope_end(stream.begin() + 9, stream.end(), scope_prefix, scope_suffix);
+    ASSERT_FALSE(stream_unclosed);
+    ASSERT_EQ(stream_unclosed.error(), Diagnostic({UNCLOSED_SCOPE, SourceLocation({1, 21})}));
+}
+TEST_F(ParserTestSetup, TestParseTokenStream) {
+    // Test statement, parsing straight from the packed token stream
+    Lexer lexer;
+    auto stream = lexer.lex_stream(SourceBuffer::from_string("a = my_func_name(1 + b, 'c', \"str\");"));
+
+    auto it = stream.begin();
+    auto statement = parser.parse_statement(it, stream.end());
+    ASSERT_EQ(it, stream.end());
+
+    auto &assignment = std::get<BinaryOperation>(statement->m_members);
+    ASSERT_EQ(statement->m_token, Token(TOKEN_TYPE::ASSIGN, "="));
+    ASSERT_EQ(assignment.lhs->m_token, Token(TOKEN_TYPE::IDENTIFIER, "a"));
+
+    auto &func_members = std::get<FuncCall>(assignment.rhs->m_members);
+    ASSERT_EQ(assignment.rhs->m_token, Token(TOKEN_TYPE::FUNC_CALL, "my_func_name"));
+    ASSERT_EQ(func_members.arg.size(), 3);
+    ASSERT_EQ(func_members.arg[1]->m_token, Token(TOKEN_TYPE::CHARACTER, 'c'));
+    ASSERT_EQ(func_members.arg[2]->m_token, Token(TOKEN_TYPE::STRING, "str"));
+}
+
+// prefix notation of a parsed expression, calls as (call name args...) and prefix operators as (op:u operand)
+std::string to_prefix(const TreeNode &node) {
+    if (node.child_count() == 0 && node.kind() != NODE_KIND::FUNC_CALL) {
+        return node.token().to_string();
+    }
+    std::string text = "(";
+    text += node.kind() == NODE_KIND::FUNC_CALL ? "call " + node.token().to_string() :
+            node.kind() == NODE_KIND::UNARY_OPERATION ? node.token().to_string() + ":u" : node.token().to_string();
+    for (uint32_t index = 0; index < node.child_count(); ++index) {
+        text += " " + to_prefix(node.child(index));
+    }
+    return text + ")";
+}
 
-    try {
-        get_scope_end(bad_tokens.begin(), bad_tokens.end(), scope_prefix, scope_suffix);
+/*
+ * Textbook recursive descent over the C expression grammar, one function per precedence level,
+ * producing prefix notation directly. Reference for the precedence climbing parser.
+ */
+class ReferenceExpressionParser {
+public:
+    explicit ReferenceExpressionParser(const std::vector<Token> &tokens) : m_tokens(tokens) {}
+
+    std::string expression() {
+        std::string lhs = binary(0);
+        if (is(TOKEN_TYPE::ASSIGN)) {
+            ++m_position;
+            return "(= " + lhs + " " + expression() + ")";
+        }
+        return lhs;
     }
-    catch (CompilerException& exc)
-    {
-        ASSERT_STREQ(exc.what(), UNCLOSED_SCOPE);
+
+    size_t m_position = 0;
+
+private:
+    std::string binary(size_t level) {
+        static const std::vector<std::vector<TOKEN_TYPE>> levels = {
+                {TOKEN_TYPE::LOR},
+                {TOKEN_TYPE::LAND},
+                {TOKEN_TYPE::PIPE},
+                {TOKEN_TYPE::AMP},
+                {TOKEN_TYPE::EQ,   TOKEN_TYPE::NEQ},
+                {TOKEN_TYPE::LESS, TOKEN_TYPE::GREAT, TOKEN_TYPE::LEQ, TOKEN_TYPE::GEQ},
+                {TOKEN_TYPE::ADD,  TOKEN_TYPE::SUB},
+                {TOKEN_TYPE::STAR, TOKEN_TYPE::DIV,   TOKEN_TYPE::MOD},
+        };
+        if (level == levels.size()) {
+            return unary();
+        }
+        std::string lhs = binary(level + 1);
+        while (m_position < m_tokens.size() &&
+               std::find(levels[level].begin(), levels[level].end(), m_tokens[m_position].m_type) !=
+               levels[level].end()) {
+            std::string operator_text = m_tokens[m_position++].to_string();
+            lhs = "(" + operator_text + " " + lhs + " " + binary(level + 1) + ")";
+        }
+        return lhs;
     }
-}
\ No newline at end of file
+
+    std::string unary() {
+        if (is(TOKEN_TYPE::SUB) || is(TOKEN_TYPE::BANG) || is(TOKEN_TYPE::STAR) || is(TOKEN_TYPE::AMP)) {
+            std::string operator_text = m_tokens[m_position++].to_string();
+            return "(" + operator_text + ":u " + unary() + ")";
+        }
+        std::string operand = primary();
+        while (is(TOKEN_TYPE::LBRACKET)) {
+            ++m_position;
+            operand = "([ " + operand + " " + expression() + ")";
+            expect(TOKEN_TYPE::RBRACKET);
+        }
+        return operand;
+    }
+
+    std::string primary() {
+        if (m_position >= m_tokens.size()) {
+            throw CompilerException(UNEXPECTED_END_OF_EXPRESSION);
+        }
+        const Token &token = m_tokens[m_position++];
+        switch (token.m_type) {
+            case TOKEN_TYPE::INTEGER:
+            case TOKEN_TYPE::CHARACTER:
+            case TOKEN_TYPE::STRING:
+                return token.to_string();
+            case TOKEN_TYPE::IDENTIFIER:
+                return is(TOKEN_TYPE::LPARENS) ? call(token) : token.to_string();
+            case TOKEN_TYPE::LPARENS: {
+                std::string inner = expression();
+                expect(TOKEN_TYPE::RPARENS);
+                return inner;
+            }
+            default:
+                throw CompilerException("unsupported factor");
+        }
+    }
+
+    // same argument rules as the parser's calls, stray commas included
+    std::string call(const Token &name) {
+        ++m_position;
+        std::string text = "(call " + name.to_string();
+        bool is_arg = true;
+        while (!is(TOKEN_TYPE::RPARENS)) {
+            if (m_position >= m_tokens.size()) {
+                throw CompilerException("unclosed function call");
+            }
+            if (is(TOKEN_TYPE::COMMA)) {
+                ++m_position;
+                is_arg = true;
+                continue;
+            }
+            if (!is_arg) {
+                throw CompilerException(NON_COMMA_SEPARATED_ARGS_ERROR);
+            }
+            text += " " + binary(0);
+            is_arg = false;
+        }
+        ++m_position;
+        return text + ")";
+    }
+
+    bool is(TOKEN_TYPE type) const { return m_position < m_tokens.size() && m_tokens[m_position].m_type == type; }
+
+    void expect(TOKEN_TYPE type) {
+        if (!is(type)) {
+            throw CompilerException("expected a closing token");
+        }
+        ++m_position;
+    }
+
+    const std::vector<Token> &m_tokens;
+};
+
+// random expression text, mostly well formed with random parentheses, sometimes not
+std::string random_expression(std::mt19937 &random, int depth) {
+    static const std::vector<std::string> binary_operators = {"||", "&&", "|", "&", "==", "!=", "<", ">", "<=", ">=",
+                                                              "+", "-", "*", "/", "%", "="};
+    static const std::vector<std::string> unary_operators = {"-", "!", "*", "&"};
+    static const std::vector<std::string> atoms = {"a", "b", "c", "1", "42", "'x'", "\"s\""};
+    switch (depth <= 0 ? 0 : random() % 7) {
+        case 0:
+            return atoms[random() % atoms.size()];
+        case 1:
+            return unary_operators[random() % unary_operators.size()] + random_expression(random, depth - 1);
+        case 2:
+            return "(" + random_expression(random, depth - 1) + ")";
+        case 3:
+            return atoms[random() % 3] + "[" + random_expression(random, depth - 1) + "]";
+        case 4: {
+            std::string call = "f(";
+            for (int argument = random() % 4; argument > 0; --argument) {
+                call += random_expression(random, depth - 1) + (argument > 1 ? ", " : "");
+            }
+            return call + ")";
+        }
+        default:
+            return random_expression(random, depth - 1) + " " + binary_operators[random() % binary_operators.size()] +
+                   " " + random_expression(random, depth - 1);
+    }
+}
+
+TEST_F(ParserTestSetup, TestPrecedenceClimbing) {
+    Lexer lexer;
+    auto parse = [&](const std::string &text) {
+        auto tokens = lexer.lex(SourceBuffer::from_string(text));
+        auto it = tokens->begin();
+        return to_prefix(TreeNode(*parser.parse_expression(it, tokens->end())));
+    };
+    ASSERT_EQ(parse("a + b * c"), "(+ a (* b c))");
+    ASSERT_EQ(parse("a - b - c"), "(- (- a b) c)");
+    ASSERT_EQ(parse("a = b = c + 1"), "(= a (= b (+ c 1)))");
+    ASSERT_EQ(parse("(a + b) * -c[2]"), "(* (+ a b) (-:u ([ c 2)))");
+    ASSERT_EQ(parse("*p = &a || !b && a < b == c"), "(= (*:u p) (|| (&:u a) (&& (!:u b) (== (< a b) c))))");
+    ASSERT_EQ(parse("f(a | b & c, g(1)[0] % 2)"), "(call f (| a (& b c)) (% ([ (call g 1) 0) 2))");
+}
+
+TEST_F(ParserTestSetup, TestPrecedenceClimbingMatchesReference) {
+    // random token soup next to well formed expressions: both parsers accept the same inputs,
+    // stop at the same token and build the same trees
+    Lexer lexer;
+    std::mt19937 random(13);
+    const std::vector<std::string> soup = {"a", "b", "1", "f", "(", ")", "[", "]", ",", "+", "-", "*", "/", "&", "|",
+                                           "!", "=", "==", "<=", "&&", "||"};
+    for (int i = 0; i < 3000; ++i) {
+        std::string text;
+        if (i % 3 == 0) {
+            for (int token = random() % 12; token >= 0; --token) {
+                text += soup[random() % soup.size()] + " ";
+            }
+        } else {
+            text = random_expression(random, 1 + random() % 5);
+        }
+        auto tokens = lexer.lex(SourceBuffer::from_string(text));
+
+        std::string expected;
+        ReferenceExpressionParser reference(*tokens);
+        try {
+            expected = reference.expression();
+        }
+        catch (CompilerException &) {
+            expected = "error";
+        }
+
+        auto it = tokens->begin();
+        auto result = parser.parse_expression(it, tokens->end());
+        std::string parsed = result ? to_prefix(TreeNode(*result)) : "error";
+        ASSERT_EQ(parsed, expected) << text;
+        if (expected != "error") {
+            ASSERT_EQ(it - tokens->begin(), reference.m_position) << text;
+        }
+    }
+}
+
+TEST_F(ParserTestSetup, TestDeclarationLookahead) {
+    Lexer lexer;
+    auto stream = lexer.lex_stream(SourceBuffer::from_string("int a; char b = 'c' + 1; int f(int, char); int g = f(1);"));
+    auto it = stream.begin();
+
+    auto variable = parser.parse_statement(it, stream.end());
+    ASSERT_EQ(node_kind(**variable), NODE_KIND::VARIABLE_DECLARATION);
+
+    auto initialized = parser.parse_statement(it, stream.end());
+    ASSERT_EQ(initialized->m_token, Token(TOKEN_TYPE::ASSIGN, "="));
+    auto &initializer = std::get<BinaryOperation>(initialized->m_members);
+    ASSERT_EQ(std::get<VariableDeclaration>(initializer.lhs->m_members).type, TypeName{Token(TOKEN_TYPE::CHAR, "char")});
+    ASSERT_EQ(initializer.rhs->m_token, Token(TOKEN_TYPE::ADD, "+"));
+
+    auto function = parser.parse_statement(it, stream.end());
+    ASSERT_EQ(node_kind(**function), NODE_KIND::FUNC_DECLARATION);
+
+    // a call in the initializer doesn't make it a function declaration
+    auto call_initialized = parser.parse_statement(it, stream.end());
+    ASSERT_EQ(std::get<BinaryOperation>(call_initialized->m_members).rhs->m_token, Token(TOKEN_TYPE::FUNC_CALL, "f"));
+    ASSERT_EQ(it, stream.end());
+}
+
+TEST_F(ParserTestSetup, TestErrorRecovery) {
+    // every broken statement is reported, parsing picks up again after its semicolon
+    auto source = SourceBuffer::from_string("int a;\n"
+                                            "a = 1 +;\n"
+                                            "b = (2;\n"
+                                            "int = 3;\n"
+                                            "log(a);\n"
+                                            "c = 4\n"
+                                            "d[1] = 2;\n"
+                                            "e = 5;\n");
+    Lexer lexer;
+    auto stream = lexer.lex_stream(source);
+    auto it = stream.begin();
+    auto statements = parser.parse_statements(it, stream.end());
+    ASSERT_EQ(it, stream.end());
+
+    ASSERT_EQ(statements.size(), 3);
+    ASSERT_EQ(node_kind(*statements[0]), NODE_KIND::VARIABLE_DECLARATION);
+    ASSERT_EQ(statements[1]->m_token, Token(TOKEN_TYPE::FUNC_CALL, "log"));
+    ASSERT_EQ(statements[2]->m_token, Token(TOKEN_TYPE::ASSIGN, "="));
+
+    const auto &diagnostics = parser.diagnostics();
+    ASSERT_EQ(diagnostics.size(), 4);
+    ASSERT_TRUE(diagnostics[0].m_message.starts_with(UNSUPPORTED_FACTOR));
+    ASSERT_EQ(diagnostics[0].m_location, SourceLocation({2, 8}));
+    ASSERT_EQ(diagnostics[1], Diagnostic({UNCLOSED_PARENTHESES, SourceLocation({3, 7})}));
+    ASSERT_EQ(diagnostics[2], Diagnostic({BAD_DECLARATION, SourceLocation({4, 5})}));
+    ASSERT_EQ(diagnostics[3], Diagnostic({NON_SEMICOLON_STATEMENT_SUFFIX, SourceLocation({7, 1})}));
+
+    // a stray closing brace is skipped on its own
+    Parser brace_parser;
+    auto braced = lexer.lex_stream(SourceBuffer::from_string("} a = 1; }"));
+    auto braced_it = braced.begin();
+    ASSERT_EQ(brace_parser.parse_statements(braced_it, braced.end()).size(), 1);
+    ASSERT_EQ(brace_parser.diagnostics().size(), 2);
+
+    // the same errors from tokens lexed on demand
+    Parser cursor_parser;
+    TokenCursor cursor(source);
+    auto cursor_it = cursor.begin();
+    ASSERT_EQ(cursor_parser.parse_statements(cursor_it, cursor.end()).size(), 3);
+    ASSERT_TRUE(std::equal(diagnostics.begin(), diagnostics.end(), cursor_parser.diagnostics().begin(),
+                           cursor_parser.diagnostics().end()));
+}
+
+TEST_F(ParserTestSetup, TestTranslationUnit) {
+    Lexer lexer;
+    auto stream = lexer.lex_stream(SourceBuffer::from_file(CODE_FILE));
+    auto it = stream.begin();
+    auto declarations = parser.parse_translation_unit(it, stream.end());
+    ASSERT_TRUE(parser.diagnostics().empty()) << parser.diagnostics()[0].m_message;
+    ASSERT_EQ(it, stream.end());
+
+    // get_two, print, input and main
+    ASSERT_EQ(declarations.size(), 4);
+    auto &get_two = std::get<FuncDeclaration>(declarations[0]->m_members);
+    ASSERT_EQ(std::get<VariableDeclaration>(get_two.params[1]->m_members).type.pointer_depth, 1);
+    ASSERT_EQ(std::get<Block>(get_two.body->m_members).statements.size(), 4);
+    auto &print = std::get<FuncDeclaration>(declarations[1]->m_members);
+    ASSERT_EQ(print.return_type.pointer_depth, 1);
+    ASSERT_EQ(print.body, nullptr);
+
+    auto &main_body = std::get<Block>(std::get<FuncDeclaration>(declarations[3]->m_members).body->m_members);
+    ASSERT_EQ(main_body.statements.size(), 8);
+    auto &loop = std::get<WhileLoop>(main_body.statements[6]->m_members);
+    ASSERT_EQ(std::get<Block>(loop.body->m_members).statements[0]->m_token.m_type, TOKEN_TYPE::BREAK);
+
+    // if / else if / else if / else nests through the else branches
+    const ASTNode *branch = main_body.statements[7];
+    int if_count = 0;
+    while (node_kind(*branch) == NODE_KIND::IF) {
+        ++if_count;
+        branch = std::get<IfStatement>(branch->m_members).else_branch;
+    }
+    ASSERT_EQ(if_count, 3);
+    auto &last_return = std::get<ReturnStatement>(std::get<Block>(branch->m_members).statements[0]->m_members);
+    ASSERT_EQ(last_return.value->m_token, Token(TOKEN_TYPE::INTEGER, 0));
+}
+
+TEST_F(ParserTestSetup, TestDeepNesting) {
+    // far deeper than the call stack would allow if every level recursed
+    constexpr int depth = 100000;
+    std::string text = "int main() ";
+    for (int level = 0; level < depth; ++level) {
+        text += "{ while (a) if (b) ";
+    }
+    text += "break;";
+    for (int level = 0; level < depth; ++level) {
+        text += " }";
+    }
+
+    Lexer lexer;
+    auto stream = lexer.lex_stream(SourceBuffer::from_string(text));
+    auto it = stream.begin();
+    auto declarations = parser.parse_translation_unit(it, stream.end());
+    ASSERT_TRUE(parser.diagnostics().empty());
+    ASSERT_EQ(declarations.size(), 1);
+
+    const ASTNode *node = std::get<FuncDeclaration>(declarations[0]->m_members).body;
+    for (int level = 0; level < depth; ++level) {
+        auto &loop = std::get<WhileLoop>(std::get<Block>(node->m_members).statements[0]->m_members);
+        node = std::get<IfStatement>(loop.body->m_members).then_branch;
+    }
+    ASSERT_EQ(node->m_token.m_type, TOKEN_TYPE::BREAK);
+}
+
+TEST_F(ParserTestSetup, TestDeepExpressions) {
+    // parentheses, indexes, arguments, prefix operators and assignments nest without recursing either
+    constexpr int depth = 100000;
+    const std::vector<std::pair<std::string, std::string>> levels = {
+            {"(", ")"}, {"a[", "]"}, {"f(", ")"}, {"-", ""}, {"b = ", ""}};
+    Lexer lexer;
+    for (const auto &[open, close]: levels) {
+        std::string text;
+        for (int level = 0; level < depth; ++level) {
+            text += open;
+        }
+        text += "1";
+        for (int level = 0; level < depth; ++level) {
+            text += close;
+        }
+        auto stream = lexer.lex_stream(SourceBuffer::from_string(text));
+        auto it = stream.begin();
+        auto expression = parser.parse_expression(it, stream.end());
+        ASSERT_TRUE(expression) << open;
+        ASSERT_EQ(it, stream.end());
+
+        // parentheses make no nodes of their own, every other level nests in its last child
+        TreeNode node(*expression);
+        int nested = 0;
+        while (node.child_count() != 0) {
+            node = node.child(node.child_count() - 1);
+            ++nested;
+        }
+        ASSERT_EQ(nested, open == "(" ? 0 : depth) << open;
+        ASSERT_EQ(node.token(), Token(TOKEN_TYPE::INTEGER, 1));
+    }
+}
+
+TEST_F(ParserTestSetup, TestBlockErrorRecovery) {
+    // errors inside a function body are skipped statement by statement, the rest of the body still parses
+    Lexer lexer;
+    auto stream = lexer.lex_stream(SourceBuffer::from_string("int f() {\n"
+                                                             "  break;\n"
+                                                             "  if (a +) { b(); }\n"
+                                                             "  while (a) { c = ; d(); }\n"
+                                                             "  return 1;\n"
+                                                             "}\n"
+                                                             "x = 1;\n"
+                                                             "int g(char *s) { return s; }\n"));
+    auto it = stream.begin();
+    auto declarations = parser.parse_translation_unit(it, stream.end());
+
+    const auto &diagnostics = parser.diagnostics();
+    ASSERT_EQ(diagnostics.size(), 4);
+    ASSERT_EQ(diagnostics[0], Diagnostic({JUMP_OUTSIDE_LOOP, SourceLocation({2, 3})}));
+    ASSERT_EQ(diagnostics[1].m_location, SourceLocation({3, 10}));
+    ASSERT_EQ(diagnostics[2].m_location, SourceLocation({4, 19}));
+    ASSERT_EQ(diagnostics[3], Diagnostic({EXPECTED_DECLARATION, SourceLocation({7, 1})}));
+
+    ASSERT_EQ(declarations.size(), 2);
+    auto &body = std::get<Block>(std::get<FuncDeclaration>(declarations[0]->m_members).body->m_members);
+    ASSERT_EQ(body.statements.size(), 2);
+    ASSERT_EQ(std::get<Block>(std::get<WhileLoop>(body.statements[0]->m_members).body->m_members).statements.size(), 1);
+    ASSERT_EQ(body.statements[1]->m_token.m_type, TOKEN_TYPE::RETURN);
+
+    // running out of input inside a block fails the definition
+    Parser unclosed_parser;
+    auto unclosed = lexer.lex_stream(SourceBuffer::from_string("int f() { if (a) { b(); }"));
+    auto unclosed_it = unclosed.begin();
+    ASSERT_TRUE(unclosed_parser.parse_translation_unit(unclosed_it, unclosed.end()).empty());
+    ASSERT_EQ(unclosed_parser.diagnostics()[0], Diagnostic({UNCLOSED_SCOPE, SourceLocation({1, 9})}));
+}
+
+TEST_F(ParserTestSetup, TestParallelTranslationUnit) {
+    // definitions, prototypes and errors in the skimmed part as well as inside bodies
+    std::string text;
+    for (int index = 0; index < 200; ++index) {
+        std::string name = "f" + std::to_string(index);
+        switch (index % 5) {
+            case 0:
+                text += "int " + name + "(int a, char *b) { while (a) { a = a - 1; if (b) break; } return a; }\n";
+                break;
+            case 1:
+                text += "char *" + name + "(int);\n";
+                break;
+            case 2:
+                text += "int " + name + "() { x = ; " + name + "(1, 2); }\n";
+                break;
+            case 3:
+                text += "y = 1;\nint " + name + "() { { break; } return; }\n";
+                break;
+            default:
+                text += "void " + name + "(void *p) { if (p) { return p[1]; } else return 0; }\n";
+        }
+    }
+    Lexer lexer;
+    auto stream = lexer.lex_stream(SourceBuffer::from_string(text));
+    auto it = stream.begin();
+    auto serial = parser.parse_translation_unit(it, stream.end());
+
+    for (size_t thread_count: {1, 3, 8}) {
+        ThreadPool pool(thread_count);
+        Parser parallel_parser;
+        auto parallel = parallel_parser.parse_translation_unit_parallel(stream, pool);
+        ASSERT_EQ(parallel.size(), serial.size());
+        for (size_t index = 0; index < serial.size(); ++index) {
+            ASSERT_EQ(to_prefix(TreeNode(parallel[index])), to_prefix(TreeNode(serial[index])));
+        }
+        ASSERT_EQ(parallel_parser.diagnostics().size(), parser.diagnostics().size());
+        for (size_t index = 0; index < parser.diagnostics().size(); ++index) {
+            ASSERT_EQ(parallel_parser.diagnostics()[index], parser.diagnostics()[index]);
+        }
+    }
+
+    // unbalanced braces take the serial path
+    auto unbalanced = lexer.lex_stream(SourceBuffer::from_string("int f() { if (a) { b(); }"));
+    Parser unbalanced_parser;
+    ASSERT_TRUE(unbalanced_parser.parse_translation_unit_parallel(unbalanced).empty());
+    ASSERT_EQ(unbalanced_parser.diagnostics()[0], Diagnostic({UNCLOSED_SCOPE, SourceLocation({1, 9})}));
+}
+
+TEST_F(ParserTestSetup, TestLazyFunctionBodies) {
+    Lexer lexer;
+    auto stream = lexer.lex_stream(SourceBuffer::from_string("int f(int a) { while (a) { a = a - 1; } return a; }\n"
+                                                             "char *g(int);\n"
+                                                             "int h() { x = ; return 2; }\n"));
+    auto it = stream.begin();
+    auto eager = parser.parse_translation_unit(it, stream.end());
+
+    Parser lazy_parser;
+    auto lazy = lazy_parser.parse_translation_unit_lazy(stream);
+    ASSERT_EQ(lazy.size(), 3);
+    ASSERT_TRUE(lazy_parser.diagnostics().empty());
+    for (ASTNode *declaration: lazy) {
+        ASSERT_EQ(std::get<FuncDeclaration>(declaration->m_members).body, nullptr);
+    }
+    ASSERT_EQ(std::get<FuncDeclaration>(lazy[1]->m_members).deferred_body, NO_DEFERRED_BODY);
+
+    // a body is parsed on first access, errors inside it are reported then, and the node keeps it
+    ASSERT_EQ(lazy_parser.function_body(*lazy[1]), nullptr);
+    ASSERT_TRUE(lazy_parser.diagnostics().empty());
+    ASTNode *h_body = lazy_parser.function_body(*lazy[2]);
+    ASSERT_EQ(to_prefix(TreeNode(h_body)), to_prefix(TreeNode(std::get<FuncDeclaration>(eager[2]->m_members).body)));
+    ASSERT_EQ(lazy_parser.diagnostics().size(), 1);
+    ASSERT_EQ(lazy_parser.diagnostics()[0], parser.diagnostics()[0]);
+    ASSERT_EQ(lazy_parser.function_body(*lazy[2]), h_body);
+    ASSERT_EQ(lazy_parser.diagnostics().size(), 1);
+
+    lazy_parser.function_body(*lazy[0]);
+    for (size_t index = 0; index < eager.size(); ++index) {
+        ASSERT_EQ(to_prefix(TreeNode(lazy[index])), to_prefix(TreeNode(eager[index])));
+    }
+}
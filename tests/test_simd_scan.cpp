@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include "src/lexer.h"
+#include "src/simd_scan.h"
+
+const char *skip_reference(const char *begin, const char *end, const ByteSet &set) {
+    while (begin < end && set.m_members[static_cast<unsigned char>(*begin)]) {
+        ++begin;
+    }
+    return begin;
+}
+
+TEST(UnitTests, TestSimdSkipMatchesScalar) {
+    std::vector<const ByteSet *> sets = {&IDENTIFIER_BYTES, &DIGIT_BYTES, &STRING_BODY_BYTES};
+    for (const auto &set: DFA_SELF_LOOP_SETS) {
+        sets.push_back(&set);
+    }
+
+    std::mt19937 random(1355);
+    for (auto level: {SIMD_LEVEL::SCALAR, SIMD_LEVEL::SSE42, SIMD_LEVEL::AVX2}) {
+        set_simd_level(level);
+        for (int i = 0; i < 2000; ++i) {
+            // long runs of one class with the odd byte from anywhere in the byte range
+            std::string buffer(random() % 100, 'a');
+            for (auto &c: buffer) {
+                c = random() % 8 == 0 ? static_cast<char>(random() % 256) : "ab_9 \t/\""[random() % 8];
+            }
+            for (const auto *set: sets) {
+                size_t start = buffer.empty() ? 0 : random() % buffer.size();
+                const char *begin = buffer.data() + start;
+                const char *end = buffer.data() + buffer.size();
+                ASSERT_EQ(skip_byte_set(begin, end, *set), skip_reference(begin, end, *set))
+                                            << simd_level_name(simd_level()) << " " << buffer;
+            }
+        }
+    }
+    set_simd_level(best_simd_level());
+}
+
+TEST(UnitTests, TestLexerSimdLevelsAgree) {
+    std::string source;
+    for (int i = 0; i < 200; ++i) {
+        source += "int a_very_long_identifier_name_" + std::to_string(i) + " = 1234567890 % 7; "
+                  "// a comment long enough to span a couple of vectors\n"
+                  "char* s = \"a string literal long enough to span a couple of vectors\";\n";
+    }
+    auto buffer = SourceBuffer::from_string(source);
+
+    set_simd_level(SIMD_LEVEL::SCALAR);
+    auto expected = Lexer(LEXER_CORE::CASCADE).lex_stream(buffer).to_tokens();
+    for (auto level: {SIMD_LEVEL::SCALAR, SIMD_LEVEL::SSE42, SIMD_LEVEL::AVX2}) {
+        set_simd_level(level);
+        for (auto core: {LEXER_CORE::CASCADE, LEXER_CORE::DFA}) {
+            ASSERT_EQ(Lexer(core).lex_stream(buffer).to_tokens(), expected);
+        }
+    }
+    set_simd_level(best_simd_level());
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "src/thread_pool.h"
+
+TEST(UnitTests, TestParallelForRunsEveryTaskOnce) {
+    ThreadPool pool(4);
+    for (size_t task_count: {0, 1, 3, 4, 1000}) {
+        std::vector<std::atomic<int>> runs(task_count);
+        std::vector<size_t> workers(task_count);
+        pool.parallel_for(task_count, [&](size_t index, size_t worker) {
+            ++runs[index];
+            workers[index] = worker;
+        });
+        for (size_t index = 0; index < task_count; ++index) {
+            ASSERT_EQ(runs[index], 1);
+            ASSERT_LT(workers[index], pool.thread_count());
+        }
+    }
+}
+
+TEST(UnitTests, TestParallelForStealsUnevenWork) {
+    // every slow task sits in the caller's slice, the other threads only finish by stealing them
+    ThreadPool pool(4);
+    constexpr size_t task_count = 64;
+    std::vector<std::atomic<int>> runs(task_count);
+    std::atomic<size_t> stolen = 0;
+    pool.parallel_for(task_count, [&](size_t index, size_t worker) {
+        if (index < task_count / pool.thread_count()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            stolen += worker != 0;
+        }
+        ++runs[index];
+    });
+    for (auto &count: runs) {
+        ASSERT_EQ(count, 1);
+    }
+    ASSERT_GT(stolen, 0);
+}
+
+TEST(UnitTests, TestParallelForRethrows) {
+    ThreadPool pool(3);
+    std::atomic<int> ran = 0;
+    ASSERT_THROW(pool.parallel_for(100, [&](size_t index) {
+        ++ran;
+        if (index == 42) {
+            throw std::runtime_error("task failed");
+        }
+    }), std::runtime_error);
+    ASSERT_EQ(ran, 100);
+    // the pool is still usable afterwards
+    pool.parallel_for(10, [&](size_t) { ++ran; });
+    ASSERT_EQ(ran, 110);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "src/token_cursor.h"
+#include "src/parser.hpp"
+
+constexpr auto CODE_FILE = "../../tests/hello_world.c";
+
+TEST(UnitTests, TestCursorMatchesTokenStream) {
+    auto source = SourceBuffer::from_file(CODE_FILE);
+    Lexer lexer;
+    auto stream = lexer.lex_stream(source);
+
+    // a window smaller than the file makes the ring wrap around
+    TokenCursor cursor(source, 8);
+    size_t index = 0;
+    for (auto it = cursor.begin(); it < cursor.end(); ++it, ++index) {
+        ASSERT_LT(index, stream.size());
+        ASSERT_EQ(*it, stream[index]);
+        ASSERT_EQ(it->m_lexeme, stream.lexeme(index));
+    }
+    ASSERT_EQ(index, stream.size());
+    ASSERT_EQ(cursor.end() - cursor.begin(), stream.size());
+}
+
+TEST(UnitTests, TestCursorIsLazy) {
+    std::string text;
+    for (int line = 0; line < 2000; ++line) {
+        text += "a = b + " + std::to_string(line) + ";\n";
+    }
+    TokenCursor cursor(SourceBuffer::from_string(text), 16);
+
+    auto it = cursor.begin();
+    ASSERT_TRUE(it + 3 < cursor.end());
+    ASSERT_LT(cursor.lexed_count(), text.size() / 4); // only the first batch was lexed
+
+    size_t memory_after_first_batch = cursor.memory_usage();
+    while (it < cursor.end()) {
+        ++it;
+    }
+    ASSERT_EQ(it, cursor.end());
+    ASSERT_EQ(it.index(), 2000 * 6);
+    ASSERT_LE(cursor.memory_usage(), memory_after_first_batch);
+
+    try {
+        *(it - 100);
+        FAIL(); // should not reach here due to exception
+    }
+    catch (CompilerException &exc) {
+        ASSERT_STREQ(exc.what(), TOKEN_OUTSIDE_WINDOW);
+    }
+}
+
+TEST(UnitTests, TestParseFromCursor) {
+    // statements are parsed while the rest of the input isn't lexed yet
+    TokenCursor cursor(SourceBuffer::from_string("a = my_func_name(1 + b, 'c');\nint my_func_name(int, char);\n"
+                                                 "log(a);\n"));
+    Parser parser;
+    auto it = cursor.begin();
+
+    auto assignment = parser.parse_statement(it, cursor.end());
+    ASSERT_EQ(assignment->m_token, Token(TOKEN_TYPE::ASSIGN, "="));
+    ASSERT_EQ(assignment->m_offset, 2);
+    ASSERT_EQ(std::get<FuncCall>(std::get<BinaryOperation>(assignment->m_members).rhs->m_members).arg.size(), 2);
+
+    auto declaration = parser.parse_statement(it, cursor.end());
+    ASSERT_EQ(std::get<FuncDeclaration>(declaration->m_members).params.size(), 2);
+
+    auto call = parser.parse_statement(it, cursor.end());
+    ASSERT_EQ(call->m_token, Token(TOKEN_TYPE::FUNC_CALL, "log"));
+    ASSERT_EQ(call->m_offset, 59);
+    ASSERT_EQ(it, cursor.end());
+}
+
+TEST(UnitTests, TestErrorsOutsideCursorWindow) {
+    // the unclosed braces opened thousands of tokens before the end of the input is found
+    std::string text = "int f(int a) {\n  while (a) {\n";
+    for (int line = 0; line < 3000; ++line) {
+        text += "    a = a - " + std::to_string(line) + ";\n";
+    }
+    auto source = SourceBuffer::from_string(text);
+    Lexer lexer;
+    auto stream = lexer.lex_stream(source);
+    Parser stream_parser;
+    auto stream_it = stream.begin();
+    ASSERT_TRUE(stream_parser.parse_translation_unit(stream_it, stream.end()).empty());
+    ASSERT_EQ(stream_parser.diagnostics().size(), 1);
+    ASSERT_EQ(stream_parser.diagnostics()[0].m_message, UNCLOSED_SCOPE);
+
+    TokenCursor cursor(source, 64);
+    Parser cursor_parser;
+    auto cursor_it = cursor.begin();
+    ASSERT_TRUE(cursor_parser.parse_translation_unit(cursor_it, cursor.end()).empty());
+    ASSERT_EQ(cursor_parser.diagnostics().size(), 1);
+    ASSERT_EQ(cursor_parser.diagnostics()[0], stream_parser.diagnostics()[0]);
+
+    // a statement nested in an unclosed block the same way
+    TokenCursor statement_cursor(SourceBuffer::from_string(text.substr(text.find('{') + 1)), 64);
+    Parser statement_parser;
+    auto statement_it = statement_cursor.begin();
+    auto statement = statement_parser.parse_statement(statement_it, statement_cursor.end());
+    ASSERT_FALSE(statement);
+    ASSERT_EQ(statement.error(), Diagnostic({UNCLOSED_SCOPE, SourceLocation({2, 13})}));
+}
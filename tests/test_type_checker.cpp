@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include "tests/pipeline.h"
+
+constexpr auto CODE_FILE = "../../tests/hello_world.c";
+
+class TypeCheckerTestSetup : public PipelineTestSetup {
+};
+
+TEST(UnitTests, TestTypeTableHashConsing) {
+    TypeTable table;
+    TypeId char_pointer = table.pointer_to(TypeTable::CHAR_TYPE);
+    ASSERT_EQ(table.pointer_to(TypeTable::CHAR_TYPE), char_pointer);
+    ASSERT_NE(table.pointer_to(TypeTable::INT_TYPE), char_pointer);
+    ASSERT_EQ(table.from_type_name({Token(TOKEN_TYPE::CHAR, "char"), 2}), table.pointer_to(char_pointer));
+    ASSERT_EQ(table.pointee(char_pointer), TypeTable::CHAR_TYPE);
+
+    std::vector<TypeId> params = {TypeTable::INT_TYPE, char_pointer};
+    TypeId function = table.function(TypeTable::INT_TYPE, params);
+    ASSERT_EQ(table.function(TypeTable::INT_TYPE, std::vector<TypeId>{TypeTable::INT_TYPE, char_pointer}), function);
+    ASSERT_NE(table.function(TypeTable::CHAR_TYPE, params), function);
+    ASSERT_NE(table.function(TypeTable::INT_TYPE, std::vector<TypeId>{TypeTable::INT_TYPE}), function);
+    ASSERT_EQ(table.kind(function), TYPE_KIND::FUNCTION);
+    ASSERT_EQ(table.to_string(function), "int (int, char *)");
+    ASSERT_EQ(table.to_string(table.pointer_to(char_pointer)), "char **");
+
+    // a 255 level pointer is built once, asking again walks the same ids
+    TypeName deep{Token(TOKEN_TYPE::VOID, "void"), UINT8_MAX};
+    size_t type_count = table.size();
+    TypeId deep_pointer = table.from_type_name(deep);
+    ASSERT_EQ(table.size(), type_count + UINT8_MAX);
+    ASSERT_EQ(table.from_type_name(deep), deep_pointer);
+    ASSERT_EQ(table.size(), type_count + UINT8_MAX);
+}
+
+TEST_F(TypeCheckerTestSetup, TestAnnotations) {
+    auto declarations = check("char *name(int, char);\n"
+                              "int f(int a, char **p) {\n"
+                              "  char *s = name(a + 'c', *p[a]);\n"
+                              "  void *v = s;\n"
+                              "  s = p[1] - 2;\n"
+                              "  return s - *p;\n"
+                              "}\n");
+    ASSERT_TRUE(checker.diagnostics().empty()) << checker.diagnostics()[0].m_message;
+    TypeTable &types = checker.types();
+    TypeId char_pointer = types.pointer_to(TypeTable::CHAR_TYPE);
+
+    auto &body = std::get<Block>(std::get<FuncDeclaration>(declarations[1]->m_members).body->m_members).statements;
+    // char *s = name(a + 'c', *p[a]);
+    ASSERT_EQ(checker.type_of(body[0]), char_pointer);
+    const ASTNode *call = std::get<BinaryOperation>(body[0]->m_members).rhs;
+    ASSERT_EQ(checker.type_of(call), char_pointer);
+    const auto &args = std::get<FuncCall>(call->m_members).arg;
+    ASSERT_EQ(checker.type_of(args[0]), TypeTable::INT_TYPE);
+    ASSERT_EQ(checker.type_of(args[1]), TypeTable::CHAR_TYPE);
+    ASSERT_EQ(checker.type_of(std::get<UnaryOperation>(args[1]->m_members).operand), char_pointer);
+    // void *v = s;
+    ASSERT_EQ(checker.type_of(body[1]), types.pointer_to(TypeTable::VOID_TYPE));
+    // s = p[1] - 2;
+    ASSERT_EQ(checker.type_of(std::get<BinaryOperation>(body[2]->m_members).rhs), char_pointer);
+    // return s - *p;
+    ASSERT_EQ(checker.type_of(std::get<ReturnStatement>(body[3]->m_members).value), TypeTable::INT_TYPE);
+
+    ASSERT_EQ(checker.type_of(declarations[0]),
+              types.function(char_pointer, std::vector<TypeId>{TypeTable::INT_TYPE, TypeTable::CHAR_TYPE}));
+}
+
+TEST_F(TypeCheckerTestSetup, TestErrors) {
+    check("int f(int a, char *s);\n"
+          "char f(int a, char *s);\n"
+          "void g(void) { return 1; }\n"
+          "int h(int **p) {\n"
+          "  void x;\n"
+          "  char *s = p;\n"
+          "  int n = s;\n"
+          "  s = 0;\n"
+          "  s = 1;\n"
+          "  f(1);\n"
+          "  f(s, s);\n"
+          "  n();\n"
+          "  n = s * 2 + n;\n"
+          "  n = -s;\n"
+          "  if (g()) return;\n"
+          "  return *p;\n"
+          "}\n");
+    ASSERT_EQ(messages(checker.diagnostics()), (std::vector<std::string>{
+            std::string(CONFLICTING_TYPES) + "f: 'int (int, char *)' and 'char (int, char *)'",
+            VOID_RETURN_VALUE,
+            std::string(VOID_VARIABLE) + "x",
+            std::string(INCOMPATIBLE_ASSIGNMENT) + "'int **' to 'char *'",
+            std::string(INCOMPATIBLE_ASSIGNMENT) + "'char *' to 'int'",
+            std::string(INCOMPATIBLE_ASSIGNMENT) + "'int' to 'char *'",
+            std::string(ARGUMENT_COUNT) + "f: expected 2, got 1",
+            std::string(INCOMPATIBLE_ARGUMENT) + "f 1: 'char *' to 'int'",
+            std::string(NOT_A_FUNCTION) + "n",
+            std::string(INVALID_OPERANDS) + "*: 'char *' and 'int'",
+            std::string(INVALID_OPERAND) + "-: 'char *'",
+            std::string(NON_SCALAR_CONDITION) + "'void'",
+            MISSING_RETURN_VALUE,
+            std::string(INCOMPATIBLE_RETURN) + "'int *' to 'int'",
+    }));
+    // at the declaration, operator, call, argument or value the error is about
+    ASSERT_EQ(locations(checker.diagnostics()), (std::vector<SourceLocation>{
+            {2, 6}, {3, 23}, {5, 8}, {6, 11}, {7, 9}, {9, 5}, {10, 3}, {11, 5}, {12, 3}, {13, 9}, {14, 7}, {15, 7},
+            {15, 12}, {16, 10},
+    }));
+}
+
+TEST_F(TypeCheckerTestSetup, TestHelloWorld) {
+    auto source = SourceBuffer::from_file(CODE_FILE);
+    check(std::string(source->view()));
+    ASSERT_TRUE(checker.diagnostics().empty()) << checker.diagnostics()[0].m_message;
+}
+
+TEST_F(TypeCheckerTestSetup, TestCheckingAgain) {
+    // a second checker types the tree in its own table instead of reading the first one's
+    auto declarations = check("int f(int a);\n"
+                              "char f(int a);\n"
+                              "int g(char ***p) { return f(***p); }\n");
+    std::vector<std::string> conflict{std::string(CONFLICTING_TYPES) + "f: 'int (int)' and 'char (int)'"};
+    ASSERT_EQ(messages(checker.diagnostics()), conflict);
+
+    TypeChecker again(resolver);
+    // types already in its table shift the ids it hands out away from the first checker's
+    again.types().pointer_to(again.types().pointer_to(TypeTable::INT_TYPE));
+    again.check(declarations);
+    ASSERT_EQ(again.diagnostics().size(), 1);
+    ASSERT_EQ(again.diagnostics()[0].m_message, conflict[0]);
+    ASSERT_NE(again.type_of(declarations[2]), checker.type_of(declarations[2]));
+    ASSERT_EQ(again.types().to_string(again.type_of(declarations[2])), "int (char ***)");
+    ASSERT_EQ(checker.types().to_string(checker.type_of(declarations[2])), "int (char ***)");
+}